@@ -0,0 +1,310 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "alloc_counter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <mutex>
+#include <new>
+#include "slab_pool.hpp"
+#include "thread.hpp"
+
+// Replaces the global allocation functions with thin malloc() wrappers
+// that count every allocation and the bytes in use. This is cheap enough
+// to stay enabled in release builds and works the same way on the Wii
+// and on a host build.
+
+static std::atomic<uint32_t> allocations { 0 };
+static std::atomic<size_t> liveBytes { 0 };
+// Innermost AllocScope of every thread that has created one. A thread
+// gets a slot with its first scope and keeps it, and only that thread
+// reads or changes the scope pointer of its slot.
+static constexpr uint32_t maxScopeThreads = 8;
+static ThreadId scopeThreads[maxScopeThreads];
+static AllocScope *threadScopes[maxScopeThreads];
+static std::atomic<uint32_t> scopeThreadCount { 0 };
+static std::atomic<uint32_t> activeScopes { 0 };
+static Mutex scopeMutex;
+static SlabPool slabs;
+static std::atomic<bool> slabScopeActive { false };
+// The thread that reserved the slabs, the only one that allocates from
+// them. Blocks deleted on other threads wait in remoteFrees until it
+// allocates again.
+static ThreadId slabOwner;
+static Mutex remoteMutex;
+static void *remoteFrees = NULL;
+static std::atomic<bool> hasRemoteFrees { false };
+
+uint32_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+size_t liveHeapBytes() {
+    return liveBytes.load(std::memory_order_relaxed);
+}
+
+static uint32_t findScopeSlot(ThreadId self) {
+    uint32_t count = scopeThreadCount.load(std::memory_order_acquire);
+    for (uint32_t i=0; i<count; ++i) {
+        if (scopeThreads[i] == self) {
+            return i;
+        }
+    }
+    return maxScopeThreads;
+}
+
+AllocScope::AllocScope(): m_bytes(0), m_previous(NULL) {
+    ThreadId self = currentThreadId();
+    m_slot = findScopeSlot(self);
+    if (m_slot == maxScopeThreads) {
+        std::lock_guard<Mutex> lock { scopeMutex };
+        uint32_t count = scopeThreadCount.load(std::memory_order_relaxed);
+        if (count < maxScopeThreads) {
+            scopeThreads[count] = self;
+            m_slot = count;
+            scopeThreadCount.store(count + 1, std::memory_order_release);
+        }
+    }
+    if (m_slot != maxScopeThreads) {
+        m_previous = threadScopes[m_slot];
+        threadScopes[m_slot] = this;
+        activeScopes.fetch_add(1, std::memory_order_release);
+    }
+}
+
+AllocScope::~AllocScope() {
+    if (m_slot != maxScopeThreads) {
+        threadScopes[m_slot] = m_previous;
+        if (m_previous != NULL) {
+            m_previous->m_bytes += m_bytes;
+        }
+        activeScopes.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void countScopeBytes(long size) {
+    uint32_t slot = findScopeSlot(currentThreadId());
+    if (slot != maxScopeThreads && threadScopes[slot] != NULL) {
+        threadScopes[slot]->m_bytes += size;
+    }
+}
+
+bool initInstanceSlabs(size_t capacity) {
+    slabOwner = currentThreadId();
+    return slabs.init(capacity);
+}
+
+SlabPool const& instanceSlabs() {
+    return slabs;
+}
+
+SlabScope::SlabScope(bool enabled): m_previous(false) {
+    m_owner = currentThreadId() == slabOwner;
+    if (m_owner) {
+        m_previous = slabScopeActive.load(std::memory_order_relaxed);
+        slabScopeActive.store(enabled, std::memory_order_release);
+    }
+}
+
+SlabScope::~SlabScope() {
+    if (m_owner) {
+        slabScopeActive.store(m_previous, std::memory_order_release);
+    }
+}
+
+static void releaseRemoteFrees() {
+    void *list;
+    {
+        std::lock_guard<Mutex> lock { remoteMutex };
+        list = remoteFrees;
+        remoteFrees = NULL;
+        hasRemoteFrees.store(false, std::memory_order_relaxed);
+    }
+    while (list != NULL) {
+        void *next = *(void **)list;
+        slabs.release(list);
+        list = next;
+    }
+}
+
+static void countBytes(long size) {
+    if (size > 0) {
+        liveBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    else {
+        liveBytes.fetch_sub(-size, std::memory_order_relaxed);
+    }
+    if (activeScopes.load(std::memory_order_acquire) != 0) {
+        countScopeBytes(size);
+    }
+}
+
+static void *countedAlloc(std::size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (slabScopeActive.load(std::memory_order_acquire) &&
+        currentThreadId() == slabOwner)
+    {
+        if (hasRemoteFrees.load(std::memory_order_acquire)) {
+            releaseRemoteFrees();
+        }
+        void *ptr = slabs.allocate(size);
+        if (ptr != nullptr) {
+            countBytes(slabs.blockSize(ptr));
+            return ptr;
+        }
+    }
+    void *ptr = std::malloc(size);
+    if (ptr != nullptr) {
+        countBytes(malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+// Over-aligned types never come from the slabs
+static void *countedAlignedAlloc(std::size_t size, std::align_val_t align) {
+    if (size == 0) {
+        size = 1;
+    }
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = memalign((std::size_t)align, size);
+    if (ptr != nullptr) {
+        countBytes(malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+static void countedFree(void *ptr) {
+    if (slabs.owns(ptr)) {
+        countBytes(-(long)slabs.blockSize(ptr));
+        if (currentThreadId() == slabOwner) {
+            slabs.release(ptr);
+        }
+        else {
+            // the pool is not thread safe, the owner releases it later
+            std::lock_guard<Mutex> lock { remoteMutex };
+            *(void **)ptr = remoteFrees;
+            remoteFrees = ptr;
+            hasRemoteFrees.store(true, std::memory_order_release);
+        }
+        return;
+    }
+    if (ptr != nullptr) {
+        countBytes(-(long)malloc_usable_size(ptr));
+    }
+    std::free(ptr);
+}
+
+void *operator new(std::size_t size) {
+    void *ptr = countedAlloc(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, std::nothrow_t const&) noexcept {
+    return countedAlloc(size);
+}
+
+void *operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+    return countedAlloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete(void *ptr, std::nothrow_t const&) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::nothrow_t const&) noexcept {
+    countedFree(ptr);
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+    void *ptr = countedAlignedAlloc(size, align);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+void *operator new(std::size_t size, std::align_val_t align,
+    std::nothrow_t const&) noexcept
+{
+    return countedAlignedAlloc(size, align);
+}
+
+void *operator new[](std::size_t size, std::align_val_t align,
+    std::nothrow_t const&) noexcept
+{
+    return countedAlignedAlloc(size, align);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    countedFree(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t,
+    std::nothrow_t const&) noexcept
+{
+    countedFree(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t,
+    std::nothrow_t const&) noexcept
+{
+    countedFree(ptr);
+}
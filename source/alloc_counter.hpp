@@ -0,0 +1,73 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Number of heap allocations made through operator new since boot.
+// Sample it once per frame to get the allocations made by that frame.
+uint32_t allocationCount();
+
+// Bytes currently allocated through operator new, as reported by
+// malloc_usable_size() so it includes the allocator's rounding.
+size_t liveHeapBytes();
+
+// Net bytes allocated through operator new by the thread that created
+// the scope while it is alive. Every thread can have its own scope, and
+// scopes nest: the bytes of an inner scope also count towards the one
+// it is nested in. Scopes of more than eight threads are not counted.
+class AllocScope {
+public:
+    AllocScope();
+    ~AllocScope();
+    AllocScope(const AllocScope &) = delete;
+    AllocScope &operator=(const AllocScope &) = delete;
+    long bytes() const {
+        return m_bytes;
+    }
+private:
+    friend void countScopeBytes(long size);
+    long m_bytes;
+    AllocScope *m_previous;
+    uint32_t m_slot;
+};
+
+class SlabPool;
+
+// Pool for the per-instance objects of mascots, reserved by
+// initInstanceSlabs() on the thread that will use it. While an enabled
+// SlabScope is alive on that thread, its operator new calls are served
+// from the pool when they fit. Scopes on other threads do nothing.
+// Scopes nest: one that ends puts back the state it found, so a
+// disabled scope inside an enabled one only pauses the pool.
+// Blocks deleted on other threads are handed back to the pool by its
+// thread on its next allocation.
+bool initInstanceSlabs(size_t capacity);
+SlabPool const& instanceSlabs();
+
+class SlabScope {
+public:
+    explicit SlabScope(bool enabled = true);
+    ~SlabScope();
+    SlabScope(const SlabScope &) = delete;
+    SlabScope &operator=(const SlabScope &) = delete;
+private:
+    bool m_owner;
+    bool m_previous;
+};
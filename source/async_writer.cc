@@ -0,0 +1,110 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "async_writer.hpp"
+#include <algorithm>
+#include <mutex>
+
+bool AsyncFileWriter::open(const char *path, const char *mode,
+    size_t bufferSize)
+{
+    if (m_file != NULL) {
+        return false;
+    }
+    m_file = fopen(path, mode);
+    if (m_file == NULL) {
+        return false;
+    }
+    m_front.clear();
+    m_back.clear();
+    m_front.reserve(bufferSize);
+    m_back.reserve(bufferSize);
+    m_stop = false;
+    if (!m_thread.start(threadMain, this, Thread::lowPriority)) {
+        fclose(m_file);
+        m_file = NULL;
+        return false;
+    }
+    return true;
+}
+
+void AsyncFileWriter::write(const void *data, size_t size) {
+    if (m_file == NULL) {
+        return;
+    }
+    auto bytes = (const char *)data;
+    std::lock_guard<Mutex> lock { m_mutex };
+    while (size > 0) {
+        size_t space = m_front.capacity() - m_front.size();
+        if (space == 0) {
+            // full, wait for the writer thread to take the buffer
+            m_wake.signal();
+            m_drained.wait(m_mutex);
+            continue;
+        }
+        size_t count = std::min(space, size);
+        m_front.insert(m_front.end(), bytes, bytes + count);
+        bytes += count;
+        size -= count;
+    }
+    if (m_front.size() >= m_front.capacity() / 2) {
+        m_wake.signal();
+    }
+}
+
+void AsyncFileWriter::close() {
+    if (m_file == NULL) {
+        return;
+    }
+    {
+        std::lock_guard<Mutex> lock { m_mutex };
+        m_stop = true;
+        m_wake.signal();
+    }
+    m_thread.join();
+    fclose(m_file);
+    m_file = NULL;
+}
+
+void *AsyncFileWriter::threadMain(void *self) {
+    ((AsyncFileWriter *)self)->run();
+    return NULL;
+}
+
+void AsyncFileWriter::run() {
+    m_mutex.lock();
+    while (true) {
+        if (m_front.empty() && !m_stop) {
+            m_wake.waitFor(m_mutex, 1000);
+        }
+        if (!m_front.empty()) {
+            // both buffers keep their capacity across swaps
+            m_front.swap(m_back);
+            m_drained.broadcast();
+            m_mutex.unlock();
+            fwrite(&m_back[0], 1, m_back.size(), m_file);
+            fflush(m_file);
+            m_back.clear();
+            m_mutex.lock();
+        }
+        else if (m_stop) {
+            break;
+        }
+    }
+    m_mutex.unlock();
+}
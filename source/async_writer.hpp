@@ -0,0 +1,55 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <cstdio>
+#include <vector>
+#include "thread.hpp"
+
+// Appends to a file from a background thread. write() only copies into
+// an in-memory buffer, and the thread writes it out in batches when it
+// fills up or at least once a second, so slow SD writes never stall the
+// caller unless the buffer is full.
+class AsyncFileWriter {
+public:
+    AsyncFileWriter(): m_file(NULL), m_stop(false) {}
+    AsyncFileWriter(const AsyncFileWriter &) = delete;
+    AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+    ~AsyncFileWriter() {
+        close();
+    }
+    bool open(const char *path, const char *mode,
+        size_t bufferSize = 32 * 1024);
+    bool isOpen() const {
+        return m_file != NULL;
+    }
+    void write(const void *data, size_t size);
+    // writes out everything buffered so far and stops the thread
+    void close();
+private:
+    static void *threadMain(void *self);
+    void run();
+    FILE *m_file;
+    std::vector<char> m_front;
+    std::vector<char> m_back;
+    bool m_stop;
+    Mutex m_mutex;
+    CondVar m_wake;
+    CondVar m_drained;
+    Thread m_thread;
+};
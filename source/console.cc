@@ -0,0 +1,148 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "console.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+void ConsoleBuffer::resize(int rows) {
+    if (rows < 1) {
+        rows = 1;
+    }
+    std::lock_guard<Mutex> guard { m_mutex };
+    m_rows = rows;
+    m_text.assign(rows * (columns + 1), '\0');
+    m_first = 0;
+    m_count = 0;
+    m_open = false;
+    m_column = 0;
+    m_dirty = true;
+}
+
+void ConsoleBuffer::clear() {
+    std::lock_guard<Mutex> guard { m_mutex };
+    std::fill(m_text.begin(), m_text.end(), '\0');
+    m_first = 0;
+    m_count = 0;
+    m_open = false;
+    m_column = 0;
+    m_dirty = true;
+}
+
+void ConsoleBuffer::write(const char *text, size_t size) {
+    std::lock_guard<Mutex> guard { m_mutex };
+    for (size_t i=0; i<size; ++i) {
+        put(text[i]);
+    }
+    if (m_sink != NULL) {
+        m_sink->write(text, size);
+    }
+}
+
+void ConsoleBuffer::newLine() {
+    int row;
+    if (m_count == m_rows) {
+        // full, overwrite the oldest line
+        row = m_first;
+        m_first = (m_first + 1) % m_rows;
+    }
+    else {
+        row = (m_first + m_count) % m_rows;
+        ++m_count;
+    }
+    std::memset(slot(row), 0, columns + 1);
+    m_open = true;
+    m_column = 0;
+}
+
+void ConsoleBuffer::put(char c) {
+    if (m_rows == 0) {
+        return;
+    }
+    m_dirty = true;
+    if (c == '\n') {
+        if (!m_open) {
+            newLine();
+        }
+        m_open = false;
+        return;
+    }
+    if (!m_open || m_column == columns) {
+        // long lines wrap instead of running off the screen
+        newLine();
+    }
+    int row = (m_first + m_count - 1) % m_rows;
+    slot(row)[m_column++] = c;
+}
+
+ConsoleWriter::int_type ConsoleWriter::overflow(int_type ch) {
+    // Characters from put() only come here once the buffer is full.
+    // Hand over the lines it completes and keep the one in progress,
+    // unless it fills the whole buffer.
+    char *end = pptr();
+    while (end != pbase() && end[-1] != '\n') {
+        --end;
+    }
+    if (end == pbase()) {
+        sync();
+    }
+    else {
+        size_t rest = pptr() - end;
+        m_console.write(pbase(), end - pbase());
+        std::memmove(m_line, end, rest);
+        setp(m_line, m_line + sizeof(m_line));
+        pbump((int)rest);
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize ConsoleWriter::xsputn(const char *s, std::streamsize n) {
+    std::streamsize done = 0;
+    while (done < n) {
+        if (pptr() == epptr()) {
+            sync();
+        }
+        std::streamsize count = std::min<std::streamsize>(n - done,
+            epptr() - pptr());
+        const char *newline = (const char *)std::memchr(s + done, '\n',
+            count);
+        if (newline != NULL) {
+            count = newline - (s + done) + 1;
+        }
+        std::memcpy(pptr(), s + done, count);
+        pbump((int)count);
+        done += count;
+        if (newline != NULL) {
+            sync();
+        }
+    }
+    return n;
+}
+
+int ConsoleWriter::sync() {
+    if (pptr() != pbase()) {
+        m_console.write(pbase(), pptr() - pbase());
+        setp(m_line, m_line + sizeof(m_line));
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <mutex>
+#include <streambuf>
+#include <vector>
+#include "async_writer.hpp"
+#include "thread.hpp"
+
+// Fixed-capacity ring of fixed-width text lines. All memory is
+// allocated in resize(), so logging never builds strings. Writes are
+// serialized with an internal lock; readers of line() must hold the
+// lock as well.
+class ConsoleBuffer {
+public:
+    static constexpr int columns = 80;
+    ConsoleBuffer(): m_rows(0), m_first(0), m_count(0), m_open(false),
+        m_column(0), m_dirty(false), m_sink(NULL) {}
+    void resize(int rows);
+    void clear();
+    void write(const char *text, size_t size);
+    // everything written to the console is also passed on to sink
+    void setSink(AsyncFileWriter *sink) {
+        std::lock_guard<Mutex> guard { m_mutex };
+        m_sink = sink;
+    }
+    void lock() {
+        m_mutex.lock();
+    }
+    void unlock() {
+        m_mutex.unlock();
+    }
+    int rows() const {
+        return m_rows;
+    }
+    // number of lines that currently hold text, at most rows()
+    int lineCount() const {
+        return m_count;
+    }
+    // i-th line, oldest first, NUL-terminated
+    const char *line(int i) const {
+        return &m_text[((m_first + i) % m_rows) * (columns + 1)];
+    }
+    // returns true once after every change to the contents
+    bool takeDirty() {
+        bool dirty = m_dirty;
+        m_dirty = false;
+        return dirty;
+    }
+private:
+    char *slot(int row) {
+        return &m_text[row * (columns + 1)];
+    }
+    void newLine();
+    void put(char c);
+    std::vector<char> m_text;
+    int m_rows;
+    int m_first;
+    int m_count;
+    bool m_open;
+    int m_column;
+    bool m_dirty;
+    AsyncFileWriter *m_sink;
+    Mutex m_mutex;
+};
+
+// streambuf for cout/cerr. Each thread writes through its own
+// ConsoleWriter, which collects a line in a fixed buffer and hands it
+// to the ConsoleBuffer in one piece so that lines from different
+// threads do not interleave.
+class ConsoleWriter : public std::streambuf {
+public:
+    ConsoleWriter(ConsoleBuffer &console): m_console(console) {
+        setp(m_line, m_line + sizeof(m_line));
+    }
+protected:
+    virtual int_type overflow(int_type ch);
+    virtual std::streamsize xsputn(const char *s, std::streamsize n);
+    virtual int sync();
+private:
+    ConsoleBuffer &m_console;
+    char m_line[128];
+};
@@ -0,0 +1,98 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "display_list.hpp"
+#include <cstring>
+
+// GX commands are big endian, like the Wii itself
+
+void DisplayListWriter::u8(uint8_t value) {
+    if (m_size + 1 > m_capacity) {
+        m_overflow = true;
+        return;
+    }
+    m_buffer[m_size++] = value;
+}
+
+void DisplayListWriter::u16(uint16_t value) {
+    u8(value >> 8);
+    u8(value & 0xFF);
+}
+
+void DisplayListWriter::u32(uint32_t value) {
+    u16(value >> 16);
+    u16(value & 0xFFFF);
+}
+
+void DisplayListWriter::f32(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    u32(bits);
+}
+
+void DisplayListWriter::begin(uint8_t primitive, uint8_t vtxfmt,
+    uint16_t vertexCount)
+{
+    u8(primitive | (vtxfmt & 7));
+    u16(vertexCount);
+}
+
+void DisplayListWriter::position(float x, float y, float z) {
+    f32(x);
+    f32(y);
+    f32(z);
+}
+
+void DisplayListWriter::color(uint32_t rgba) {
+    u32(rgba);
+}
+
+void DisplayListWriter::texCoord(float s, float t) {
+    f32(s);
+    f32(t);
+}
+
+size_t DisplayListWriter::finish() {
+    while (m_size % 32 != 0 && !m_overflow) {
+        // GX_NOP
+        u8(0);
+    }
+    return m_overflow ? 0 : m_size;
+}
+
+size_t writeSpriteQuad(uint8_t *buffer, size_t capacity,
+    SpriteQuad const& quad, bool flipX, uint32_t color)
+{
+    float left = flipX ? quad.s2 : quad.s1;
+    float right = flipX ? quad.s1 : quad.s2;
+    DisplayListWriter writer { buffer, capacity };
+    writer.begin(DisplayListWriter::quads, DisplayListWriter::vtxfmt0, 4);
+    writer.position(0, 0, 0);
+    writer.color(color);
+    writer.texCoord(left, quad.t1);
+    writer.position(quad.width, 0, 0);
+    writer.color(color);
+    writer.texCoord(right, quad.t1);
+    writer.position(quad.width, quad.height, 0);
+    writer.color(color);
+    writer.texCoord(right, quad.t2);
+    writer.position(0, quad.height, 0);
+    writer.color(color);
+    writer.texCoord(left, quad.t2);
+    return writer.finish();
+}
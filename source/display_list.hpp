@@ -0,0 +1,71 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Writes GX command stream bytes into a caller-provided buffer. This
+// only produces the bytes GX_Begin() and friends would write to the
+// FIFO, so it can run on any thread and be checked on the host. The
+// buffer has to be 32-byte aligned and flushed from the data cache
+// before it is passed to GX_CallDispList().
+class DisplayListWriter {
+public:
+    // GX_QUADS and GX_VTXFMT0 as defined by libogc
+    static constexpr uint8_t quads = 0x80;
+    static constexpr uint8_t vtxfmt0 = 0;
+    DisplayListWriter(uint8_t *buffer, size_t capacity):
+        m_buffer(buffer), m_capacity(capacity), m_size(0),
+        m_overflow(false) {}
+    void begin(uint8_t primitive, uint8_t vtxfmt, uint16_t vertexCount);
+    void position(float x, float y, float z);
+    void color(uint32_t rgba);
+    void texCoord(float s, float t);
+    // Pads the list with GX_NOP up to a multiple of 32 bytes and returns
+    // its size, or 0 if it did not fit in the buffer.
+    size_t finish();
+    size_t size() const {
+        return m_size;
+    }
+private:
+    void u8(uint8_t value);
+    void u16(uint16_t value);
+    void u32(uint32_t value);
+    void f32(float value);
+    uint8_t *m_buffer;
+    size_t m_capacity;
+    size_t m_size;
+    bool m_overflow;
+};
+
+// One textured quad in the vertex format GRRLIB sets up for
+// GX_VTXFMT0 (f32 xyz position, rgba8 color, f32 st texture coordinate)
+// with its top left corner at the origin, so that it can be placed with
+// the position matrix.
+struct SpriteQuad {
+    float width, height;
+    float s1, t1, s2, t2;
+};
+
+// 3 byte header and 4 vertices of 24 bytes, padded to 32 bytes
+static constexpr size_t spriteQuadListSize = 128;
+
+// Writes the list for quad, mirrored horizontally if flipX is set.
+// Returns the list size, or 0 if capacity is too small.
+size_t writeSpriteQuad(uint8_t *buffer, size_t capacity,
+    SpriteQuad const& quad, bool flipX, uint32_t color);
@@ -0,0 +1,158 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "file_pipeline.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <mutex>
+
+FilePipeline::FilePipeline(size_t slotCount): m_current(-1), m_cancel(false),
+    m_synchronous(false)
+{
+    m_slots.resize(std::max<size_t>(slotCount, 2), { NULL, 0, 0, false, false });
+}
+
+FilePipeline::~FilePipeline() {
+    stop();
+    for (auto &slot : m_slots) {
+        free(slot.data);
+    }
+}
+
+void FilePipeline::stop() {
+    {
+        std::lock_guard<Mutex> lock { m_mutex };
+        m_cancel = true;
+        m_space.broadcast();
+    }
+    m_thread.join();
+    m_cancel = false;
+    for (auto &slot : m_slots) {
+        slot.full = false;
+    }
+}
+
+bool FilePipeline::start(std::vector<std::filesystem::path> const& paths) {
+    // the previous list may not have been read to the end
+    stop();
+    m_paths = paths;
+    m_current = -1;
+    m_synchronous = false;
+    if (m_paths.empty()) {
+        return true;
+    }
+    // the reader runs above the decoding thread so that the next read
+    // is issued as soon as a buffer frees up
+    if (!m_thread.start(threadMain, this, Thread::lowPriority + 1,
+        32 * 1024))
+    {
+        m_synchronous = true;
+        return false;
+    }
+    return true;
+}
+
+bool FilePipeline::next(File &file) {
+    std::lock_guard<Mutex> lock { m_mutex };
+    if (m_current >= 0) {
+        m_slots[m_current % m_slots.size()].full = false;
+        m_space.broadcast();
+    }
+    if (m_current + 1 >= (long)m_paths.size()) {
+        return false;
+    }
+    ++m_current;
+    auto &slot = m_slots[m_current % m_slots.size()];
+    if (m_synchronous) {
+        slot.ok = read(m_paths[m_current], slot);
+        slot.full = true;
+    }
+    while (!slot.full) {
+        m_ready.wait(m_mutex);
+    }
+    file.data = slot.ok ? slot.data : NULL;
+    file.size = slot.ok ? slot.size : 0;
+    file.ok = slot.ok;
+    return true;
+}
+
+void *FilePipeline::threadMain(void *self) {
+    ((FilePipeline *)self)->run();
+    return NULL;
+}
+
+void FilePipeline::run() {
+    for (size_t i=0; i<m_paths.size(); ++i) {
+        auto &slot = m_slots[i % m_slots.size()];
+        {
+            std::lock_guard<Mutex> lock { m_mutex };
+            while (slot.full && !m_cancel) {
+                m_space.wait(m_mutex);
+            }
+            if (m_cancel) {
+                return;
+            }
+        }
+        // the slot is not full, so the consumer does not look at it
+        bool ok = read(m_paths[i], slot);
+        std::lock_guard<Mutex> lock { m_mutex };
+        slot.ok = ok;
+        slot.full = true;
+        m_ready.broadcast();
+    }
+}
+
+bool FilePipeline::read(std::filesystem::path const& path, Slot &slot) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == NULL) {
+        return false;
+    }
+    // reads go straight into the aligned buffer instead of through
+    // stdio's small buffer, which lets libfat read whole sectors
+    setvbuf(f, NULL, _IONBF, 0);
+    bool ok = false;
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0) {
+        size = ftell(f);
+    }
+    if (size >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        if ((size_t)size > slot.capacity) {
+            size_t capacity = ((size + blockSize - 1) / blockSize) * blockSize;
+            free(slot.data);
+            slot.data = (uint8_t *)memalign(32, capacity);
+            slot.capacity = (slot.data != NULL) ? capacity : 0;
+        }
+        if (slot.data != NULL) {
+            size_t done = 0;
+            while (done < (size_t)size) {
+                size_t count = std::min(blockSize, (size_t)size - done);
+                size_t read = fread(slot.data + done, 1, count, f);
+                done += read;
+                if (read != count) {
+                    break;
+                }
+            }
+            ok = (done == (size_t)size);
+            slot.size = done;
+        }
+    }
+    fclose(f);
+    return ok;
+}
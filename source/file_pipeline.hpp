@@ -0,0 +1,71 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include "thread.hpp"
+
+// Reads a list of files on a separate thread so that reading the next
+// files from SD overlaps with decoding the current one. Files are read
+// into a small ring of reusable 32-byte aligned buffers in large
+// unbuffered blocks, and are handed out in list order. A pipeline can
+// be started again with another list and keeps its buffers. If the
+// reader thread can't be started, next() reads every file itself.
+class FilePipeline {
+public:
+    struct File {
+        const uint8_t *data;
+        size_t size;
+        bool ok;
+    };
+    static constexpr size_t blockSize = 256 * 1024;
+    FilePipeline(size_t slotCount = 3);
+    FilePipeline(const FilePipeline &) = delete;
+    FilePipeline &operator=(const FilePipeline &) = delete;
+    ~FilePipeline();
+    // Returns false if the files will be read without the reader thread
+    bool start(std::vector<std::filesystem::path> const& paths);
+    // Waits for the next file. Its data stays valid until the next call,
+    // which also gives the buffer back to the reader. Returns false
+    // after the last file.
+    bool next(File &file);
+private:
+    struct Slot {
+        uint8_t *data;
+        size_t capacity;
+        size_t size;
+        bool full;
+        bool ok;
+    };
+    void stop();
+    static void *threadMain(void *self);
+    void run();
+    bool read(std::filesystem::path const& path, Slot &slot);
+    std::vector<std::filesystem::path> m_paths;
+    std::vector<Slot> m_slots;
+    long m_current;
+    bool m_cancel;
+    bool m_synchronous;
+    Mutex m_mutex;
+    CondVar m_ready;
+    CondVar m_space;
+    Thread m_thread;
+};
@@ -0,0 +1,100 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "idle_scheduler.hpp"
+
+uint32_t IdleScheduler::Entry::estimate(uint32_t expectedCost) const {
+    uint32_t worst = std::max(previousMax, currentMax);
+    if (!expected) {
+        return measuredOnce ? worst : firstEstimateMicros;
+    }
+    uint32_t ratio = measuredOnce ? worst : unitRatio;
+    return (uint32_t)std::min<uint64_t>((uint64_t)expectedCost * ratio /
+        unitRatio, UINT32_MAX);
+}
+
+void IdleScheduler::Entry::measured(uint32_t cost, uint32_t expectedCost) {
+    if (expected) {
+        // a slice that expected nothing says nothing about the others
+        if (expectedCost == 0) {
+            return;
+        }
+        cost = (uint32_t)std::min<uint64_t>((uint64_t)cost * unitRatio /
+            expectedCost, UINT32_MAX);
+    }
+    measuredOnce = true;
+    currentMax = std::max(currentMax, cost);
+    if (++count == windowSlices) {
+        // a slow slice is remembered for a while even if the last
+        // window was fast
+        previousMax = std::max(currentMax, previousMax - previousMax / 8);
+        currentMax = 0;
+        count = 0;
+    }
+}
+
+void IdleScheduler::submit(const char *name, Job job, Estimate expected) {
+    m_jobs.push_back({ name, std::move(job), std::move(expected), 0, 0, 0,
+        false, false });
+}
+
+size_t IdleScheduler::run(uint64_t deadline) {
+    for (auto &entry : m_jobs) {
+        entry.yielded = false;
+    }
+    size_t count = 0;
+    bool ranAny = true;
+    while (ranAny) {
+        ranAny = false;
+        for (size_t i=0; i<m_jobs.size(); ) {
+            auto &entry = m_jobs[i];
+            if (entry.yielded) {
+                ++i;
+                continue;
+            }
+            uint32_t expectedCost = entry.expected ? entry.expected() : 0;
+            uint64_t start = m_clock();
+            if (start + entry.estimate(expectedCost) > deadline) {
+                ++i;
+                continue;
+            }
+            IdleResult result = entry.job();
+            uint64_t end = m_clock();
+            // the submit() of a slice may have moved the entries
+            auto &ran = m_jobs[i];
+            uint32_t cost = (uint32_t)std::min<uint64_t>(end - start,
+                UINT32_MAX);
+            ran.measured(cost, expectedCost);
+            m_busyMicros += cost;
+            ++m_slices;
+            ++count;
+            ranAny = true;
+            if (end > deadline) {
+                ++m_overruns;
+                m_lastOverrun = ran.name;
+            }
+            if (result == IdleResult::Done) {
+                m_jobs.erase(m_jobs.begin() + i);
+                continue;
+            }
+            ran.yielded = result == IdleResult::Yield;
+            ++i;
+        }
+    }
+    return count;
+}
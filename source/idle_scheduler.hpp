@@ -0,0 +1,106 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// What one slice of an idle job asks for next
+enum class IdleResult {
+    // the job is finished and is dropped
+    Done,
+    // more to do, call again if there is time left in this frame
+    Continue,
+    // nothing to do right now, try again next frame
+    Yield
+};
+
+// Cooperative scheduler for work that can wait, run in the part of a
+// frame that would otherwise be spent waiting for vsync. Jobs are split
+// into short slices by the caller. A slice only starts if the longest
+// recent slice of its job still fits before the deadline, so a job
+// whose slices never fit simply waits. A job whose slices vary, like
+// decodes of textures of any size, can pass an Estimate of its next
+// slice instead, which is scaled by how far off recent ones were.
+// Slices that take longer than expected can still overrun, which the
+// margin before vsync has to absorb. Main thread only.
+class IdleScheduler {
+public:
+    using Job = std::function<IdleResult()>;
+    // Microseconds the next slice of a job is expected to take, such as
+    // the decode time of the texture it would decode
+    using Estimate = std::function<uint32_t()>;
+    // slices of a new job without an Estimate are assumed to take this
+    // long until measured
+    static constexpr uint32_t firstEstimateMicros = 1000;
+    // clock returns microseconds
+    explicit IdleScheduler(uint64_t (*clock)()): m_clock(clock) {}
+    IdleScheduler(const IdleScheduler &) = delete;
+    IdleScheduler &operator=(const IdleScheduler &) = delete;
+    // name has to outlive the job
+    void submit(const char *name, Job job, Estimate expected = nullptr);
+    // Runs slices, round robin, until nothing fits before deadline or
+    // every job is done or yielded. Returns the number of slices.
+    size_t run(uint64_t deadline);
+    size_t pending() const {
+        return m_jobs.size();
+    }
+    uint64_t slices() const {
+        return m_slices;
+    }
+    uint64_t busyMicros() const {
+        return m_busyMicros;
+    }
+    // slices that ended after the deadline they were started for
+    uint64_t overruns() const {
+        return m_overruns;
+    }
+    // the job that overran last, or NULL
+    const char *lastOverrun() const {
+        return m_lastOverrun;
+    }
+private:
+    // Slices are measured in windows of this many. The estimate is the
+    // longest slice of the current window, or of the earlier ones with
+    // an eighth taken off per window. Jobs with an Estimate keep the
+    // same of the time a slice took over the time it was expected to
+    // take, in units of 1/unitRatio.
+    static constexpr uint32_t windowSlices = 32;
+    static constexpr uint32_t unitRatio = 1024;
+    struct Entry {
+        const char *name;
+        Job job;
+        Estimate expected;
+        // expectedCost is what expected() returned, for jobs with one
+        uint32_t estimate(uint32_t expectedCost) const;
+        void measured(uint32_t cost, uint32_t expectedCost);
+        uint32_t previousMax;
+        uint32_t currentMax;
+        uint32_t count;
+        bool measuredOnce;
+        bool yielded;
+    };
+    uint64_t (*m_clock)();
+    std::vector<Entry> m_jobs;
+    uint64_t m_slices = 0;
+    uint64_t m_busyMicros = 0;
+    uint64_t m_overruns = 0;
+    const char *m_lastOverrun = NULL;
+};
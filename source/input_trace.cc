@@ -0,0 +1,232 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "input_trace.hpp"
+#include <cstring>
+
+// "SWIT", a version byte, the random seed, the screen size, the tick
+// phase, a flags byte, the mascots that had arrived, then frames
+static const char traceMagic[4] = { 'S', 'W', 'I', 'T' };
+static const uint8_t traceVersion = 4;
+static const size_t headerSize = 17;
+
+enum : uint8_t {
+    HeaderPickerVisible = 1 << 0
+};
+
+enum : uint8_t {
+    FrameIRValid = 1 << 0,
+    FrameMoved = 1 << 1,
+    FrameDown = 1 << 2,
+    FrameHeld = 1 << 3,
+    FrameUp = 1 << 4,
+    FrameRefills = 1 << 5,
+    FrameArrivals = 1 << 6
+};
+
+static size_t putVarint(uint8_t *out, uint32_t value) {
+    size_t size = 0;
+    while (value >= 0x80) {
+        out[size++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    out[size++] = value;
+    return size;
+}
+
+static size_t putU32(uint8_t *out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = (value >> 16) & 0xFF;
+    out[2] = (value >> 8) & 0xFF;
+    out[3] = value & 0xFF;
+    return 4;
+}
+
+static uint32_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bitsFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool InputTraceWriter::open(const char *path, TraceHeader const& header) {
+    if (!m_file.open(path, "wb", 16 * 1024)) {
+        return false;
+    }
+    uint8_t buf[headerSize];
+    memcpy(buf, traceMagic, sizeof(traceMagic));
+    buf[4] = traceVersion;
+    putU32(buf + 5, header.seed);
+    buf[9] = header.width >> 8;
+    buf[10] = header.width & 0xFF;
+    buf[11] = header.height >> 8;
+    buf[12] = header.height & 0xFF;
+    buf[13] = header.tickPhase;
+    buf[14] = header.pickerVisible ? HeaderPickerVisible : 0;
+    buf[15] = header.mascots >> 8;
+    buf[16] = header.mascots & 0xFF;
+    m_file.write(buf, sizeof(buf));
+    m_last = {};
+    m_frames = 0;
+    return true;
+}
+
+void InputTraceWriter::write(InputFrame const& frame, uint32_t stateHash) {
+    if (!m_file.isOpen()) {
+        return;
+    }
+    // flags, 2 coordinates, 3 button masks, the refills, the arrivals
+    // and the hash
+    uint8_t buf[1 + 4 * 2 + 5 * 5 + 4];
+    size_t size = 1;
+    uint8_t flags = frame.irValid ? FrameIRValid : 0;
+    if (frame.irValid && (floatBits(frame.x) != floatBits(m_last.x) ||
+        floatBits(frame.y) != floatBits(m_last.y)))
+    {
+        flags |= FrameMoved;
+        size += putU32(buf + size, floatBits(frame.x));
+        size += putU32(buf + size, floatBits(frame.y));
+        m_last.x = frame.x;
+        m_last.y = frame.y;
+    }
+    if (frame.down != m_last.down) {
+        flags |= FrameDown;
+        size += putVarint(buf + size, frame.down);
+    }
+    if (frame.held != m_last.held) {
+        flags |= FrameHeld;
+        size += putVarint(buf + size, frame.held);
+    }
+    if (frame.up != m_last.up) {
+        flags |= FrameUp;
+        size += putVarint(buf + size, frame.up);
+    }
+    // not changes from the previous frame, they are mostly 0
+    if (frame.refills != 0) {
+        flags |= FrameRefills;
+        size += putVarint(buf + size, frame.refills);
+    }
+    if (frame.arrivals != 0) {
+        flags |= FrameArrivals;
+        size += putVarint(buf + size, frame.arrivals);
+    }
+    size += putU32(buf + size, stateHash);
+    buf[0] = flags;
+    m_file.write(buf, size);
+    m_last.irValid = frame.irValid;
+    m_last.down = frame.down;
+    m_last.held = frame.held;
+    m_last.up = frame.up;
+    ++m_frames;
+}
+
+void InputTraceWriter::close() {
+    m_file.close();
+}
+
+bool InputTraceReader::open(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    m_data.clear();
+    uint8_t buf[4096];
+    size_t size;
+    while ((size = fread(buf, 1, sizeof(buf), file)) > 0) {
+        m_data.insert(m_data.end(), buf, buf + size);
+    }
+    fclose(file);
+    if (m_data.size() < headerSize ||
+        memcmp(m_data.data(), traceMagic, sizeof(traceMagic)) != 0 ||
+        m_data[4] != traceVersion)
+    {
+        return false;
+    }
+    m_pos = 5;
+    u32(m_header.seed);
+    m_header.width = (m_data[9] << 8) | m_data[10];
+    m_header.height = (m_data[11] << 8) | m_data[12];
+    m_header.tickPhase = m_data[13];
+    m_header.pickerVisible = (m_data[14] & HeaderPickerVisible) != 0;
+    m_header.mascots = (m_data[15] << 8) | m_data[16];
+    m_pos = headerSize;
+    m_last = {};
+    m_frames = 0;
+    return true;
+}
+
+bool InputTraceReader::varint(uint32_t &value) {
+    value = 0;
+    for (int shift=0; shift<35; shift+=7) {
+        if (m_pos >= m_data.size()) {
+            return false;
+        }
+        uint8_t byte = m_data[m_pos++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InputTraceReader::u32(uint32_t &value) {
+    if (m_pos + 4 > m_data.size()) {
+        return false;
+    }
+    auto bytes = &m_data[m_pos];
+    value = ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) |
+        ((uint32_t)bytes[2] << 8) | bytes[3];
+    m_pos += 4;
+    return true;
+}
+
+bool InputTraceReader::next(InputFrame &frame, uint32_t &stateHash) {
+    if (m_pos >= m_data.size()) {
+        return false;
+    }
+    uint8_t flags = m_data[m_pos++];
+    m_last.irValid = (flags & FrameIRValid) != 0;
+    if (flags & FrameMoved) {
+        uint32_t x, y;
+        if (!u32(x) || !u32(y)) {
+            return false;
+        }
+        m_last.x = bitsFloat(x);
+        m_last.y = bitsFloat(y);
+    }
+    m_last.refills = 0;
+    m_last.arrivals = 0;
+    if (((flags & FrameDown) && !varint(m_last.down)) ||
+        ((flags & FrameHeld) && !varint(m_last.held)) ||
+        ((flags & FrameUp) && !varint(m_last.up)) ||
+        ((flags & FrameRefills) && !varint(m_last.refills)) ||
+        ((flags & FrameArrivals) && !varint(m_last.arrivals)) ||
+        !u32(stateHash))
+    {
+        return false;
+    }
+    frame = m_last;
+    ++m_frames;
+    return true;
+}
@@ -0,0 +1,102 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "async_writer.hpp"
+
+// Input trace of a session, so that it can be fed back into the tick
+// loop later. Each frame is a flags byte telling which fields changed
+// since the previous frame, only those fields, and a hash of the
+// simulation state after the frame so that a replay can tell where it
+// stopped matching the recording. Work whose timing depends on the
+// frame rate or the SD card, like building spare mascots in idle time
+// or mascots arriving from the loader, is recorded with the frame it
+// came before, so that a replay does it at the same point of the
+// simulation.
+struct InputFrame {
+    bool irValid;
+    float x, y;
+    uint32_t down, held, up;
+    // spare mascots built since the previous frame, see PrototypePool
+    uint32_t refills;
+    // mascots taken from the loader in this frame
+    uint32_t arrivals;
+};
+
+// What the simulation depends on besides the input and the scene: the
+// random seed, the screen size, the position in the NTSC cycle that
+// skips every 6th tick, whether the picker was open when the trace
+// started, and how many mascots had arrived from the loader by then.
+struct TraceHeader {
+    uint32_t seed;
+    uint16_t width, height;
+    uint8_t tickPhase;
+    bool pickerVisible;
+    uint16_t mascots;
+};
+
+class InputTraceWriter {
+public:
+    InputTraceWriter(): m_last(), m_frames(0) {}
+    bool open(const char *path, TraceHeader const& header);
+    void write(InputFrame const& frame, uint32_t stateHash);
+    void close();
+    bool isOpen() const {
+        return m_file.isOpen();
+    }
+    uint32_t frames() const {
+        return m_frames;
+    }
+private:
+    AsyncFileWriter m_file;
+    InputFrame m_last;
+    uint32_t m_frames;
+};
+
+class InputTraceReader {
+public:
+    InputTraceReader(): m_pos(0), m_last(), m_frames(0), m_header() {}
+    bool open(const char *path);
+    // Returns false at the end of the trace or if it is damaged.
+    bool next(InputFrame &frame, uint32_t &stateHash);
+    TraceHeader const& header() const {
+        return m_header;
+    }
+    uint32_t frames() const {
+        return m_frames;
+    }
+private:
+    bool varint(uint32_t &value);
+    bool u32(uint32_t &value);
+    std::vector<uint8_t> m_data;
+    size_t m_pos;
+    InputFrame m_last;
+    uint32_t m_frames;
+    TraceHeader m_header;
+};
+
+// FNV-1a, for hashing the simulation state
+static inline uint32_t fnv1a(uint32_t hash, const void *data, size_t size) {
+    auto bytes = (const uint8_t *)data;
+    for (size_t i=0; i<size; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+static constexpr uint32_t fnv1aBasis = 2166136261u;
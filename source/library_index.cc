@@ -0,0 +1,274 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "library_index.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sys/stat.h>
+
+static const char *indexHeader = "shijima-wii library index 3";
+
+bool LibraryIndex::read(std::string const& path) {
+    std::ifstream in { path };
+    if (in.fail()) {
+        return false;
+    }
+    std::string line;
+    if (!std::getline(in, line) || line != indexHeader) {
+        return false;
+    }
+    if (!std::getline(in, line)) {
+        return false;
+    }
+    dirMtime = std::strtoll(line.c_str(), NULL, 10);
+    mascots.clear();
+    while (std::getline(in, line)) {
+        if (line.size() < 2 || line[1] != '\t') {
+            return false;
+        }
+        if (line[0] == 'M') {
+            // M <tmpl> <graphics> <mtime> <name>
+            if (line.size() < 9 || line[3] != '\t' || line[5] != '\t') {
+                return false;
+            }
+            Mascot mascot;
+            mascot.tmpl = (TemplateKind)line[2];
+            mascot.graphics = (GraphicsKind)line[4];
+            char *end;
+            mascot.mtime = std::strtoll(line.c_str() + 6, &end, 10);
+            if (*end != '\t') {
+                return false;
+            }
+            mascot.name = end + 1;
+            mascots.push_back(std::move(mascot));
+        }
+        else if (line[0] == 'P' && !mascots.empty()) {
+            // P <path>
+            mascots.back().preview = line.substr(2);
+        }
+        else if ((line[0] == 'F' || line[0] == 'D') && !mascots.empty()) {
+            // F <size> <mtime> <path>, D for folders
+            File file;
+            file.folder = line[0] == 'D';
+            char *end;
+            file.size = std::strtoull(line.c_str() + 2, &end, 10);
+            if (*end != '\t') {
+                return false;
+            }
+            file.mtime = std::strtoll(end + 1, &end, 10);
+            if (*end != '\t') {
+                return false;
+            }
+            file.path = end + 1;
+            mascots.back().files.push_back(std::move(file));
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LibraryIndex::write(std::string const& path) const {
+    std::ofstream out { path, std::ios::trunc };
+    if (out.fail()) {
+        return false;
+    }
+    out << indexHeader << '\n' << dirMtime << '\n';
+    for (auto &mascot : mascots) {
+        out << "M\t" << (char)mascot.tmpl << '\t' << (char)mascot.graphics
+            << '\t' << mascot.mtime << '\t' << mascot.name << '\n';
+        if (!mascot.preview.empty()) {
+            out << "P\t" << mascot.preview << '\n';
+        }
+        for (auto &file : mascot.files) {
+            out << (file.folder ? "D\t" : "F\t") << file.size << '\t'
+                << file.mtime << '\t' << file.path << '\n';
+        }
+    }
+    out.close();
+    return !out.fail();
+}
+
+bool LibraryIndex::statPath(std::string const& path, uint64_t &size,
+    int64_t &mtime)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    size = st.st_size;
+    mtime = st.st_mtime;
+    return true;
+}
+
+bool LibraryIndex::statFiles(std::string const& dir, Mascot &mascot) {
+    uint64_t size;
+    if (!statPath(dir, size, mascot.mtime)) {
+        return false;
+    }
+    for (auto &file : mascot.files) {
+        if (!statPath(dir + "/" + file.path, file.size, file.mtime)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LibraryIndex::foldersMatch(std::string const& dir,
+    Mascot const& mascot)
+{
+    uint64_t size;
+    int64_t mtime;
+    if (!statPath(dir, size, mtime) || mtime != mascot.mtime) {
+        return false;
+    }
+    for (auto &file : mascot.files) {
+        if (file.folder && (!statPath(dir + "/" + file.path, size, mtime) ||
+            mtime != file.mtime))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LibraryIndex::previewMatches(std::string const& dir,
+    Mascot const& mascot)
+{
+    if (mascot.preview.empty()) {
+        return true;
+    }
+    for (auto &file : mascot.files) {
+        if (!file.folder && file.path == mascot.preview) {
+            uint64_t size;
+            int64_t mtime;
+            return statPath(dir + "/" + file.path, size, mtime) &&
+                size == file.size && mtime == file.mtime;
+        }
+    }
+    return false;
+}
+
+bool LibraryIndex::changed(std::string const& dir, Mascot &mascot,
+    bool &touched)
+{
+    if (mascot.tmpl == TemplateNone || mascot.graphics == GraphicsNone ||
+        !previewMatches(dir, mascot))
+    {
+        return true;
+    }
+    auto current = mascot;
+    uint64_t size;
+    if (!statPath(dir, size, current.mtime)) {
+        return true;
+    }
+    for (auto &file : current.files) {
+        if (file.folder &&
+            !statPath(dir + "/" + file.path, size, file.mtime))
+        {
+            return true;
+        }
+    }
+    auto folderChanged = [&](std::string const& path) {
+        auto slash = path.find('/');
+        if (slash == std::string::npos) {
+            return current.mtime != mascot.mtime;
+        }
+        for (size_t i=0; i<mascot.files.size(); ++i) {
+            if (mascot.files[i].folder &&
+                path.compare(0, slash, mascot.files[i].path) == 0 &&
+                mascot.files[i].path.size() == slash)
+            {
+                return current.files[i].mtime != mascot.files[i].mtime;
+            }
+        }
+        return true;
+    };
+    for (auto &file : current.files) {
+        if (file.folder || !folderChanged(file.path)) {
+            continue;
+        }
+        auto indexed = file;
+        if (!statPath(dir + "/" + file.path, file.size, file.mtime) ||
+            file.size != indexed.size || file.mtime != indexed.mtime)
+        {
+            return true;
+        }
+    }
+    // mascot.cereal is preferred over XML files once it is there
+    if (mascot.tmpl == TemplateXML && current.mtime != mascot.mtime &&
+        std::filesystem::is_regular_file(dir + "/mascot.cereal"))
+    {
+        return true;
+    }
+    touched |= current.mtime != mascot.mtime;
+    for (size_t i=0; i<mascot.files.size(); ++i) {
+        touched |= current.files[i].mtime != mascot.files[i].mtime;
+    }
+    mascot = std::move(current);
+    return false;
+}
+
+bool LibraryIndex::listMascots(std::string const& dir,
+    std::vector<std::string> &names)
+{
+    // The type comes with the entry where the filesystem reports it, so
+    // only names that look like a mascot cost a stat()
+    std::error_code error;
+    std::filesystem::directory_iterator iter { dir, error };
+    if (error) {
+        return false;
+    }
+    for (auto &entry : iter) {
+        auto path = entry.path();
+        if (path.extension() == ".mascot" && entry.is_directory(error)) {
+            names.push_back(path.stem());
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return true;
+}
+
+bool LibraryIndex::matches(std::string const& dir) const {
+    uint64_t size;
+    int64_t mtime;
+    if (!statPath(dir, size, mtime) || mtime != dirMtime) {
+        return false;
+    }
+    std::vector<std::string> names;
+    if (!listMascots(dir, names) || names.size() != mascots.size()) {
+        return false;
+    }
+    std::vector<std::string> indexed;
+    for (auto &mascot : mascots) {
+        indexed.push_back(mascot.name);
+    }
+    std::sort(indexed.begin(), indexed.end());
+    if (names != indexed) {
+        return false;
+    }
+    for (auto &mascot : mascots) {
+        if (!foldersMatch(dir + "/" + mascot.name + ".mascot", mascot)) {
+            return false;
+        }
+    }
+    return true;
+}
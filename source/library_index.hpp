@@ -0,0 +1,94 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Persistent list of the installed mascots and their asset files, so
+// that a boot where nothing changed can skip probing every mascot
+// folder. Paths of files are relative to the mascot folder. Entries
+// that failed to load are kept with both kinds set to None so that the
+// names still match the folder listing.
+//
+// Adding, removing or renaming a file changes the mtime of the folder
+// it is in, so the mtimes of a mascot's folder and of its sprite
+// folders tell whether its file list is still right without a stat()
+// per file. Editing a file in place only changes its own mtime, and on
+// FAT not even that of its folder, so the file the thumbnail is drawn
+// from is compared by itself on every boot.
+class LibraryIndex {
+public:
+    struct File {
+        std::string path;
+        uint64_t size;
+        int64_t mtime;
+        bool folder;
+    };
+    enum TemplateKind : char {
+        TemplateNone = '-',
+        TemplateCereal = 'c',
+        TemplateXML = 'x'
+    };
+    enum GraphicsKind : char {
+        GraphicsNone = '-',
+        GraphicsQutex = 't',
+        GraphicsPNG = 'i'
+    };
+    struct Mascot {
+        std::string name;
+        // of the mascot folder
+        int64_t mtime = 0;
+        TemplateKind tmpl = TemplateNone;
+        GraphicsKind graphics = GraphicsNone;
+        std::vector<File> files;
+        // the entry of files the thumbnail is drawn from, empty if none
+        std::string preview;
+    };
+    int64_t dirMtime = 0;
+    std::vector<Mascot> mascots;
+    bool read(std::string const& path);
+    bool write(std::string const& path) const;
+    // true if the index still describes dir, checked with a stat() of
+    // dir, one pass over its entries and foldersMatch() for every mascot
+    bool matches(std::string const& dir) const;
+    // stat() the folder of mascot, dir, and every file in it
+    static bool statFiles(std::string const& dir, Mascot &mascot);
+    // true if dir and the folders among the files of mascot still have
+    // the recorded mtimes
+    static bool foldersMatch(std::string const& dir, Mascot const& mascot);
+    // true if the preview file of mascot, in dir, still has the recorded
+    // size and mtime
+    static bool previewMatches(std::string const& dir,
+        Mascot const& mascot);
+    // True if the files of mascot, in dir, differ from when it was
+    // indexed, or if it failed to load then. Only the files of folders
+    // whose mtime changed get a stat(), the others can't have been
+    // replaced. A folder can also change because of files the mascot
+    // doesn't use. A preview file edited in place counts as a change
+    // too. Then mascot takes the new mtimes and touched is set,
+    // so that the index gets written again and still matches the
+    // library.
+    static bool changed(std::string const& dir, Mascot &mascot,
+        bool &touched);
+    static bool statPath(std::string const& path, uint64_t &size,
+        int64_t &mtime);
+    static bool listMascots(std::string const& dir,
+        std::vector<std::string> &names);
+};
@@ -0,0 +1,184 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "load_arena.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+
+// malloc() style blocks carry their size and the block allocated
+// before them in front, which keeps the data 16-byte aligned. Freeing
+// them in reverse order gives all of their space back.
+struct Header {
+    size_t size;
+    uint8_t *previous;
+};
+static constexpr size_t headerSize = 16;
+static_assert(sizeof(Header) <= headerSize, "load arena header too large");
+
+static std::atomic<LoadArena *> currentArena { NULL };
+static ThreadId currentThread;
+
+LoadArena::LoadArena(size_t capacity): m_capacity(capacity), m_used(0),
+    m_peak(0), m_overflows(0), m_last(NULL)
+{
+    m_base = capacity > 0 ? (uint8_t *)memalign(32, capacity) : NULL;
+    if (m_base == NULL) {
+        m_capacity = 0;
+    }
+}
+
+LoadArena::~LoadArena() {
+    free(m_base);
+}
+
+void *LoadArena::bump(size_t size, size_t alignment) {
+    size_t start = (m_used + alignment - 1) & ~(alignment - 1);
+    if (start > m_capacity || size > m_capacity - start) {
+        ++m_overflows;
+        return NULL;
+    }
+    m_last = m_base + start;
+    m_used = start + size;
+    m_peak = std::max(m_peak, m_used);
+    return m_last;
+}
+
+void *LoadArena::allocate(size_t size) {
+    Header header { size, m_last };
+    auto block = (uint8_t *)bump(headerSize + size, headerSize);
+    if (block == NULL) {
+        return malloc(size);
+    }
+    memcpy(block, &header, sizeof(header));
+    return block + headerSize;
+}
+
+void *LoadArena::reallocate(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return allocate(size);
+    }
+    if (!owns(ptr)) {
+        return realloc(ptr, size);
+    }
+    auto block = (uint8_t *)ptr - headerSize;
+    Header header;
+    memcpy(&header, block, sizeof(header));
+    size_t oldSize = header.size;
+    if (block == m_last && (size_t)(block - m_base) + headerSize + size <=
+        m_capacity)
+    {
+        // the last allocation grows in place
+        m_used = (block - m_base) + headerSize + size;
+        m_peak = std::max(m_peak, m_used);
+        header.size = size;
+        memcpy(block, &header, sizeof(header));
+        return ptr;
+    }
+    void *copy = allocate(size);
+    if (copy != NULL) {
+        memcpy(copy, ptr, std::min(oldSize, size));
+    }
+    return copy;
+}
+
+void LoadArena::release(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (!owns(ptr)) {
+        free(ptr);
+        return;
+    }
+    auto block = (uint8_t *)ptr - headerSize;
+    if (block == m_last) {
+        Header header;
+        memcpy(&header, block, sizeof(header));
+        m_used = block - m_base;
+        m_last = header.previous;
+    }
+}
+
+void *LoadArena::do_allocate(size_t bytes, size_t alignment) {
+    void *ptr = bump(bytes, std::max<size_t>(alignment, 1));
+    if (ptr == NULL) {
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    return ptr;
+}
+
+void LoadArena::do_deallocate(void *ptr, size_t bytes, size_t alignment) {
+    if (!owns(ptr)) {
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+    else if (ptr == m_last) {
+        m_used = (uint8_t *)ptr - m_base;
+        m_last = NULL;
+    }
+}
+
+LoadArena::Scope::Scope(LoadArena &arena): m_arena(arena) {
+    currentThread = currentThreadId();
+    currentArena.store(&arena, std::memory_order_release);
+}
+
+LoadArena::Scope::~Scope() {
+    currentArena.store(NULL, std::memory_order_release);
+    m_arena.reset();
+}
+
+static LoadArena *threadArena() {
+    LoadArena *arena = currentArena.load(std::memory_order_acquire);
+    if (arena != NULL && currentThreadId() == currentThread) {
+        return arena;
+    }
+    return NULL;
+}
+
+void *loadMalloc(size_t size) {
+    auto arena = threadArena();
+    return arena != NULL ? arena->allocate(size) : malloc(size);
+}
+
+void *loadRealloc(void *ptr, size_t size) {
+    auto arena = threadArena();
+    if (arena != NULL) {
+        return arena->reallocate(ptr, size);
+    }
+    return realloc(ptr, size);
+}
+
+void loadFree(void *ptr) {
+    auto arena = threadArena();
+    if (arena != NULL) {
+        arena->release(ptr);
+    }
+    else {
+        free(ptr);
+    }
+}
+
+std::pmr::memory_resource *loadResource() {
+    auto arena = threadArena();
+    if (arena != NULL) {
+        return arena;
+    }
+    return std::pmr::get_default_resource();
+}
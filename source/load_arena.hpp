@@ -0,0 +1,98 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include "thread.hpp"
+
+// Bump allocator for the short-lived buffers made while one mascot
+// loads: stb_image decode output, the resize scratch, the PNG
+// re-encode and the qutex sheet lists. Everything is dropped at once
+// with reset(), so loading doesn't leave holes all over the heap before
+// mascots are spawned. Allocations that don't fit fall back to malloc().
+//
+// The arena is not thread safe. Scope binds it to the thread that
+// creates it, and the load*() functions below only use it from that
+// thread.
+class LoadArena : public std::pmr::memory_resource {
+public:
+    explicit LoadArena(size_t capacity);
+    ~LoadArena();
+    LoadArena(const LoadArena &) = delete;
+    LoadArena &operator=(const LoadArena &) = delete;
+    // malloc() style interface with a size header, for stb
+    void *allocate(size_t size);
+    void *reallocate(void *ptr, size_t size);
+    void release(void *ptr);
+    bool owns(const void *ptr) const {
+        return m_base != NULL && (const uint8_t *)ptr >= m_base &&
+            (const uint8_t *)ptr < m_base + m_capacity;
+    }
+    void reset() {
+        m_used = 0;
+        m_last = NULL;
+    }
+    size_t capacity() const {
+        return m_capacity;
+    }
+    // most bytes in use at once, and allocations that didn't fit
+    size_t peak() const {
+        return m_peak;
+    }
+    size_t overflows() const {
+        return m_overflows;
+    }
+
+    // Makes arena the load arena of the calling thread and resets it
+    // when the scope ends.
+    class Scope {
+    public:
+        explicit Scope(LoadArena &arena);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    private:
+        LoadArena &m_arena;
+    };
+private:
+    void *bump(size_t size, size_t alignment);
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(std::pmr::memory_resource const& other) const
+        noexcept override
+    {
+        return this == &other;
+    }
+    uint8_t *m_base;
+    size_t m_capacity;
+    size_t m_used;
+    size_t m_peak;
+    size_t m_overflows;
+    // start of the most recent allocation, which can grow or be popped
+    uint8_t *m_last;
+};
+
+// The load arena if the calling thread is inside a LoadArena::Scope,
+// otherwise malloc()/free(). Buffers from loadMalloc() must be freed
+// before the scope ends.
+void *loadMalloc(size_t size);
+void *loadRealloc(void *ptr, size_t size);
+void loadFree(void *ptr);
+// for std::pmr containers, the default resource outside of a scope
+std::pmr::memory_resource *loadResource();
@@ -20,10 +20,13 @@
 #include <grrlib.h>
 #include <memory>
 #include <stdlib.h>
+#include <malloc.h>
 #include <cstdio>
 #include <gccore.h>
+#include <ogc/lwp_watchdog.h>
 #include <fat.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <wiiuse/wpad.h>
 #include <filesystem>
 #include <vector>
@@ -31,30 +34,93 @@
 #include <sstream>
 #include <map>
 #include <list>
+#include <deque>
+#include <set>
 #include <string>
+#include <string_view>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
 #include <qutex/reader.hpp>
 #include <shijima/shijima.hpp>
+#include "alloc_counter.hpp"
+#include "async_writer.hpp"
+#include "console.hpp"
+#include "display_list.hpp"
+#include "file_pipeline.hpp"
+#include "idle_scheduler.hpp"
+#include "input_trace.hpp"
+#include "library_index.hpp"
+#include "load_arena.hpp"
+#include "mascot_loader.hpp"
+#include "memory_report.hpp"
+#include "prototype_pool.hpp"
+#include "qutex_sprite.hpp"
+#include "scene_draw.hpp"
+#include "scene_snapshot.hpp"
+#include "slab_pool.hpp"
+#include "spatial_grid.hpp"
+#include "sprite_name.hpp"
+#include "spsc_queue.hpp"
+#include "text_batch.hpp"
+#include "texture_cache.hpp"
+#include "texture_convert.hpp"
+#include "thread.hpp"
+#include "thumbnail_cache.hpp"
+#include "trace.hpp"
+#include "video_timing.hpp"
 #include "font.hpp"
 
+// decoder buffers come from the load arena while a mascot loads
+#define STBI_MALLOC(size) loadMalloc(size)
+#define STBI_REALLOC(ptr, size) loadRealloc(ptr, size)
+#define STBI_FREE(ptr) loadFree(ptr)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#define STBIW_MALLOC(size) loadMalloc(size)
+#define STBIW_REALLOC(ptr, size) loadRealloc(ptr, size)
+#define STBIW_FREE(ptr) loadFree(ptr)
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
 // eh
 using namespace std;
 
-static ostringstream consoleStream;
-static vector<string> consoleLines;
-static int firstLineIdx = 0;
-static int realLineCount = 0;
+static AsyncFileWriter logFile;
+static ConsoleBuffer console;
+static ConsoleWriter mainConsoleWriter { console };
+static ConsoleWriter loaderConsoleWriter { console };
+static ostream mainConsoleStream { &mainConsoleWriter };
+static ostream loaderConsoleStream { &loaderConsoleWriter };
+static ThreadId mainThread;
 static GRRLIB_texImg *texFont;
-#define cerr consoleStream
-#define cout consoleStream
+static GRRLIB_texImg *texConsole;
+static TextBatch textBatch;
+
+// the loader thread logs through its own stream
+static ostream &consoleStream() {
+    if (currentThreadId() == mainThread) {
+        return mainConsoleStream;
+    }
+    return loaderConsoleStream;
+}
+
+#define cerr consoleStream()
+#define cout consoleStream()
 
 #define MASCOT_LOCATION "/Shijima"
+#define CACHE_LOCATION MASCOT_LOCATION "/.cache"
+#define INDEX_PATH CACHE_LOCATION "/library.index"
+#define THUMBNAIL_LOCATION CACHE_LOCATION "/thumbs"
+#define SCENE_PATH CACHE_LOCATION "/scene.snapshot"
+#define MEMORY_REPORT_PATH MASCOT_LOCATION "/shijima-wii.memory.txt"
+#define LOG_PATH MASCOT_LOCATION "/shijima-wii.log"
+#define TRACE_PATH CACHE_LOCATION "/last.trace"
+#define TRACE_SCENE_PATH CACHE_LOCATION "/last.scene"
+#define REPLAY_PATH MASCOT_LOCATION "/replay.trace"
+#define REPLAY_SCENE_PATH MASCOT_LOCATION "/replay.scene"
 
 static unsigned char asciitolower(unsigned char in) {
     if (in <= 'Z' && in >= 'A')
@@ -67,36 +133,29 @@ static void asciitolower(std::string &data) {
         [](unsigned char c){ return asciitolower(c); });
 }
 
-static void flushConsole() {
-    string newConsole = consoleStream.str();
-    if (!newConsole.empty()) {
-        consoleStream = {};
-        stringstream newStream { newConsole };
-        string line;
-        while (getline(newStream, line)) {
-            if (realLineCount == (int)consoleLines.size()) {
-                consoleLines[firstLineIdx] = line;
-                firstLineIdx = (firstLineIdx + 1) % consoleLines.size();
-            }
-            else {
-                consoleLines[realLineCount] = line;
-                realLineCount++;
-            }
-        }
-    }
-}
-
 static void drawConsole() {
-    for (size_t i=firstLineIdx, j=0; j < consoleLines.size();
-        i = (i+1) % consoleLines.size(), j++)
-    {
-        GRRLIB_Printf(0, + (j+1)*16, texFont, 0xFFFFFFFF,
-            1, "%s", consoleLines[i].c_str());
-    }
+    drawConsole(textBatch, console, texConsole);
 }
 
-static void showConsoleNow() {
-    flushConsole();
+static unsigned consoleRenders = 0;
+static unsigned skippedRenders = 0;
+
+// Presents the console immediately. Unless forced, this is rate limited
+// since every present waits for vsync and slows down loading; output
+// that is not shown still ends up in the log file.
+static void showConsoleNow(bool force = false) {
+    if (currentThreadId() != mainThread) {
+        // only the main thread may render, it shows the console anyway
+        return;
+    }
+    static u64 lastRender = 0;
+    u64 now = gettime();
+    if (!force && lastRender != 0 && diff_usec(lastRender, now) < 250000) {
+        ++skippedRenders;
+        return;
+    }
+    lastRender = now;
+    ++consoleRenders;
     drawConsole();
     GRRLIB_Render();
 }
@@ -111,13 +170,30 @@ static void die(string const& error) {
     }
 }
 
-static void clearConsole() {
-    for (auto &line : consoleLines) {
-        line = "";
+// Once the log is larger than this, the next boot moves it to
+// LOG_PATH.1 and starts a new one
+#ifndef LOG_ROTATE_SIZE
+#define LOG_ROTATE_SIZE (1024 * 1024)
+#endif
+
+// Every boot appends to LOG_PATH, so the log of a session that crashed
+// is still there after the next boot
+static void openLog() {
+    struct stat info;
+    if (stat(LOG_PATH, &info) == 0 && info.st_size > LOG_ROTATE_SIZE) {
+        remove(LOG_PATH ".1");
+        rename(LOG_PATH, LOG_PATH ".1");
     }
-    firstLineIdx = 0;
-    realLineCount = 0;
-    consoleStream = {};
+    if (logFile.open(LOG_PATH, "ab")) {
+        // marks where this session starts, the screen doesn't need it
+        static const char separator[] = "--- boot ---\n";
+        logFile.write(separator, sizeof(separator) - 1);
+        console.setSink(&logFile);
+    }
+}
+
+static void clearConsole() {
+    console.clear();
 }
 
 static bool readFile(filesystem::path const& path, string &out) {
@@ -134,36 +210,332 @@ static bool readFile(filesystem::path const& path, string &out) {
     return true;
 }
 
+// PNG re-encoded by stb_image_write, kept in the load arena
+struct ResizedSprite {
+    u8 *data;
+    size_t size;
+};
+
 static void resized_sprite_write(void *context, void *data, int size) {
-    auto &output = *(ostringstream *)context;
-    output.write((const char *)data, (size_t)size);
+    auto &output = *(ResizedSprite *)context;
+    u8 *grown = (u8 *)loadRealloc(output.data, output.size + size);
+    if (grown == NULL) {
+        return;
+    }
+    memcpy(grown + output.size, data, size);
+    output.data = grown;
+    output.size += size;
+}
+
+static size_t textureBytes(GRRLIB_texImg *tex) {
+    // GRRLIB textures are always GX_TF_RGBA8
+    return sizeof(*tex) + (size_t)tex->w * tex->h * 4;
+}
+
+// Budget for the decoded textures of all mascots. The texture files stay
+// in memory and are decoded when first drawn. While the budget is
+// exceeded, the least recently drawn textures are freed again.
+#ifndef TEXTURE_BUDGET
+#define TEXTURE_BUDGET (24 * 1024 * 1024)
+#endif
+
+// A qutex sheet or the image of a PNG sprite, kept as its file. Only the
+// main thread tracks slots in the texture cache. On the loader thread,
+// acquire() and acquireForDraw() decode without it and the caller frees
+// the texture again with release().
+class TextureSlot {
+public:
+    // The size of the texture is read from the file's header. If the
+    // header can't be read, it stays 0 until the first decode.
+    TextureSlot(const u8 *data, size_t size);
+    TextureSlot(const TextureSlot &) = delete;
+    TextureSlot &operator=(const TextureSlot &) = delete;
+    ~TextureSlot();
+    // Decodes the texture if it isn't resident. Returns NULL if that
+    // fails, which is only reported once.
+    GRRLIB_texImg *acquire();
+    // Like acquire(), but returns NULL while the texture waits to be
+    // decoded in idle time, see TextureCache::draw()
+    GRRLIB_texImg *acquireForDraw();
+    void release();
+    bool resident() const {
+        return m_texture != NULL;
+    }
+    int width() const {
+        return m_width;
+    }
+    int height() const {
+        return m_height;
+    }
+    // changes every time the texture is decoded, for GX objects that
+    // point to its data
+    u32 generation() const {
+        return m_generation;
+    }
+    size_t decodedBytes() const {
+        return m_texture == NULL ? 0 : textureBytes(m_texture);
+    }
+    size_t encodedBytes() const {
+        return m_size + m_alphaMask.capacity();
+    }
+    // the image file, which stays as long as the slot
+    const u8 *fileData() const {
+        return m_data;
+    }
+    size_t fileSize() const {
+        return m_size;
+    }
+    // Hit testing without the texture. The mask is made by the first
+    // decode and kept after the texture is evicted.
+    bool hasAlphaMask() const {
+        return !m_alphaMask.empty();
+    }
+    bool opaque(int x, int y) const {
+        return alphaMaskAt(&m_alphaMask[0], m_width, x, y);
+    }
+private:
+    template<typename> friend class TextureCache;
+    bool failed() const {
+        return m_failed;
+    }
+    size_t expectedBytes() const {
+        return sizeof(GRRLIB_texImg) + (size_t)m_width * m_height * 4;
+    }
+    bool load() {
+        return decode() != NULL;
+    }
+    void unload();
+    GRRLIB_texImg *decode();
+    GRRLIB_texImg *convert(const u8 *rgba, int width, int height);
+    u8 *m_data;
+    size_t m_size;
+    int m_width, m_height;
+    GRRLIB_texImg *m_texture = NULL;
+    vector<u8> m_alphaMask;
+    u32 m_generation = 0;
+    bool m_failed = false;
+    // texture cache state, main thread only
+    TextureCacheLinks<TextureSlot> m_links;
+};
+
+static TextureCache<TextureSlot> textureCache { TEXTURE_BUDGET };
+
+TextureSlot::TextureSlot(const u8 *data, size_t size):
+    m_data((u8 *)malloc(size)), m_size(size), m_width(0), m_height(0)
+{
+    if (m_data == NULL) {
+        m_size = 0;
+        m_failed = true;
+        return;
+    }
+    memcpy(m_data, data, size);
+    int comp;
+    if (stbi_info_from_memory(m_data, m_size, &m_width, &m_height,
+        &comp) != 1)
+    {
+        m_width = m_height = 0;
+    }
+}
+
+TextureSlot::~TextureSlot() {
+    if (currentThreadId() == mainThread) {
+        textureCache.remove(this);
+    }
+    if (m_texture != NULL) {
+        GRRLIB_FreeTexture(m_texture);
+    }
+    free(m_data);
+}
+
+GRRLIB_texImg *TextureSlot::acquire() {
+    if (currentThreadId() == mainThread) {
+        return textureCache.acquire(this) ? m_texture : NULL;
+    }
+    return decode();
+}
+
+GRRLIB_texImg *TextureSlot::acquireForDraw() {
+    if (currentThreadId() == mainThread) {
+        return textureCache.draw(this) ? m_texture : NULL;
+    }
+    return decode();
+}
+
+// Bytes converted by tileRGBA8() and buildAlphaMask() and the time it
+// took, on any thread
+static atomic<size_t> convertedBytes { 0 };
+static atomic<u32> convertMicros { 0 };
+
+// The file is decoded with stb_image and tiled by tileRGBA8() instead of
+// in GRRLIB, so the conversion uses the fastest kernel there is.
+GRRLIB_texImg *TextureSlot::convert(const u8 *rgba, int width, int height) {
+    if (width % 4 != 0 || height % 4 != 0) {
+        return NULL;
+    }
+    auto texture = GRRLIB_CreateEmptyTexture(width, height);
+    if (texture == NULL) {
+        return NULL;
+    }
+    u64 start = gettime();
+    tileRGBA8(rgba, width, height, (u8 *)texture->data);
+    if (m_alphaMask.empty() && width == m_width && height == m_height) {
+        m_alphaMask.resize(alphaMaskSize(width, height));
+        buildAlphaMask(rgba, width, height, &m_alphaMask[0]);
+    }
+    convertMicros += diff_usec(start, gettime());
+    convertedBytes += (size_t)width * height * 4;
+    GRRLIB_FlushTex(texture);
+    return texture;
+}
+
+#ifndef NDEBUG
+// Checks the conversion kernels against their scalar references on a
+// generated image and logs the speed of both, at boot in debug builds
+static void benchmarkTextureConvert() {
+    const int size = 256;
+    vector<u8> rgba(size * size * 4);
+    u32 seed = 1;
+    for (auto &byte : rgba) {
+        seed = seed * 1103515245 + 12345;
+        // plenty of fully transparent pixels, like in sprites
+        byte = (seed >> 28) < 4 ? 0 : seed >> 16;
+    }
+    vector<u8> actual(rgba.size());
+    auto measure = [&](const char *name, auto convert, size_t outputSize) {
+        const int rounds = 8;
+        u64 start = gettime();
+        for (int i=0; i<rounds; ++i) {
+            convert(&rgba[0], size, size, &actual[0]);
+        }
+        u32 micros = max(diff_usec(start, gettime()), (u32)1);
+        cout << "  " << name << ": " << rounds * rgba.size() / micros
+            << " MB/s" << endl;
+        return vector<u8> { actual.begin(), actual.begin() + outputSize };
+    };
+    cout << "Texture conversion kernel: " << textureConvertKernel() << endl;
+    size_t maskSize = alphaMaskSize(size, size);
+    bool same = measure("tiling, scalar", tileRGBA8Scalar, rgba.size()) ==
+        measure("tiling", tileRGBA8, rgba.size());
+    same = same && measure("alpha mask, scalar", buildAlphaMaskScalar,
+        maskSize) == measure("alpha mask", buildAlphaMask, maskSize);
+    if (!same) {
+        cerr << "W: conversion kernel differs from the scalar reference"
+            << endl;
+    }
+}
+#endif
+
+GRRLIB_texImg *TextureSlot::decode() {
+    if (m_texture != NULL || m_failed) {
+        return m_texture;
+    }
+    TRACE_ZONE("texture decode");
+    int width = 0, height = 0, comp;
+    u8 *rgba = stbi_load_from_memory(m_data, m_size, &width, &height, &comp,
+        4);
+    if (rgba != NULL) {
+        m_texture = convert(rgba, width, height);
+        stbi_image_free(rgba);
+    }
+    if (m_texture == NULL) {
+        // formats stb_image can't read are left to GRRLIB
+        m_texture = GRRLIB_LoadTexture(m_data);
+        if (m_texture != NULL && m_width == 0) {
+            m_width = m_texture->w;
+            m_height = m_texture->h;
+        }
+    }
+    if (m_texture == NULL) {
+        cerr << "W: couldn't decode a " << m_width << "x" << m_height
+            << " texture" << endl;
+        m_failed = true;
+        return NULL;
+    }
+    ++m_generation;
+    return m_texture;
+}
+
+void TextureSlot::release() {
+    if (m_links.cached || m_links.waitingSince != 0) {
+        textureCache.remove(this);
+    }
+    unload();
+}
+
+void TextureSlot::unload() {
+    if (m_texture != NULL) {
+        GRRLIB_FreeTexture(m_texture);
+        m_texture = NULL;
+    }
 }
 
 class MascotSprite {
 public:
-    virtual void draw(f32 xpos, f32 ypos, bool flipX) const = 0;
+    // returns false if the texture isn't ready, see acquireForDraw()
+    virtual bool draw(f32 xpos, f32 ypos, bool flipX) const = 0;
     virtual int width() const = 0;
     virtual int height() const = 0;
-    virtual bool pointInside(int xpos, int ypos) const = 0;
+    // RGBA color at a point of the sprite, transparent outside of it
+    virtual u32 pixel(int xpos, int ypos) const = 0;
+    virtual bool pointInside(int xpos, int ypos) const {
+        return (pixel(xpos, ypos) & 0xFF) > 0;
+    }
+    virtual TextureSlot *slot() const = 0;
+    // where the sprite is on the image of slot()
+    virtual SpriteRegion region() const = 0;
     virtual ~MascotSprite() {}
 };
 
 class MascotSpriteQutex : public MascotSprite {
 public:
-    MascotSpriteQutex(GRRLIB_texImg *tex, int cw, int ch, int xtex, int ytex,
-        int wtex, int htex, int xoff, int yoff, int wreal, int hreal):
-        tex(tex), cw(cw), ch(ch), xtex(xtex+1), ytex(ytex+1), wtex(wtex-1),
-        htex(htex-1), xoff(xoff+1), yoff(yoff+1), wreal(wreal), hreal(hreal) {}
-    virtual void draw(f32 xpos, f32 ypos, bool flipX) const {
-        ypos += yoff;
-        if (flipX) {
-            xpos += cw - wtex - xoff;
+    MascotSpriteQutex(TextureSlot *sheet, QutexSprite const& geometry,
+        int wreal, int hreal): sheet(sheet), geometry(geometry),
+        wreal(wreal), hreal(hreal), texObjGeneration(0), lists(NULL) {}
+    // Records the normal and the mirrored quad in list, which has to be
+    // 32-byte aligned, hold 2 * spriteQuadListSize bytes and outlive
+    // the sprite. Sheets whose size isn't known before they are decoded
+    // are drawn without lists.
+    void buildDisplayLists(u8 *list) {
+        if (sheet->width() <= 0 || sheet->height() <= 0) {
+            return;
         }
-        else {
-            xpos += xoff;
+        auto quad = geometry.quad(sheet->width(), sheet->height());
+        if (writeSpriteQuad(list, spriteQuadListSize, quad, false,
+                0xFFFFFFFF) == 0 ||
+            writeSpriteQuad(list + spriteQuadListSize, spriteQuadListSize,
+                quad, true, 0xFFFFFFFF) == 0)
+        {
+            return;
+        }
+        DCFlushRange(list, 2 * spriteQuadListSize);
+        lists = list;
+    }
+    virtual bool draw(f32 xpos, f32 ypos, bool flipX) const {
+        xpos += geometry.drawX(flipX);
+        ypos += geometry.drawY();
+        auto tex = sheet->acquireForDraw();
+        if (tex == NULL) {
+            return false;
+        }
+        if (lists == NULL) {
+            GRRLIB_DrawPart(xpos, ypos, geometry.x, geometry.y,
+                geometry.width, geometry.height, tex, 0, flipX ? -1 : 1, 1,
+                0xFFFFFFFF);
+            return true;
         }
-        GRRLIB_DrawPart(xpos, ypos, xtex, ytex, wtex, htex,
-            tex, 0, flipX ? -1 : 1, 1, 0xFFFFFFFF);
+        if (texObjGeneration != sheet->generation()) {
+            // the sheet was decoded again since the last draw
+            GX_InitTexObj(&texObj, tex->data, tex->w, tex->h, GX_TF_RGBA8,
+                GX_CLAMP, GX_CLAMP, GX_FALSE);
+            if (!GRRLIB_Settings.antialias) {
+                GX_InitTexObjLOD(&texObj, GX_NEAR, GX_NEAR, 0.0f, 0.0f, 0.0f,
+                    0, 0, GX_ANISO_1);
+            }
+            texObjGeneration = sheet->generation();
+        }
+        drawSpriteList(&texObj, lists + (flipX ? spriteQuadListSize : 0),
+            spriteQuadListSize, xpos, ypos);
+        return true;
     }
     virtual int width() const {
         return wreal;
@@ -171,52 +543,61 @@ public:
     virtual int height() const {
         return hreal;
     }
+    virtual u32 pixel(int xpos, int ypos) const {
+        int x, y;
+        if (!geometry.texel(xpos, ypos, x, y)) {
+            return 0;
+        }
+        auto tex = sheet->acquire();
+        if (tex == NULL) {
+            return 0;
+        }
+        return GRRLIB_GetPixelFromtexImg(x, y, tex);
+    }
     virtual bool pointInside(int xpos, int ypos) const {
-        xpos -= xoff;
-        ypos -= yoff;
-        if (xpos < 0 || xpos >= wtex || ypos < 0 || ypos >= htex) {
-            return false;
+        int x, y;
+        if (!sheet->hasAlphaMask()) {
+            return MascotSprite::pointInside(xpos, ypos);
         }
-        xpos += xtex;
-        ypos += ytex;
-        u32 rgba = GRRLIB_GetPixelFromtexImg(xpos, ypos, tex);
-        return (rgba & 0xFF) > 0;
+        return geometry.texel(xpos, ypos, x, y) && sheet->opaque(x, y);
+    }
+    virtual TextureSlot *slot() const {
+        return sheet;
     }
-    GRRLIB_texImg *texture() {
-        return tex;
+    virtual SpriteRegion region() const {
+        return { wreal, hreal, geometry.x, geometry.y, geometry.width,
+            geometry.height, geometry.xoff, geometry.yoff };
     }
     virtual ~MascotSpriteQutex() {}
 private:
-    GRRLIB_texImg *tex;
-    int cw;
-    int ch;
-    int xtex;
-    int ytex;
-    int wtex;
-    int htex;
-    int xoff;
-    int yoff;
+    // owned by the TexturePack
+    TextureSlot *sheet;
+    QutexSprite geometry;
     int wreal;
     int hreal;
+    mutable u32 texObjGeneration;
+    mutable GXTexObj texObj;
+    const u8 *lists;
 };
 
 class MascotSpritePNG : public MascotSprite {
 public:
     MascotSpritePNG(): m_valid(false) {}
-    MascotSpritePNG(filesystem::path path): m_valid(false) {
-        string data;
-        if (!readFile(path, data)) {
+    MascotSpritePNG(filesystem::path const& path, const u8 *data,
+        size_t size): m_valid(false)
+    {
+        TRACE_ZONE("PNG decode");
+        if (data == NULL) {
             return;
         }
         int origWidth = -1, origHeight = -1, origComp = -1;
-        int ok = stbi_info_from_memory((const u8 *)data.c_str(), data.size(),
+        int ok = stbi_info_from_memory(data, size,
             &origWidth, &origHeight, &origComp);
         if (ok != 1 || origWidth <= 0 || origHeight <= 0 || origComp <= 0) {
             return;
         }
         m_width = origWidth;
         m_height = origHeight;
-        GRRLIB_texImg *tex = NULL;
         if (origWidth % 4 != 0 || origHeight % 4 != 0) {
             // attempt to resize first
             static bool firstResize = true;
@@ -230,18 +611,19 @@ public:
             // the resize process is not too reliable
             // draw new console output to the screen now in case we crash
             showConsoleNow();
-            static u8 buf[512 * 512 * 4];
+            const size_t bufSize = 512 * 512 * 4;
             if (origWidth > 512 || origHeight > 512) {
                 cerr << "ERROR: image too large to resize" << endl;
             }
             else {
-                u8 *oldBuf = stbi_load_from_memory((const u8 *)data.c_str(), data.size(),
+                u8 *oldBuf = stbi_load_from_memory(data, size,
                     &origWidth, &origHeight, &origComp, 4);
-                if (oldBuf == NULL) {
+                u8 *buf = (u8 *)loadMalloc(bufSize);
+                if (oldBuf == NULL || buf == NULL) {
                     cerr << "stbi_load_from_memory() failed" << endl;
                 }
                 else {
-                    memset(buf, 0, sizeof(buf));
+                    memset(buf, 0, bufSize);
                     int newWidth = (origWidth / 4 + 1) * 4;
                     int newHeight = (origHeight / 4 + 1) * 4;
                     uint32_t oldStride = origWidth * 4;
@@ -249,29 +631,35 @@ public:
                     for (int y = origWidth - 1; y >= 0; y--) {
                         memcpy(buf + newStride * (origWidth - y - 1), oldBuf + oldStride * y, oldStride);
                     }
-                    ostringstream newPngStream;
-                    stbi_write_png_to_func(resized_sprite_write, (void *)&newPngStream,
+                    ResizedSprite newPng { NULL, 0 };
+                    stbi_write_png_to_func(resized_sprite_write, (void *)&newPng,
                         newWidth, newHeight, 4, buf, newStride);
-                    string newPng = newPngStream.str();
-                    tex = GRRLIB_LoadTexturePNG((const u8 *)newPng.c_str());
-                    stbi_image_free(oldBuf);
                     m_width = newWidth;
                     m_height = newHeight;
+                    if (newPng.data != NULL) {
+                        m_slot = make_unique<TextureSlot>(newPng.data,
+                            newPng.size);
+                    }
+                    loadFree(newPng.data);
                 }
+                // in reverse order so that the arena gets the space back,
+                // and on both paths as they come from malloc() when the
+                // arena is full
+                loadFree(buf);
+                stbi_image_free(oldBuf);
             }
         }
         else {
-            // load image directly
-            tex = GRRLIB_LoadTexturePNG((u8 *)data.c_str());
+            // decoded when it is first drawn
+            m_slot = make_unique<TextureSlot>(data, size);
         }
-        if (tex == NULL) {
+        if (m_slot == nullptr || m_slot->encodedBytes() == 0) {
             cerr << "ERROR: load failed: " << path << endl;
             return;
         }
-        m_texture = tex;
         m_valid = true;
     }
-    virtual void draw(f32 xpos, f32 ypos, bool flipX) const {
+    virtual bool draw(f32 xpos, f32 ypos, bool flipX) const {
         f32 scaleX;
         if (flipX) {
             scaleX = -1;
@@ -279,13 +667,15 @@ public:
         else {
             scaleX = 1;
         }
-        GRRLIB_DrawImg(xpos, ypos, m_texture, 0, scaleX,
+        auto texture = m_slot->acquireForDraw();
+        if (texture == NULL) {
+            return false;
+        }
+        GRRLIB_DrawImg(xpos, ypos, texture, 0, scaleX,
             1, 0xFFFFFFFF);
-
-    }
-    virtual ~MascotSpritePNG() {
-        GRRLIB_FreeTexture(m_texture);
+        return true;
     }
+    virtual ~MascotSpritePNG() {}
     bool valid() const {
         return m_valid;
     }
@@ -295,72 +685,226 @@ public:
     virtual int height() const {
         return m_height;
     }
-    virtual bool pointInside(int xpos, int ypos) const {
+    virtual u32 pixel(int xpos, int ypos) const {
         if (xpos < 0 || xpos >= m_width || ypos < 0 || ypos >= m_height) {
-            return false;
+            return 0;
         }
-        u32 rgba = GRRLIB_GetPixelFromtexImg(xpos, ypos, m_texture);
-        return (rgba & 0xFF) > 0;
+        auto texture = m_slot->acquire();
+        if (texture == NULL) {
+            return 0;
+        }
+        return GRRLIB_GetPixelFromtexImg(xpos, ypos, texture);
     }
-    GRRLIB_texImg *texture() const {
-        return m_texture;
+    virtual bool pointInside(int xpos, int ypos) const {
+        if (!m_slot->hasAlphaMask() || xpos < 0 || xpos >= m_width ||
+            ypos < 0 || ypos >= m_height)
+        {
+            return MascotSprite::pointInside(xpos, ypos);
+        }
+        return m_slot->opaque(xpos, ypos);
+    }
+    virtual TextureSlot *slot() const {
+        return m_slot.get();
+    }
+    virtual SpriteRegion region() const {
+        return { m_width, m_height, 0, 0, m_width, m_height, 0, 0 };
     }
 private:
     bool m_valid;
-    GRRLIB_texImg *m_texture;
+    unique_ptr<TextureSlot> m_slot;
     int m_width, m_height;
 };
 
+// Bytes read through texture pipelines and the time decoding spent
+// waiting for them. Only updated on the loader thread.
+static size_t textureBytesRead = 0;
+static u64 textureReadWaitMicros = 0;
+
+static void startPipeline(FilePipeline &pipeline,
+    vector<filesystem::path> const& paths)
+{
+    static bool warned = false;
+    if (!pipeline.start(paths) && !warned) {
+        cerr << "W: couldn't start the read-ahead thread, reading files "
+            "one by one" << endl;
+        warned = true;
+    }
+}
+
+static bool nextFile(FilePipeline &pipeline, FilePipeline::File &file) {
+    u64 start = gettime();
+    bool available = pipeline.next(file);
+    textureReadWaitMicros += diff_usec(start, gettime());
+    if (available) {
+        textureBytesRead += file.size;
+    }
+    return available;
+}
+
 class TexturePack {
 public:
-    TexturePack() {}
-    bool load(filesystem::path const& path) {
+    TexturePack(): m_preview(NULL), m_displayLists(NULL) {}
+    // Unless indexed is set, this probes the folder and records the
+    // graphics kind and the files used in record. Files are read through
+    // pipeline, which keeps its buffers from one mascot to the next.
+    bool load(filesystem::path const& path, LibraryIndex::Mascot &record,
+        bool indexed, FilePipeline &pipeline)
+    {
+        TRACE_ZONE("TexturePack::load");
         if (m_sprites.size() != 0) {
             return false;
         }
         auto imgPath = path / "img";
         auto texPath = path / "textures";
-        if (filesystem::is_directory(texPath)) {
+        // the file each sprite came from, relative to path
+        std::pmr::map<std::string, std::string> spriteFiles {
+            loadResource() };
+        if (!indexed) {
+            if (filesystem::is_directory(texPath)) {
+                record.graphics = LibraryIndex::GraphicsQutex;
+            }
+            else if (filesystem::is_directory(imgPath)) {
+                record.graphics = LibraryIndex::GraphicsPNG;
+            }
+            else {
+                record.graphics = LibraryIndex::GraphicsNone;
+            }
+        }
+        if (record.graphics == LibraryIndex::GraphicsQutex) {
+            if (!indexed) {
+                // the folder itself is recorded so that added or removed
+                // sheets show up as a changed mtime
+                record.files.push_back({ "textures", 0, 0, true });
+                for (auto &entry : filesystem::directory_iterator { texPath }) {
+                    if (entry.is_regular_file()) {
+                        record.files.push_back({ "textures/" +
+                            entry.path().filename().string(), 0, 0 });
+                    }
+                }
+            }
+            // Collect the sprite layout first so that every sheet can be
+            // read ahead while the previous one is being decoded
+            // width and height are the canvas size, see QutexSprite
+            struct Sheet {
+                filesystem::path path;
+                int width, height;
+            };
+            struct SheetSprite {
+                size_t sheet;
+                int x, y;
+                qutex::sprite_info info;
+            };
+            std::pmr::vector<Sheet> sheets { loadResource() };
+            std::pmr::vector<SheetSprite> sheetSprites { loadResource() };
+            std::pmr::map<std::pmr::string, size_t> sheetIndices {
+                loadResource() };
+            size_t currentSheet = 0;
             qutex::reader reader { texPath };
-            GRRLIB_texImg *currentTexture = NULL;
-            map<filesystem::path, GRRLIB_texImg *> textures;
-            int cw, ch;
             reader.read_all_sprites(
                 [&](std::filesystem::path path, int width, int height) {
-                    if (textures.count(path) == 0) {
-                        currentTexture = textures[path] =
-                            GRRLIB_LoadTextureFromFile(path.c_str());
-                        cw = width;
-                        ch = height;
-                        if (currentTexture == NULL) {
-                            cerr << "W: couldn't load: " << path << endl;
-                            showConsoleNow();
-                        }
+                    std::pmr::string key { path.native(), loadResource() };
+                    auto iter = sheetIndices.find(key);
+                    if (iter == sheetIndices.end()) {
+                        currentSheet = sheetIndices[key] = sheets.size();
+                        sheets.push_back({ path, width, height });
                     }
                     else {
-                        currentTexture = textures.at(path);
+                        currentSheet = iter->second;
                     }
                 },
                 [&](int x, int y, qutex::sprite_info const& info) {
-                    auto sprite = new MascotSpriteQutex { currentTexture,
-                        cw, ch, x, y, info.width, info.height, info.offset_x,
-                        info.offset_y, info.real_width, info.real_height };
-                    auto name = info.name;
-                    asciitolower(name);
-                    if (m_sprites.count(name) != 0) {
-                        cerr << "W: duplicate sprites: " << name << endl;
-                        showConsoleNow();
-                        delete m_sprites.at(name);
-                    }
-                    m_sprites[name] = sprite;
+                    sheetSprites.push_back({ currentSheet, x, y, info });
                 }
             );
+            vector<filesystem::path> sheetPaths;
+            for (auto &sheet : sheets) {
+                sheetPaths.push_back(sheet.path);
+            }
+            // sheets are decoded when they are first drawn
+            std::pmr::vector<TextureSlot *> slots { loadResource() };
+            FilePipeline::File file;
+            startPipeline(pipeline, sheetPaths);
+            while (nextFile(pipeline, file)) {
+                auto &sheet = sheets[slots.size()];
+                TextureSlot *slot = nullptr;
+                if (file.ok) {
+                    m_sheets.push_back(make_unique<TextureSlot>(file.data,
+                        file.size));
+                    slot = m_sheets.back().get();
+                }
+                else {
+                    cerr << "W: couldn't load: " << sheet.path << endl;
+                    showConsoleNow();
+                }
+                slots.push_back(slot);
+            }
+            for (auto &sheetSprite : sheetSprites) {
+                auto slot = slots[sheetSprite.sheet];
+                auto &sheet = sheets[sheetSprite.sheet];
+                auto &info = sheetSprite.info;
+                if (slot == nullptr) {
+                    continue;
+                }
+                auto geometry = QutexSprite::fromReader(sheet.width,
+                    sheet.height, sheetSprite.x, sheetSprite.y, info.width,
+                    info.height, info.offset_x, info.offset_y);
+                auto sprite = new MascotSpriteQutex { slot, geometry,
+                    info.real_width, info.real_height };
+                auto name = info.name;
+                asciitolower(name);
+                if (m_sprites.count(name) != 0) {
+                    cerr << "W: duplicate sprites: " << name << endl;
+                    showConsoleNow();
+                    delete m_sprites.at(name);
+                }
+                m_sprites[name] = sprite;
+                spriteFiles[name] = "textures/" +
+                    sheet.path.filename().string();
+            }
+            // the quads never change, so they are recorded once here
+            // instead of being sent vertex by vertex on every draw
+            m_displayLists = (u8 *)memalign(32,
+                m_sprites.size() * 2 * spriteQuadListSize);
+            if (m_displayLists != NULL) {
+                u8 *list = m_displayLists;
+                for (auto &pair : m_sprites) {
+                    static_cast<MascotSpriteQutex *>(pair.second)
+                        ->buildDisplayLists(list);
+                    list += 2 * spriteQuadListSize;
+                }
+            }
         }
-        else if (filesystem::is_directory(imgPath)) {
-            filesystem::directory_iterator imgIterator { imgPath };
-            for (auto &entry : imgIterator) {
-                auto path = entry.path();
-                if (!entry.is_regular_file() || path.extension() != ".png") {
+        else if (record.graphics == LibraryIndex::GraphicsPNG) {
+            vector<filesystem::path> pngPaths;
+            if (indexed) {
+                for (auto &file : record.files) {
+                    if (file.path.compare(0, 4, "img/") == 0) {
+                        pngPaths.push_back(path / file.path);
+                    }
+                }
+            }
+            else {
+                record.files.push_back({ "img", 0, 0, true });
+                filesystem::directory_iterator imgIterator { imgPath };
+                for (auto &entry : imgIterator) {
+                    auto path = entry.path();
+                    if (!entry.is_regular_file() || path.extension() != ".png") {
+                        continue;
+                    }
+                    pngPaths.push_back(path);
+                    record.files.push_back({ "img/" +
+                        path.filename().string(), 0, 0 });
+                }
+            }
+            FilePipeline::File file;
+            startPipeline(pipeline, pngPaths);
+            for (auto &path : pngPaths) {
+                if (!nextFile(pipeline, file)) {
+                    break;
+                }
+                if (!file.ok) {
+                    cerr << "W: couldn't load: " << path << endl;
+                    showConsoleNow();
                     continue;
                 }
                 std::string name = path.stem();
@@ -369,10 +913,12 @@ public:
                     cerr << "W: duplicate sprites: " << name << endl;
                     showConsoleNow();
                     delete m_sprites.at(name);
+                    m_sprites.erase(name);
                 }
-                auto png = new MascotSpritePNG { path };
+                auto png = new MascotSpritePNG { path, file.data, file.size };
                 if (png->valid()) {
                     m_sprites[name] = png;
+                    spriteFiles[name] = "img/" + path.filename().string();
                 }
                 else {
                     delete png;
@@ -382,72 +928,208 @@ public:
         cout << "image count: " << m_sprites.size() << endl;
         for (auto &pair : m_sprites) {
             m_preview = pair.second;
+            if (!indexed) {
+                record.preview = spriteFiles[pair.first];
+            }
             break;
         }
         return (m_sprites.size() > 0);
     }
     void clear() {
-        std::set<GRRLIB_texImg *> qutexTextures; //FIXME: this is bad
         for (auto &pair : m_sprites) {
-            auto qutex = dynamic_cast<MascotSpriteQutex *>(pair.second);
-            if (qutex != nullptr) {
-                qutexTextures.insert(qutex->texture());
-            }
             delete pair.second;
         }
-        for (auto tex : qutexTextures) {
-            GRRLIB_FreeTexture(tex);
-        }
         m_sprites.clear();
+        m_sheets.clear();
+        free(m_displayLists);
+        m_displayLists = NULL;
+    }
+    // Frees the decoded textures, they are decoded again when drawn
+    void evict() {
+        for (auto &pair : m_sprites) {
+            pair.second->slot()->release();
+        }
     }
-    MascotSprite *preview() {
+    MascotSprite *preview() const {
         return m_preview;
     }
-    const MascotSprite *sprite(string const& name) const {
-        auto stem = (filesystem::path { name }).stem();
-        if (m_sprites.count(stem)) {
-            return m_sprites.at(stem);
+    void addMemory(MascotMemory &memory) const {
+        size_t qutexCount = 0;
+        for (auto &pair : m_sprites) {
+            // red-black tree node: 3 links, a color and the pair
+            memory.spriteMap += 4 * sizeof(void *) + sizeof(pair) +
+                pair.first.capacity() + 1;
+            auto qutex = dynamic_cast<MascotSpriteQutex *>(pair.second);
+            auto png = dynamic_cast<MascotSpritePNG *>(pair.second);
+            if (qutex != nullptr) {
+                memory.spriteMap += sizeof(*qutex);
+                ++qutexCount;
+            }
+            else if (png != nullptr) {
+                auto slot = png->slot();
+                memory.spriteMap += sizeof(*png) + sizeof(*slot);
+                memory.pngTextures += slot->decodedBytes();
+                memory.textureFiles += slot->encodedBytes();
+            }
         }
-        else {
-            return NULL;
+        for (auto &sheet : m_sheets) {
+            memory.spriteMap += sizeof(*sheet);
+            memory.qutexTextures += sheet->decodedBytes();
+            memory.textureFiles += sheet->encodedBytes();
+        }
+        if (m_displayLists != NULL) {
+            memory.displayLists += qutexCount * 2 * spriteQuadListSize;
+        }
+    }
+    const MascotSprite *sprite(string_view name) const {
+        // called for every mascot on every frame, so this avoids
+        // building a path or a lowercase copy on the heap
+        char buffer[256];
+        auto key = spriteKey(name, buffer, sizeof(buffer));
+        if (key.data() == NULL) {
+            string copy { filesystem::path { name }.stem().string() };
+            asciitolower(copy);
+            return findSprite(copy);
         }
+        return findSprite(key);
     }
     ~TexturePack() {
         clear();
     }
 private:
-    map<string, MascotSprite *> m_sprites;
+    const MascotSprite *findSprite(string_view stem) const {
+        auto iter = m_sprites.find(stem);
+        if (iter != m_sprites.end()) {
+            return iter->second;
+        }
+        else {
+            return NULL;
+        }
+    }
+    map<string, MascotSprite *, less<>> m_sprites;
+    vector<unique_ptr<TextureSlot>> m_sheets;
     MascotSprite *m_preview;
+    u8 *m_displayLists;
 };
 
-class MascotData {
+class MascotData : public ThumbnailSource {
 public:
-    MascotData(): m_valid(false) {}
+    MascotData(): m_valid(false), m_removed(false),
+        m_tmplKind(TemplateNone) {}
     bool valid() const {
         return m_valid;
     }
+    // Sent by a reload in place of a mascot whose folder is gone
+    void markRemoved(string const& name) {
+        m_name = name;
+        m_removed = true;
+    }
+    bool removed() const {
+        return m_removed;
+    }
     string const& name() const {
         return m_name;
     }
-    bool load(filesystem::path const& path, std::string const& name,
-        shijima::mascot::factory &factory)
+    // Reads the template and the textures. This does not touch the
+    // factory so it can run on the loader thread. If indexed is set,
+    // the files listed in record are used without probing the folder,
+    // otherwise record is filled in from what was found.
+    bool load(filesystem::path const& path, LibraryIndex::Mascot &record,
+        bool indexed, FilePipeline &pipeline)
     {
+        TRACE_ZONE("MascotData::load");
         auto actionsPath = path / "actions.xml";
         auto behaviorsPath = path / "behaviors.xml";
         auto cerealPath = path / "mascot.cereal";
-        m_name = name;
-        if (filesystem::is_regular_file(cerealPath)) {
+        m_name = record.name;
+        if (!indexed) {
+            record.files.clear();
+            record.preview.clear();
+            if (filesystem::is_regular_file(cerealPath)) {
+                record.tmpl = LibraryIndex::TemplateCereal;
+                record.files.push_back({ "mascot.cereal", 0, 0 });
+            }
+            #if !defined(SHIJIMA_NO_PUGIXML)
+            else if (filesystem::is_regular_file(actionsPath) &&
+                filesystem::is_regular_file(behaviorsPath))
+            {
+                record.tmpl = LibraryIndex::TemplateXML;
+                record.files.push_back({ "actions.xml", 0, 0 });
+                record.files.push_back({ "behaviors.xml", 0, 0 });
+            }
+            #endif
+            else {
+                record.tmpl = LibraryIndex::TemplateNone;
+            }
+        }
+        if (record.tmpl == LibraryIndex::TemplateCereal) {
             cout << "Loading with mascot.cereal: " << m_name << endl;
             showConsoleNow();
-            std::string data;
-            if (!readFile(cerealPath, data)) {
+            if (!readFile(cerealPath, m_cerealTmpl.data)) {
+                return m_valid = false;
+            }
+            m_cerealTmpl.name = m_name;
+            m_tmplKind = TemplateCereal;
+        }
+        #if !defined(SHIJIMA_NO_PUGIXML)
+        else if (record.tmpl == LibraryIndex::TemplateXML) {
+            cout << "Loading with XML files: " << m_name << endl;
+            showConsoleNow();
+            if (!readFile(actionsPath, m_xmlTmpl.actions_xml) ||
+                !readFile(behaviorsPath, m_xmlTmpl.behaviors_xml))
+            {
                 return m_valid = false;
             }
+            m_xmlTmpl.name = m_name;
+            m_tmplKind = TemplateXML;
+        }
+        #endif
+        else {
+            cerr << "ERROR: Missing files for: " << m_name << endl;
+            showConsoleNow();
+        }
+        m_graphics.clear();
+        m_valid = m_graphics.load(path, record, indexed, pipeline);
+        if (!indexed) {
+            LibraryIndex::statFiles(path.string(), record);
+            // thumbnails of indexed mascots were written with the index
+            const u8 *file;
+            size_t size;
+            SpriteRegion region;
+            if (m_valid && (!thumbnailImage(file, size, region) ||
+                !writeThumbnail(file, size, region, thumbnailPath())))
+            {
+                cerr << "W: couldn't write thumbnail for " << m_name << endl;
+            }
+        }
+        // the loader thread decodes outside of the texture cache
+        m_graphics.evict();
+        return m_valid;
+    }
+    virtual string thumbnailPath() const {
+        return THUMBNAIL_LOCATION "/" + m_name + ".png";
+    }
+    virtual bool thumbnailImage(const u8 *&file, size_t &size,
+        SpriteRegion &region) const
+    {
+        auto preview = m_graphics.preview();
+        if (preview == nullptr) {
+            return false;
+        }
+        file = preview->slot()->fileData();
+        size = preview->slot()->fileSize();
+        region = preview->region();
+        return true;
+    }
+    // Registers the template read by load(). Main thread only.
+    bool registerTemplate(shijima::mascot::factory &factory) {
+        TRACE_ZONE("register_template");
+        if (m_tmplKind == TemplateCereal) {
             try {
-                shijima::mascot::factory::registered_tmpl tmpl;
-                tmpl.name = m_name;
-                tmpl.data = std::move(data);
-                factory.register_template(tmpl);
+                AllocScope scope;
+                factory.register_template(m_cerealTmpl);
+                m_templateBytes = max(scope.bytes(), 0L);
+                m_cerealTmpl = {};
             }
             catch (std::exception &ex) {
                 cerr << "ERROR: Deserialize failed for " << m_name << endl;
@@ -456,23 +1138,12 @@ public:
             }
         }
         #if !defined(SHIJIMA_NO_PUGIXML)
-        else if (filesystem::is_regular_file(actionsPath) &&
-            filesystem::is_regular_file(behaviorsPath))
-        {
-            cout << "Loading with XML files: " << m_name << endl;
-            showConsoleNow();
-            std::string actions, behaviors;
-            if (!readFile(actionsPath, actions) ||
-                !readFile(behaviorsPath, behaviors))
-            {
-                return m_valid = false;
-            }
+        else if (m_tmplKind == TemplateXML) {
             try {
-                shijima::mascot::factory::tmpl tmpl;
-                tmpl.actions_xml = std::move(actions);
-                tmpl.behaviors_xml = std::move(behaviors);
-                tmpl.name = m_name;
-                factory.register_template(tmpl);
+                AllocScope scope;
+                factory.register_template(m_xmlTmpl);
+                m_templateBytes = max(scope.bytes(), 0L);
+                m_xmlTmpl = {};
             }
             catch (std::exception &ex) {
                 cerr << "ERROR: Parse failed for " << m_name << endl;
@@ -481,53 +1152,100 @@ public:
             }
         }
         #endif
-        else {
-            cerr << "ERROR: Missing files for: " << m_name << endl;
-            showConsoleNow();
-        }
-        m_graphics.clear();
-        return m_valid = m_graphics.load(path);
+        m_tmplKind = TemplateNone;
+        return m_valid;
     }
-    const MascotSprite *sprite(string const& name) const {
+    const MascotSprite *sprite(string_view name) const {
         return m_graphics.sprite(name);
     }
     const MascotSprite *preview() {
         return m_graphics.preview();
     }
+    MascotMemory memory() const {
+        MascotMemory memory;
+        m_graphics.addMemory(memory);
+        memory.tmpl = m_templateBytes;
+        memory.instance = m_instanceBytes;
+        return memory;
+    }
+    void setInstanceBytes(long bytes) {
+        m_instanceBytes = max(bytes, 0L);
+    }
+    // Whether the objects of a new instance can come from the instance
+    // slabs. Not for the first spawn of the template: whatever
+    // libshijima builds and keeps for the template on that spawn would
+    // pin slab pages for as long as the template is loaded.
+    bool useInstanceSlabs() {
+        bool spawned = m_spawned;
+        m_spawned = true;
+        return spawned;
+    }
 private:
     bool m_valid;
+    bool m_removed;
+    size_t m_templateBytes = 0;
+    size_t m_instanceBytes = 0;
+    bool m_spawned = false;
     string m_name;
     TexturePack m_graphics;
+    enum { TemplateNone, TemplateCereal, TemplateXML } m_tmplKind;
+    shijima::mascot::factory::registered_tmpl m_cerealTmpl;
+    #if !defined(SHIJIMA_NO_PUGIXML)
+    shijima::mascot::factory::tmpl m_xmlTmpl;
+    #endif
 };
 
-static map<string, MascotData> loadedMascots;
+static map<string, unique_ptr<MascotData>> loadedMascots;
 static vector<MascotData *> loadedMascotsList;
 static unique_ptr<shijima::mascot::factory> mascotFactory;
 static shared_ptr<shijima::mascot::environment> mascotEnv;
 static bool showBoundaries = false;
+static uint32_t lastFrameAllocations = 0;
+static uint32_t lastFrameMicros = 0;
+static unsigned culledSprites = 0;
+static unsigned drawnSprites = 0;
+static u64 spriteDrawTicks = 0;
+static unsigned lastFrameGlyphs = 0;
+static unsigned lastFrameTextDraws = 0;
+
+class WiiMascot;
+
+// rectangles drawn in the current frame, in drawing order
+static SpatialGrid<WiiMascot *> hitGrid;
 
 class WiiMascot {
 public:
-    WiiMascot(): m_valid(false) {}
+    WiiMascot(): m_valid(false), m_lastSprite(nullptr), m_lastSlot(nullptr) {}
     WiiMascot(shijima::mascot::factory::product product, MascotData *data):
-        m_valid(true), m_product(std::move(product)), m_data(data) {}
+        m_valid(true), m_product(std::move(product)), m_data(data),
+        m_lastSprite(nullptr), m_lastSlot(nullptr) {}
     bool valid() const {
         return m_valid;
     }
     void draw() {
+        TRACE_ZONE("WiiMascot::draw");
         auto &mascot = *m_product.manager;
         auto anchor = mascot.state->anchor;
         auto pos = anchor;
         auto &frame = mascot.state->active_frame;
         bool mirroredRender = mascot.state->looking_right &&
             frame.right_name.empty();
-        auto name = frame.get_name(mascot.state->looking_right);
-        asciitolower(name);
+        // same as frame.get_name() without copying the name
+        auto const& name = (mascot.state->looking_right &&
+            !frame.right_name.empty()) ? frame.right_name : frame.name;
         auto sprite = m_data->sprite(name);
         m_lastSprite = sprite;
         if (sprite == NULL) {
             return;
         }
+        // teaches the texture cache which texture comes next
+        auto slot = sprite->slot();
+        if (slot != m_lastSlot) {
+            if (m_lastSlot != nullptr) {
+                textureCache.follow(m_lastSlot, slot);
+            }
+            m_lastSlot = slot;
+        }
         m_lastRenderMirrored = mirroredRender;
         bool flip;
         if (mirroredRender) {
@@ -543,7 +1261,25 @@ public:
         if (mirroredRender) {
             m_lastPos.x -= sprite->width();
         }
-        sprite->draw(pos.x, pos.y, flip);
+        hitGrid.insert(this, m_lastPos.x, m_lastPos.y, m_lastPos.width,
+            m_lastPos.height);
+        if (m_lastPos.x >= rmode->fbWidth || m_lastPos.y >= rmode->efbHeight ||
+            m_lastPos.x + m_lastPos.width <= 0 ||
+            m_lastPos.y + m_lastPos.height <= 0)
+        {
+            // off screen, only the hit testing state is kept up to date
+            ++culledSprites;
+            return;
+        }
+#ifndef NDEBUG
+        // two timer reads per sprite, so only debug builds time draws
+        u64 drawStart = gettime();
+        drawSprite(sprite, pos.x, pos.y, flip);
+        spriteDrawTicks += gettime() - drawStart;
+#else
+        drawSprite(sprite, pos.x, pos.y, flip);
+#endif
+        ++drawnSprites;
         if (showBoundaries) {
             GRRLIB_Rectangle(m_lastPos.x, m_lastPos.y, m_lastPos.width,
                 m_lastPos.height, 0x0000FFFF, false);
@@ -552,6 +1288,7 @@ public:
         }
     }
     void tick() {
+        TRACE_ZONE("WiiMascot::tick");
         auto &mascot = *m_product.manager;
         mascot.tick();
     }
@@ -561,12 +1298,37 @@ public:
     MascotData *data() const {
         return m_data;
     }
+    // Moves this mascot to product, spawned from a reloaded template.
+    // It stays where it is and keeps facing the same way, its behavior
+    // starts over.
+    void replace(shijima::mascot::factory::product product, MascotData *data) {
+        auto &oldState = *m_product.manager->state;
+        auto &newState = *product.manager->state;
+        newState.anchor = oldState.anchor;
+        newState.looking_right = oldState.looking_right;
+        newState.dragging = oldState.dragging;
+        m_product = std::move(product);
+        m_data = data;
+        m_lastSprite = nullptr;
+        m_lastSlot = nullptr;
+        m_shown = {};
+    }
     bool pointInside(double x, double y) {
         return x >= m_lastPos.x && x < (m_lastPos.x + m_lastPos.width) &&
             y >= m_lastPos.y && y < (m_lastPos.y + m_lastPos.height) &&
             pointInsideSprite(x - m_lastPos.x, y - m_lastPos.y);
     }
 private:
+    // While the texture of sprite waits to be decoded, the last frame
+    // that was drawn stays on screen
+    void drawSprite(const MascotSprite *sprite, f32 x, f32 y, bool flip) {
+        if (sprite->draw(x, y, flip)) {
+            m_shown = { sprite, x, y, flip };
+        }
+        else if (m_shown.sprite != nullptr) {
+            m_shown.sprite->draw(m_shown.x, m_shown.y, m_shown.flip);
+        }
+    }
     bool pointInsideSprite(int x, int y) {
         if (m_lastSprite == nullptr) {
             return false;
@@ -580,37 +1342,54 @@ private:
     shijima::mascot::factory::product m_product;
     MascotData *m_data;
     const MascotSprite *m_lastSprite;
+    TextureSlot *m_lastSlot;
     bool m_lastRenderMirrored;
     shijima::math::rec m_lastPos;
+    struct {
+        const MascotSprite *sprite;
+        f32 x, y;
+        bool flip;
+    } m_shown {};
 };
 
-bool discoverMascots() {
-    if (!filesystem::is_directory(MASCOT_LOCATION)) {
-        die(MASCOT_LOCATION " missing!");
-        return false;
-    }
-    filesystem::directory_iterator iter { MASCOT_LOCATION };
-    mascotFactory = make_unique<shijima::mascot::factory>();
-    for (auto &entry : iter) {
-        if (!entry.is_directory()) {
-            continue;
-        }
-        auto path = entry.path();
-        if (path.extension() != ".mascot") {
-            continue;
-        }
-        auto name = path.stem();
-        auto &mascot = loadedMascots[name];
-        if (!mascot.load(path, name, *mascotFactory)) {
-            loadedMascots.erase(name);
-        }
-    }
-    for (auto &pair : loadedMascots) {
-        loadedMascotsList.push_back(&pair.second);
+static u64 bootTime;
+// set by shijimaWiiTick() once mascots have ticked while taking input,
+// and once that was logged
+static bool tickedWithInput = false;
+static bool reportedInteractive = false;
+// start of the current load, the boot or a reload
+static u64 loaderStart;
+static bool reloading = false;
+
+// Size of the arena for load temporaries. It is taken from the heap
+// while the loader runs and given back as one block afterwards. Set it
+// to 0 to allocate the temporaries from the heap.
+#ifndef LOAD_ARENA_SIZE
+#define LOAD_ARENA_SIZE (4 * 1024 * 1024)
+#endif
+
+// Runs on the loader thread, see MascotLoader::Load
+static MascotData *loadMascot(string const& dir, LibraryIndex::Mascot &record,
+    bool indexed, FilePipeline &pipeline)
+{
+    unique_ptr<MascotData> mascot { new MascotData };
+    if (!mascot->load(dir, record, indexed, pipeline)) {
+        return nullptr;
     }
-    return loadedMascots.size() > 0;
+    return mascot.release();
+}
+
+static MascotData *removedMascot(string const& name) {
+    auto marker = new MascotData;
+    marker->markRemoved(name);
+    return marker;
 }
 
+// Mascots show up in receiveMascots() as they finish loading
+static MascotLoader<MascotData> loader {{ MASCOT_LOCATION, INDEX_PATH,
+    { CACHE_LOCATION, THUMBNAIL_LOCATION }, LOAD_ARENA_SIZE, loadMascot,
+    removedMascot, consoleStream }};
+
 void updateEnvironment() {
     auto &env = *mascotEnv;
     double width = rmode->fbWidth, height = rmode->efbHeight;
@@ -624,7 +1403,676 @@ void updateEnvironment() {
 static list<WiiMascot *> mascots;
 static WiiMascot *dragged = nullptr;
 
-WiiMascot *findMascot(double x, double y) {
+// Region for the small objects of mascot instances, see SlabPool
+#ifndef INSTANCE_SLAB_SIZE
+#define INSTANCE_SLAB_SIZE (2 * 1024 * 1024)
+#endif
+
+static SpawnLatency prototypeSpawns;
+static SpawnLatency fullSpawns;
+
+// microseconds, for IdleScheduler and what it runs
+static uint64_t idleClock() {
+    return ticks_to_microsecs(gettime());
+}
+
+// Products spawned ahead of time that have never ticked, one per
+// template that has been spawned before. The next spawn of the template
+// takes its spare instead of building a new manager. Spares are built in
+// idle time, see startIdleJobs().
+static PrototypePool<MascotData *, shijima::mascot::factory::product>
+    prototypes { idleClock };
+
+static bool takePrototype(MascotData *data, string const&,
+    shijima::mascot::factory::product &product, size_t &bytes)
+{
+    return prototypes.take(data, product, bytes);
+}
+
+// The child of a breed request starts where the request says and faces
+// the same way, like a mascot moved by WiiMascot::replace(). Spawns by
+// name place their mascot themselves, see spawnMascot(). A spare has
+// already picked its first behavior, so requests that name one take the
+// full path. Others would pick one the same way, only on an earlier
+// frame, which the input trace records, see traceInput().
+static bool takePrototype(MascotData *data,
+    shijima::mascot::breed_request_t const& request,
+    shijima::mascot::factory::product &product, size_t &bytes)
+{
+    if (!request.behavior.empty() ||
+        !prototypes.take(data, product, bytes))
+    {
+        return false;
+    }
+    auto &state = *product.manager->state;
+    state.anchor = request.anchor;
+    state.looking_right = request.looking_right;
+    return true;
+}
+
+// Builds one missing spare, returns false if none was missing
+static bool refillPrototype() {
+    return prototypes.refill([](MascotData *data, size_t &bytes) {
+        AllocScope scope;
+        SlabScope slabScope { data->useInstanceSlabs() };
+        auto product = mascotFactory->spawn(data->name());
+        bytes = max(scope.bytes(), 0L);
+        return product;
+    });
+}
+
+// Spawns a mascot of data from request, a template name or a breed
+// request, and adds it to mascots. Spawns take the template's spare if
+// one is ready, see takePrototype(). Callers that spawn by name set the
+// position, a spare has never been placed. The heap taken by the new instance
+// is recorded for the memory page, and its small objects come from the
+// instance slabs, see MascotData::useInstanceSlabs(). Only the instance
+// itself is built in the slabs: the lists that point to it live as long
+// as the scene, not as the mascot.
+template<typename Request>
+static WiiMascot *spawnMascot(MascotData *data, Request const& request) {
+    TRACE_ZONE("spawn");
+    u64 start = gettime();
+    AllocScope scope;
+    shijima::mascot::factory::product product {};
+    size_t prototypeBytes = 0;
+    bool fast = takePrototype(data, request, product, prototypeBytes);
+    WiiMascot *mascot;
+    {
+        SlabScope slabScope { data->useInstanceSlabs() };
+        if (!fast) {
+            product = mascotFactory->spawn(request);
+        }
+        mascot = new WiiMascot { std::move(product), data };
+    }
+    mascots.push_back(mascot);
+    data->setInstanceBytes(scope.bytes() + prototypeBytes);
+    u32 micros = ticks_to_microsecs(gettime() - start);
+    (fast ? prototypeSpawns : fullSpawns).add(micros);
+    if (!fast) {
+        // what the next refill of the template should take
+        prototypes.measured(data, micros);
+    }
+    return mascot;
+}
+
+// mascots must already be removed from the mascots list
+static void destroyMascot(WiiMascot *mascot) {
+    if (mascot == dragged) {
+        dragged = nullptr;
+    }
+    hitGrid.remove(mascot);
+    delete mascot;
+}
+
+// mascots of the last session that are waiting for their template
+static SceneSnapshot savedScene;
+static size_t restoredMascots = 0;
+static u64 restoreTicks = 0;
+
+static void readSavedScene(const char *path) {
+    u64 start = gettime();
+    if (!savedScene.read(path)) {
+        savedScene.mascots.clear();
+        return;
+    }
+    if (savedScene.screenWidth != rmode->fbWidth ||
+        savedScene.screenHeight != rmode->efbHeight)
+    {
+        cout << "Screen size changed, not restoring the last session" << endl;
+        savedScene.mascots.clear();
+        return;
+    }
+    cout << "Restoring " << savedScene.mascots.size() << " mascots (read in "
+        << diff_usec(start, gettime()) / 1000 << " ms)" << endl;
+}
+
+// The mascots on screen, and the saved ones whose template hasn't
+// loaded, or didn't load this time
+static SceneSnapshot currentScene() {
+    SceneSnapshot scene;
+    scene.screenWidth = rmode->fbWidth;
+    scene.screenHeight = rmode->efbHeight;
+    scene.mascots.reserve(mascots.size() + savedScene.mascots.size());
+    for (auto mascot : mascots) {
+        auto &state = *mascot->manager().state;
+        if (state.dead) {
+            continue;
+        }
+        scene.mascots.push_back({ mascot->data()->name(), state.anchor.x,
+            state.anchor.y, state.looking_right });
+    }
+    for (auto &saved : savedScene.mascots) {
+        scene.mascots.push_back(saved);
+    }
+    return scene;
+}
+
+static void writeSavedScene() {
+    u64 start = gettime();
+    SceneSnapshot scene = currentScene();
+    if (!scene.write(SCENE_PATH)) {
+        cerr << "W: couldn't write " SCENE_PATH << endl;
+        return;
+    }
+    cout << "Saved " << scene.mascots.size() << " mascots in "
+        << diff_usec(start, gettime()) / 1000 << " ms" << endl;
+}
+
+// Spawns the saved mascots that use data. Their behavior starts over,
+// only the position and the direction are restored.
+static size_t restoreSavedMascots(MascotData *data) {
+    u64 start = gettime();
+    auto &saved = savedScene.mascots;
+    size_t kept = 0, restored = 0;
+    for (size_t i=0; i<saved.size(); ++i) {
+        if (saved[i].name != data->name()) {
+            if (kept != i) {
+                saved[kept] = std::move(saved[i]);
+            }
+            ++kept;
+            continue;
+        }
+        auto mascot = spawnMascot(data, data->name());
+        auto &state = *mascot->manager().state;
+        state.anchor = { saved[i].x, saved[i].y };
+        state.looking_right = saved[i].lookingRight;
+        ++restored;
+    }
+    saved.resize(kept);
+    restoredMascots += restored;
+    restoreTicks += gettime() - start;
+    return restored;
+}
+
+static_assert(VI_PAL == videoFormatPal, "see video_timing.hpp");
+
+// Every session is recorded to TRACE_PATH from the moment the title
+// screen is gone. Copying it and TRACE_SCENE_PATH to REPLAY_PATH and
+// REPLAY_SCENE_PATH makes the next boots play it back instead of
+// reading the Wiimote, to profile exactly that session.
+//
+// Mascots hold still until the trace starts, so TRACE_SCENE_PATH,
+// written then, is the state a replay starts from. Loading goes on
+// while the session runs: the trace records which frame every mascot
+// from the loader arrived before, and a replay waits for the loader
+// where it has to. Whatever else the simulation depends on goes into
+// the trace header.
+static InputTraceWriter traceWriter;
+static InputTraceReader traceReader;
+static bool replayMode = false;
+static bool replaying = false;
+static bool traceStarted = false;
+static InputFrame traceFrame;
+static u32 traceSeed = 0;
+// spares built and mascots taken from the loader up to the last traced
+// frame
+static uint64_t tracedRefills = 0;
+static u32 tracedArrivals = 0;
+// every mascot taken from the loader, see receiveMascots()
+static u32 receivedMascots = 0;
+// state of shijimaWiiTick()
+static bool didStart = false;
+static bool pickerVisible = false;
+// 60 Hz modes skip every 6th tick to keep 50 ticks/s, see
+// nextTickPhase()
+static uint8_t ntscFrameCounter = 0;
+static uint32_t replayHash = 0;
+static long replayDivergedAt = -1;
+
+static void openInputTrace() {
+    traceSeed = (u32)gettime();
+    if (traceReader.open(REPLAY_PATH)) {
+        if (traceReader.header().width != rmode->fbWidth ||
+            traceReader.header().height != rmode->efbHeight)
+        {
+            cerr << "W: " REPLAY_PATH " was recorded in another video mode"
+                << endl;
+        }
+        else {
+            replayMode = replaying = true;
+            traceSeed = traceReader.header().seed;
+            cout << "Replaying " REPLAY_PATH << endl;
+        }
+    }
+    srand(traceSeed);
+}
+
+// How many mascots receiveMascots() may have taken by the end of this
+// frame. A replay takes what the recording had.
+static u32 arrivalLimit() {
+    if (!replaying) {
+        return UINT32_MAX;
+    }
+    if (!traceStarted) {
+        return traceReader.header().mascots;
+    }
+    return tracedArrivals + traceFrame.arrivals;
+}
+
+// hash of everything the input can influence
+static uint32_t simulationHash() {
+    uint32_t hash = fnv1aBasis;
+    for (auto mascot : mascots) {
+        auto &state = *mascot->manager().state;
+        auto &name = mascot->data()->name();
+        auto &frame = state.active_frame.name;
+        uint8_t flags = (state.looking_right ? 1 : 0) |
+            (state.dragging ? 2 : 0) | (state.dead ? 4 : 0);
+        hash = fnv1a(hash, name.data(), name.size());
+        hash = fnv1a(hash, &state.anchor.x, sizeof(state.anchor.x));
+        hash = fnv1a(hash, &state.anchor.y, sizeof(state.anchor.y));
+        hash = fnv1a(hash, &flags, sizeof(flags));
+        hash = fnv1a(hash, frame.data(), frame.size());
+    }
+    return hash;
+}
+
+static void finishReplay() {
+    replaying = false;
+    cout << "Replay finished after " << traceReader.frames() << " frames";
+    if (replayDivergedAt >= 0) {
+        cout << ", diverged at frame " << replayDivergedAt << endl;
+    }
+    else {
+        cout << ", no divergence" << endl;
+    }
+}
+
+// Records this frame's input, or replaces it with the recorded one.
+// Called before receiveMascots(), which takes the mascots of the frame.
+static void traceInput(struct ir_t &ir, u32 &down, u32 &held, u32 &up) {
+    if (!traceStarted && !didStart) {
+        return;
+    }
+    // a replay starts with the mascots the recording started with, or
+    // with all there are if the library has fewer now
+    if (!traceStarted && replaying && receivedMascots <
+        traceReader.header().mascots && !loader.drained())
+    {
+        return;
+    }
+    if (!traceStarted) {
+        traceStarted = true;
+        // Spares built before now depend on how fast the loader was, so
+        // the trace starts without any, and from the seed again
+        prototypes.clear();
+        tracedRefills = prototypes.refills();
+        tracedArrivals = receivedMascots;
+        srand(traceSeed);
+        if (replayMode) {
+            ntscFrameCounter = traceReader.header().tickPhase;
+            pickerVisible = traceReader.header().pickerVisible;
+        }
+        else {
+            TraceHeader header { traceSeed, (uint16_t)rmode->fbWidth,
+                (uint16_t)rmode->efbHeight, ntscFrameCounter, pickerVisible,
+                (uint16_t)receivedMascots };
+            if (!traceWriter.open(TRACE_PATH, header) ||
+                !currentScene().write(TRACE_SCENE_PATH))
+            {
+                cerr << "W: couldn't record to " TRACE_PATH << endl;
+            }
+        }
+    }
+    if (replaying) {
+        if (traceReader.next(traceFrame, replayHash)) {
+            ir.valid = traceFrame.irValid;
+            ir.x = traceFrame.x;
+            ir.y = traceFrame.y;
+            down = traceFrame.down;
+            held = traceFrame.held;
+            up = traceFrame.up;
+            for (u32 i=0; i<traceFrame.refills; ++i) {
+                refillPrototype();
+            }
+        }
+        else {
+            finishReplay();
+        }
+    }
+    else {
+        // spares are built in idle time, after the previous frame was
+        // recorded
+        u32 refills = prototypes.refills() - tracedRefills;
+        tracedRefills = prototypes.refills();
+        traceFrame = { ir.valid != 0, ir.x, ir.y, down, held, up, refills,
+            0 };
+    }
+}
+
+// Checks the state after a frame against the trace, or records it.
+static void traceState() {
+    if (!traceStarted) {
+        return;
+    }
+    uint32_t hash = simulationHash();
+    traceFrame.arrivals = receivedMascots - tracedArrivals;
+    tracedArrivals = receivedMascots;
+    if (replaying) {
+        if (hash != replayHash && replayDivergedAt < 0) {
+            replayDivergedAt = traceReader.frames() - 1;
+            cerr << "W: replay diverged at frame " << replayDivergedAt << endl;
+        }
+    }
+    else if (traceWriter.isOpen()) {
+        traceWriter.write(traceFrame, hash);
+    }
+}
+
+static void spawnFirstMascot(MascotData *data) {
+    spawnMascot(data, data->name())->manager().reset_position();
+}
+
+// Takes finished mascots from the loader thread. Templates have to be
+// registered here since the factory is used by the main thread.
+static void unloadMascot(MascotData *data);
+static void replaceMascot(MascotData *old, MascotData *data);
+
+// mascots loaded again and removed by the current reload
+static size_t reloadedMascots = 0;
+static size_t removedMascots = 0;
+
+static void receiveMascots() {
+    static bool didSpawn = false;
+    u32 limit = arrivalLimit();
+    MascotData *received;
+    while (receivedMascots < limit) {
+        if (!loader.pop(received)) {
+            // a replay waits for the mascots the recording had by now
+            if (!replaying || !traceStarted || loader.drained()) {
+                break;
+            }
+            sleepMillis(1);
+            continue;
+        }
+        ++receivedMascots;
+        unique_ptr<MascotData> data { received };
+        auto old = loadedMascots.find(received->name());
+        if (data->removed()) {
+            if (old != loadedMascots.end()) {
+                unloadMascot(old->second.get());
+                loadedMascots.erase(old);
+                ++removedMascots;
+            }
+            continue;
+        }
+        // The spares of a reloaded mascot were spawned from the template
+        // that the new one replaces, so they go first. Its mascots are
+        // spawned again by replaceMascot() before anything ticks.
+        if (old != loadedMascots.end()) {
+            prototypes.forget(old->second.get());
+        }
+        if (!data->registerTemplate(*mascotFactory)) {
+            continue;
+        }
+        if (reloading) {
+            ++reloadedMascots;
+        }
+        if (old != loadedMascots.end()) {
+            // every reference to the old data is switched to the new one
+            // first, as it is freed right here
+            replaceMascot(old->second.get(), received);
+            old->second = std::move(data);
+            continue;
+        }
+        loadedMascotsList.push_back(data.get());
+        loadedMascots[received->name()] = std::move(data);
+        size_t restored = restoreSavedMascots(received);
+        // with a saved scene, wait for one of its mascots instead
+        if (!didSpawn && (restored > 0 || savedScene.mascots.empty())) {
+            didSpawn = true;
+            if (restored == 0) {
+                spawnFirstMascot(received);
+            }
+            cout << "First mascot ready after "
+                << diff_usec(bootTime, gettime()) / 1000 << " ms" << endl;
+            cout << "... Press [A] to start Shijima-Wii" << endl;
+        }
+    }
+    bool finished = loader.drained();
+    if (finished && loader.running() && reloading) {
+        loader.join();
+        reloading = false;
+        cout << "Reloaded " << reloadedMascots << " and removed "
+            << removedMascots << " mascots in "
+            << diff_usec(loaderStart, gettime()) / 1000 << " ms, read "
+            << textureBytesRead / 1024 << " KiB of textures" << endl;
+    }
+    else if (finished && loader.running()) {
+        loader.join();
+        cout << "Loaded " << loadedMascots.size() << " mascots in "
+            << diff_usec(loaderStart, gettime()) / 1000 << " ms ("
+            << consoleRenders << " renders, " << skippedRenders
+            << " skipped)" << endl;
+        cout << "Read " << textureBytesRead / 1024 << " KiB of textures, "
+            << "decoding waited " << textureReadWaitMicros / 1000
+            << " ms for SD" << endl;
+        struct mallinfo heap = mallinfo();
+        cout << "Heap: " << heap.fordblks / 1024 << " KiB free in "
+            << heap.ordblks << " blocks" << endl;
+        if (restoredMascots > 0) {
+            cout << "Restored " << restoredMascots << " mascots in "
+                << ticks_to_microsecs(restoreTicks) / 1000 << " ms" << endl;
+        }
+        if (!savedScene.mascots.empty()) {
+            cout << savedScene.mascots.size() << " saved mascots are no "
+                "longer installed" << endl;
+            savedScene.mascots.clear();
+        }
+        if (!didSpawn && !loadedMascotsList.empty()) {
+            didSpawn = true;
+            spawnFirstMascot(loadedMascotsList[0]);
+            cout << "... Press [A] to start Shijima-Wii" << endl;
+        }
+        if (loadedMascots.empty()) {
+            die("Couldn't find any mascots!");
+            //FIXME: not yet
+            //cerr << "[*] You can use Shijima-Qt on a computer to prepare" << endl;
+            //cerr << "shimeji for Shijima-Wii." << endl;
+        }
+    }
+}
+
+// Time left before vsync for GRRLIB_Render() to wait for the GPU and
+// copy the frame out
+#ifndef IDLE_MARGIN_MICROS
+#define IDLE_MARGIN_MICROS 3000
+#endif
+
+static ThumbnailCache thumbnails { idleClock, consoleStream };
+
+// Work that can wait for the end of a frame, see IdleScheduler
+static IdleScheduler idleWork { idleClock };
+// frames that took longer than one vsync, and how many of them ran
+// idle work
+static u32 missedFrames = 0;
+static u32 missedFramesWithIdleWork = 0;
+
+// Rough cost of decoding and tiling a texture on the Wii, per pixel,
+// and of copying memory, per byte. Idle jobs expect these, see
+// IdleScheduler::Estimate.
+#ifndef DECODE_NANOS_PER_PIXEL
+#define DECODE_NANOS_PER_PIXEL 60
+#endif
+#ifndef COPY_NANOS_PER_BYTE
+#define COPY_NANOS_PER_BYTE 5
+#endif
+
+static u32 decodeMicros(size_t pixels) {
+    return (u32)(pixels * DECODE_NANOS_PER_PIXEL / 1000);
+}
+
+static u32 copyMicros(size_t bytes) {
+    return (u32)(bytes * COPY_NANOS_PER_BYTE / 1000);
+}
+
+static void startIdleJobs() {
+    idleWork.submit("texture prefetch", [] {
+        return textureCache.prefetch() ? IdleResult::Continue :
+            IdleResult::Yield;
+    }, [] {
+        return decodeMicros(textureCache.nextPrefetchBytes() / 4);
+    });
+    idleWork.submit("thumbnails", [] {
+        return thumbnails.loadPending() ? IdleResult::Continue :
+            IdleResult::Yield;
+    }, [] {
+        // uploading a thumbnail or copying an image for the thread
+        return max(decodeMicros(thumbnailSize * thumbnailSize),
+            copyMicros(thumbnails.nextRenderBytes()));
+    });
+    // a replay builds spares where the recording did, see traceInput()
+    idleWork.submit("prototypes", [] {
+        return !replaying && refillPrototype() ? IdleResult::Continue :
+            IdleResult::Yield;
+    }, [] {
+        return prototypes.nextCost(IdleScheduler::firstEstimateMicros);
+    });
+}
+
+static void dismissAll(MascotData *data) {
+    for (auto iter = mascots.end(); iter != mascots.begin(); ) {
+        --iter;
+        auto mascot = *iter;
+        if (mascot->data() == data) {
+            auto erasePos = iter;
+            ++iter;
+            mascots.erase(erasePos);
+            destroyMascot(mascot);
+            continue;
+        }
+    }
+}
+
+// Drops every reference to data other than loadedMascots, which the
+// caller updates.
+static void forgetMascot(MascotData *data) {
+    auto &list = loadedMascotsList;
+    list.erase(std::remove(list.begin(), list.end(), data), list.end());
+    prototypes.forget(data);
+    thumbnails.forget(data);
+}
+
+// Dismisses the mascots of data and removes its template from the
+// factory once nothing spawned from it is left
+static void unloadMascot(MascotData *data) {
+    cout << "Removed " << data->name() << endl;
+    dismissAll(data);
+    forgetMascot(data);
+    mascotFactory->deregister_template(data->name());
+}
+
+// Moves the mascots of old to data, a reload of the same mascot. The
+// template of data has been registered under the same name, which
+// replaced the one of old in the factory, see receiveMascots().
+static void replaceMascot(MascotData *old, MascotData *data) {
+    cout << "Reloaded " << data->name() << endl;
+    for (auto mascot : mascots) {
+        if (mascot->data() != old) {
+            continue;
+        }
+        shijima::mascot::factory::product product {};
+        {
+            SlabScope slabScope { data->useInstanceSlabs() };
+            product = mascotFactory->spawn(data->name());
+        }
+        mascot->replace(std::move(product), data);
+    }
+    auto iter = find(loadedMascotsList.begin(), loadedMascotsList.end(), old);
+    if (iter != loadedMascotsList.end()) {
+        *iter = data;
+    }
+    forgetMascot(old);
+}
+
+// [2] loads the mascots that changed on the SD card again, without
+// restarting. Mascots on screen switch to the new version in place.
+static void startReload() {
+    if (loader.running()) {
+        return;
+    }
+    reloadedMascots = removedMascots = 0;
+    textureBytesRead = 0;
+    textureReadWaitMicros = 0;
+    loaderStart = gettime();
+    reloading = true;
+    // a replay can't reload, so the trace ends where the library changes
+    if (traceWriter.isOpen()) {
+        traceWriter.close();
+        cout << "Recorded " << traceWriter.frames() << " frames to "
+            TRACE_PATH " up to the reload" << endl;
+    }
+    cout << "Reloading mascots..." << endl;
+    if (!loader.reload()) {
+        cerr << "W: couldn't start the loader thread" << endl;
+        reloading = false;
+    }
+}
+
+// Scrollable grid of mascot thumbnails. Only the visible rows are drawn
+// and kept resident, so this stays cheap with large libraries.
+static void tickPicker(u32 down) {
+    static int pickerIdx = 0;
+    PickerLayout layout { rmode->fbWidth, rmode->efbHeight, thumbnailSize };
+    const int columns = layout.columns;
+    const int visibleRows = layout.visibleRows;
+    static int firstRow = 0;
+    int count = loadedMascotsList.size();
+    // a reload may have removed mascots
+    pickerIdx = min(pickerIdx, count - 1);
+    firstRow = min(firstRow, pickerIdx / columns);
+    if ((down & WPAD_BUTTON_LEFT) && pickerIdx > 0) {
+        --pickerIdx;
+    }
+    else if ((down & WPAD_BUTTON_RIGHT) && pickerIdx < count - 1) {
+        ++pickerIdx;
+    }
+    else if ((down & WPAD_BUTTON_UP) && pickerIdx >= columns) {
+        pickerIdx -= columns;
+    }
+    else if (down & WPAD_BUTTON_DOWN) {
+        pickerIdx = min(pickerIdx + columns, count - 1);
+    }
+    int row = pickerIdx / columns;
+    if (row < firstRow) {
+        firstRow = row;
+    }
+    else if (row >= firstRow + visibleRows) {
+        firstRow = row - visibleRows + 1;
+    }
+
+    thumbnails.beginFrame();
+    drawPicker(textBatch, layout, rmode->fbWidth, rmode->efbHeight, count,
+        firstRow, pickerIdx,
+        [](int i) { return loadedMascotsList[i]->name().c_str(); },
+        [](int i) { return thumbnails.get(loadedMascotsList[i]); });
+    thumbnails.endFrame();
+
+    auto data = loadedMascotsList[pickerIdx];
+    if (down & WPAD_BUTTON_A) {
+        spawnMascot(data, data->name())->manager().reset_position();
+    }
+    else if (down & WPAD_BUTTON_B) {
+        dismissAll(data);
+    }
+}
+
+static void drawLoadingProgress() {
+    int total = loader.total(), done = loader.done();
+    f32 x = 32, y = rmode->efbHeight - 40;
+    f32 width = rmode->fbWidth - 64;
+    textBatch.print(x, y - 18, 0xFFFFFFFF, "%s mascots... %d/%d",
+        reloading ? "Reloading" : "Loading", done, total);
+    GRRLIB_Rectangle(x, y, width, 8, 0xFFFFFFFF, false);
+    if (total > 0) {
+        GRRLIB_Rectangle(x, y, width * done / total, 8, 0xFFFFFFFF, true);
+    }
+    textBatch.flush();
+}
+
+#ifndef NDEBUG
+static WiiMascot *findMascotLinear(double x, double y) {
     for (auto mascot : mascots) {
         if (mascot->pointInside(x, y)) {
             return mascot;
@@ -632,20 +2080,123 @@ WiiMascot *findMascot(double x, double y) {
     }
     return nullptr;
 }
+#endif
+
+// Topmost mascot under x,y. Only the mascots drawn into the grid cell
+// of the point are tested, last drawn first.
+WiiMascot *findMascot(double x, double y) {
+    WiiMascot *found = nullptr;
+    hitGrid.findAt(x, y, [&](WiiMascot *mascot) {
+        if (mascot->pointInside(x, y)) {
+            found = mascot;
+            return true;
+        }
+        return false;
+    });
+    #ifndef NDEBUG
+    if (found != findMascotLinear(x, y)) {
+        cerr << "W: hit grid and linear scan disagree" << endl;
+    }
+    #endif
+    return found;
+}
+
+static unsigned kib(size_t bytes) {
+    return (bytes + 1023) / 1024;
+}
+
+static void drawDebugInfo() {
+    textBatch.print(0, rmode->efbHeight - 32, 0xFFFF00FF,
+        "allocs/frame: %u  cpu: %u us  text: %u glyphs/%u draws",
+        (unsigned)lastFrameAllocations, (unsigned)lastFrameMicros,
+        lastFrameGlyphs, lastFrameTextDraws);
+#ifndef NDEBUG
+    textBatch.print(0, rmode->efbHeight - 16, 0xFFFF00FF,
+        "mascots: %u  culled: %u  draw: %u ns/sprite  "
+        "thumbnails: %u/%u KiB, ready in %u ms",
+        (unsigned)mascots.size(), culledSprites, drawnSprites == 0 ? 0 :
+        (unsigned)(ticks_to_nanosecs(spriteDrawTicks) / drawnSprites),
+        (unsigned)thumbnails.residentCount(),
+        kib(thumbnails.residentBytes()), thumbnails.readyMicros() / 1000);
+#else
+    textBatch.print(0, rmode->efbHeight - 16, 0xFFFF00FF,
+        "mascots: %u  culled: %u  thumbnails: %u/%u KiB, ready in %u ms",
+        (unsigned)mascots.size(), culledSprites,
+        (unsigned)thumbnails.residentCount(),
+        kib(thumbnails.residentBytes()), thumbnails.readyMicros() / 1000);
+#endif
+}
+
+// Memory page, toggled with [1]. The report is built when the page is
+// opened and also written to MEMORY_REPORT_PATH.
+static bool showMemory = false;
+static vector<string> memoryReport;
+
+static void buildMemoryReport() {
+    map<MascotData *, size_t> instances;
+    for (auto mascot : mascots) {
+        ++instances[mascot->data()];
+    }
+    vector<MascotMemoryRow> rows;
+    for (auto data : loadedMascotsList) {
+        rows.push_back({ data->name(), data->memory(), instances[data] });
+    }
+
+    char line[128];
+    memoryReport.clear();
+    struct mallinfo heap = mallinfo();
+    snprintf(line, sizeof(line), "MEM1 free: %u KiB  MEM2 free: %u KiB",
+        kib((u8 *)SYS_GetArena1Hi() - (u8 *)SYS_GetArena1Lo()),
+        kib((u8 *)SYS_GetArena2Hi() - (u8 *)SYS_GetArena2Lo()));
+    memoryReport.push_back(line);
+    snprintf(line, sizeof(line), "heap: %u KiB in use of %u KiB, "
+        "operator new: %u KiB", kib(heap.uordblks), kib(heap.arena),
+        kib(liveHeapBytes()));
+    memoryReport.push_back(line);
+    auto &slabs = instanceSlabs();
+    snprintf(line, sizeof(line), "instance slabs: %u KiB in use, %u of %u "
+        "pages", kib(slabs.bytesInUse()), (unsigned)slabs.pagesUsed(),
+        (unsigned)(slabs.capacity() / SlabPool::pageSize));
+    memoryReport.push_back(line);
+    snprintf(line, sizeof(line), "textures: %u KiB resident, peak %u of %u "
+        "KiB, hit rate %u.%u%%", kib(textureCache.residentBytes()),
+        kib(textureCache.peakBytes()), kib(textureCache.budget()),
+        textureCache.hitRate() / 10, textureCache.hitRate() % 10);
+    memoryReport.push_back(line);
+    memoryReport.push_back("");
+    for (auto &tableLine : formatMemoryTable(std::move(rows))) {
+        memoryReport.push_back(tableLine);
+    }
+    if (!writeMemoryReport(memoryReport, MEMORY_REPORT_PATH)) {
+        cerr << "W: couldn't write " MEMORY_REPORT_PATH << endl;
+    }
+}
+
+static void drawMemoryPage() {
+    GRRLIB_Rectangle(0, 0, rmode->fbWidth, rmode->efbHeight, 0x000000E0,
+        true);
+    unsigned rows = rmode->efbHeight / 16 - 3;
+    for (unsigned i=0; i<memoryReport.size() && i<rows; ++i) {
+        textBatch.print(0, 16 + i * 16, 0xFFFFFFFF, "%s",
+            memoryReport[i].c_str());
+    }
+    if (memoryReport.size() > rows) {
+        textBatch.print(0, 16 + rows * 16, 0xFFFF00FF, "... %u more in %s",
+            (unsigned)(memoryReport.size() - rows), MEMORY_REPORT_PATH);
+    }
+}
 
 void shijimaWiiTick(struct ir_t const& ir, u32 down, u32 held, u32 up) {
     (void)up;
-    static bool didStart = false;
     if (didStart) {
-        static bool pickerVisible = false;
-        static int pickerIdx = 0;
         bool irValid = ir.valid;
         if (pickerVisible) {
             irValid = false;
         }
         if (mascots.size() > 0) {
             updateEnvironment();
-            if (irValid) {
+            // see traceInput()
+            if (irValid && traceStarted) {
                 mascotEnv->cursor.move({ ir.x, ir.y });
                 if (dragged == nullptr && (down & WPAD_BUTTON_A)) {
                     auto target = findMascot(ir.x, ir.y);
@@ -665,17 +2216,18 @@ void shijimaWiiTick(struct ir_t const& ir, u32 down, u32 held, u32 up) {
                 dragged->manager().state->dragging = false;
                 dragged = nullptr;
             }
-            static uint8_t frameCounter = 0;
+            bool tick = traceStarted && ticksAtPhase(ntscFrameCounter);
+            hitGrid.clear();
             for (auto iter = mascots.end(); iter != mascots.begin(); ) {
                 --iter;
                 auto mascot = *iter;
-                if (frameCounter != 5) {
+                if (tick) {
                     mascot->tick();
                     if (mascot->manager().state->dead) {
                         auto erasePos = iter;
                         ++iter;
                         mascots.erase(erasePos);
-                        delete mascot;
+                        destroyMascot(mascot);
                         continue;
                     }
                     auto &breedRequest = mascot->manager().state->breed_request;
@@ -683,68 +2235,36 @@ void shijimaWiiTick(struct ir_t const& ir, u32 down, u32 held, u32 up) {
                         if (breedRequest.name == "") {
                             breedRequest.name = mascot->data()->name();
                         }
-                        auto product = mascotFactory->spawn(breedRequest);
+                        // dropped if a reload removed that mascot
+                        auto parent = loadedMascots.find(breedRequest.name);
+                        if (parent != loadedMascots.end()) {
+                            spawnMascot(parent->second.get(), breedRequest);
+                        }
                         breedRequest.available = false;
-                        mascots.push_back(new WiiMascot { std::move(product),
-                            &loadedMascots.at(breedRequest.name) });
                     }
                 }
                 mascot->draw();
             }
             mascotEnv->cursor.dx = mascotEnv->cursor.dy = 0;
-            if (rmode->viTVMode != VI_PAL && rmode->viTVMode != VI_MPAL) {
-                // skip every 6th tick if running in NTSC mode
-                frameCounter = (frameCounter + 1) % 6;
+            // input is taken while the picker is closed
+            tickedWithInput |= tick && !pickerVisible && !mascots.empty();
+            if (traceStarted) {
+                ntscFrameCounter = nextTickPhase(rmode->viTVMode,
+                    ntscFrameCounter);
             }
         }
         if (down & WPAD_BUTTON_PLUS) {
             pickerVisible = !pickerVisible;
-        }
-        if (pickerVisible) {
-            if ((down & WPAD_BUTTON_LEFT) && pickerIdx > 0) {
-                --pickerIdx;
-            }
-            else if ((down & WPAD_BUTTON_RIGHT) && pickerIdx < (int)loadedMascotsList.size() - 1) {
-                ++pickerIdx;
-            }
-            GRRLIB_Rectangle(0, 0, rmode->fbWidth, rmode->efbHeight, 0x00000088, true);
-            auto data = loadedMascotsList[pickerIdx];
-            auto preview = data->preview();
-            preview->draw(rmode->fbWidth / 2 - preview->width() / 2,
-                rmode->efbHeight / 2 - preview->height() / 2,
-                false);
-            if (pickerIdx != ((int)loadedMascotsList.size() - 1)) {
-                GRRLIB_Printf(rmode->fbWidth / 2 + preview->width() / 2 + 8,
-                    rmode->efbHeight / 2 - 8, texFont, 0xFFFFFFFF, 1,
-                    "-->");
-            }
-            if (pickerIdx != 0) {
-                GRRLIB_Printf(rmode->fbWidth / 2 - preview->width() / 2 - 32,
-                    rmode->efbHeight / 2 - 8, texFont, 0xFFFFFFFF, 1,
-                    "<--");
-            }
-            GRRLIB_Printf(rmode->fbWidth / 2 - data->name().size() * 4,
-                rmode->efbHeight / 2 + preview->height() / 2 + 8, texFont,
-                0xFFFFFFFF, 1, "%s", data->name().c_str());
-            if (down & WPAD_BUTTON_A) {
-                auto product = mascotFactory->spawn(data->name());
-                product.manager->reset_position();
-                mascots.push_back(new WiiMascot { std::move(product), data });
-            }
-            else if (down & WPAD_BUTTON_B) {
-                for (auto iter = mascots.end(); iter != mascots.begin(); ) {
-                    --iter;
-                    auto mascot = *iter;
-                    if (mascot->data() == data) {
-                        auto erasePos = iter;
-                        ++iter;
-                        mascots.erase(erasePos);
-                        delete mascot;
-                        continue;
-                    }
-                }
+            if (pickerVisible) {
+                thumbnails.opened();
             }
         }
+        if (pickerVisible && !loadedMascotsList.empty()) {
+            tickPicker(down);
+        }
+        else if (thumbnails.residentCount() > 0) {
+            thumbnails.clear();
+        }
         else if (irValid) {
             GRRLIB_Rectangle(ir.x - 1, ir.y - 1, 3, 3, 0xFF0000FF, true);
         }
@@ -760,6 +2280,10 @@ void shijimaWiiTick(struct ir_t const& ir, u32 down, u32 held, u32 up) {
 }
 
 int main() {
+    mainThread = currentThreadId();
+    bootTime = gettime();
+    loaderStart = bootTime;
+
     // Initialise the Graphics & Video subsystem
     GRRLIB_Init();
 
@@ -767,46 +2291,71 @@ int main() {
     WPAD_Init();
     WPAD_SetDataFormat(WPAD_CHAN_0, WPAD_FMT_BTNS_ACC_IR);
 
-    consoleLines.resize(rmode->efbHeight / 16 - 2);
+    console.resize(rmode->efbHeight / 16 - 2);
 
     texFont = GRRLIB_LoadTexture(defaultFontTiles);
     GRRLIB_InitTileSet(texFont, defaultFontCharWidth,
         defaultFontCharHeight, defaultFontStart);
+    texConsole = GRRLIB_CreateEmptyTexture(rmode->fbWidth,
+        console.rows() * 16);
+    textBatch.init(texFont, 4096);
+    hitGrid.reset(rmode->fbWidth, rmode->efbHeight, 64);
+    if (!initInstanceSlabs(INSTANCE_SLAB_SIZE)) {
+        cerr << "W: couldn't reserve the mascot instance slabs" << endl;
+    }
+    startIdleJobs();
     
     showConsoleNow();
 
     try {
-        if (!fatInitDefault()) {
+        bool fatReady = fatInitDefault();
+        if (fatReady) {
+            openLog();
+        }
+        if (!fatReady) {
             die("fatInitDefault failed!");
         }
-        else if (!discoverMascots()) {
-            die("Couldn't find any mascots!");
-            //FIXME: not yet
-            //cerr << "[*] You can use Shijima-Qt on a computer to prepare" << endl;
-            //cerr << "shimeji for Shijima-Wii." << endl;
+        else if (!filesystem::is_directory(MASCOT_LOCATION)) {
+            die(MASCOT_LOCATION " missing!");
         }
         else {
+            mascotFactory = make_unique<shijima::mascot::factory>();
             mascotEnv = make_shared<shijima::mascot::environment>();
             mascotEnv->subtick_count = 2;
             mascotFactory->env = mascotEnv;
             updateEnvironment();
-            string mascotName;
-            for (auto &pair : loadedMascots) {
-                mascotName = pair.first;
-                break;
+            #ifndef NDEBUG
+            benchmarkTextureConvert();
+            #endif
+            openInputTrace();
+            readSavedScene(replayMode ? REPLAY_SCENE_PATH : SCENE_PATH);
+            if (!loader.load()) {
+                die("Couldn't start the loader thread!");
             }
-            auto product = mascotFactory->spawn(mascotName);
-            product.manager->reset_position();
-            mascots.push_back(new WiiMascot { std::move(product),
-                &loadedMascots.at(mascotName) });
-            cout << "... Press [A] to start Shijima-Wii" << endl;
         }
     }
     catch (std::exception &ex) {
         die(ex.what());
     }
 
+    u64 lastFrameStart = 0;
+    size_t lastIdleSlices = 0;
     while (1) {
+        uint32_t frameAllocations = allocationCount();
+        u64 frameStart = gettime();
+        if (lastFrameStart != 0 && diff_usec(lastFrameStart, frameStart) >
+            framePeriodMicros(rmode->viTVMode) * 3 / 2)
+        {
+            ++missedFrames;
+            if (lastIdleSlices > 0) {
+                ++missedFramesWithIdleWork;
+            }
+        }
+        lastFrameStart = frameStart;
+        textureCache.beginFrame();
+        textBatch.resetStats();
+        culledSprites = drawnSprites = 0;
+        spriteDrawTicks = 0;
         WPAD_ScanPads();
         struct ir_t ir;
         WPAD_IR(WPAD_CHAN_0, &ir);
@@ -822,37 +2371,122 @@ int main() {
 
         if (down & WPAD_BUTTON_HOME) break;
         if (down & WPAD_BUTTON_MINUS) showBoundaries = !showBoundaries;
+        if (down & WPAD_BUTTON_1) {
+            showMemory = !showMemory;
+            if (showMemory) {
+                buildMemoryReport();
+            }
+        }
+        // a replay needs the library it was recorded with
+        if ((down & WPAD_BUTTON_2) && !replayMode) {
+            startReload();
+        }
 
         // console
-        flushConsole();
         drawConsole();
         
         // tick and draw graphics if not crashed
         if (!fatalError) {
             try {
+                traceInput(ir, down, held, up);
+                receiveMascots();
                 shijimaWiiTick(ir, down, held, up);
+                traceState();
+                if (loader.running()) {
+                    drawLoadingProgress();
+                }
             }
             catch (std::exception &ex) {
                 die(ex.what());
             }
         }
 
-        GRRLIB_Render();
+        // Text is batched per layer. The picker and the progress bar
+        // flush their own text, this is the layer of the overlays.
+        if (showMemory) {
+            drawMemoryPage();
+        }
+        if (showBoundaries) {
+            drawDebugInfo();
+        }
+        textBatch.flush();
+        lastFrameGlyphs = textBatch.glyphCount();
+        lastFrameTextDraws = textBatch.drawCount();
+
+        // time spent before waiting for the GPU and vsync
+        lastFrameMicros = diff_usec(frameStart, gettime());
+        {
+            TRACE_ZONE("idle work");
+            lastIdleSlices = idleWork.run(ticks_to_microsecs(frameStart) +
+                framePeriodMicros(rmode->viTVMode) - IDLE_MARGIN_MICROS);
+        }
+        {
+            TRACE_ZONE("GRRLIB_Render");
+            GRRLIB_Render();
+        }
+        if (!reportedInteractive && tickedWithInput) {
+            reportedInteractive = true;
+            cout << "First interactive frame after "
+                << diff_usec(bootTime, gettime()) / 1000 << " ms"
+                << (loader.running() ? ", still loading" : "") << endl;
+        }
+        lastFrameAllocations = allocationCount() - frameAllocations;
     }
 
     // cleanup
+    if (!fatalError && mascotEnv != nullptr && !replayMode) {
+        writeSavedScene();
+    }
+    prototypeSpawns.report("prototype");
+    fullSpawns.report("full");
+    cout << "Textures: hit rate " << textureCache.hitRate() / 10 << "."
+        << textureCache.hitRate() % 10 << "% (" << textureCache.misses()
+        << " misses, " << textureCache.idleDecodes() << " decoded in idle "
+        "time, " << textureCache.lateDecodes() << " by a draw), "
+        << textureCache.prefetches() << " prefetched, "
+        << textureCache.evictions() << " evicted, peak "
+        << textureCache.peakBytes() / 1024 << " of "
+        << textureCache.budget() / 1024 << " KiB" << endl;
+    cout << "Idle work: " << idleWork.slices() << " slices in "
+        << idleWork.busyMicros() / 1000 << " ms, " << idleWork.overruns()
+        << " overran";
+    if (idleWork.lastOverrun() != NULL) {
+        cout << " (last: " << idleWork.lastOverrun() << ")";
+    }
+    cout << "; " << missedFrames << " frames missed vsync, "
+        << missedFramesWithIdleWork << " of them after idle work" << endl;
+    if (convertMicros > 0) {
+        cout << "Texture conversion (" << textureConvertKernel() << "): "
+            << convertedBytes / convertMicros << " MB/s over "
+            << convertedBytes / 1024 << " KiB" << endl;
+    }
+    if (traceWriter.isOpen()) {
+        traceWriter.close();
+        cout << "Recorded " << traceWriter.frames() << " frames to "
+            TRACE_PATH << endl;
+    }
+    loader.cancel();
+    #ifdef SHIJIMA_WII_TRACE
+    if (!traceWriteJSON(MASCOT_LOCATION "/shijima-wii.trace.json")) {
+        cerr << "W: couldn't write the trace" << endl;
+    }
+    #endif
     for (auto wiiMascot : mascots) {
         delete wiiMascot;
     }
     mascots.clear();
+    prototypes.clear();
     loadedMascotsList.clear();
     loadedMascots.clear();
     mascotEnv = nullptr;
     mascotFactory = nullptr;
 
     cout << "[HOME] pressed, quitting..." << endl;
-    showConsoleNow();
+    showConsoleNow(true);
+    console.setSink(NULL);
+    logFile.close();
 
+    GRRLIB_FreeTexture(texConsole);
     GRRLIB_FreeTexture(texFont);
     GRRLIB_Exit();
 
@@ -0,0 +1,326 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <ostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include "file_pipeline.hpp"
+#include "library_index.hpp"
+#include "load_arena.hpp"
+#include "spsc_queue.hpp"
+#include "thread.hpp"
+#include "trace.hpp"
+
+// Loads the mascot library on a thread of its own. Every mascot that
+// loads is handed to the main thread through a queue, which pop() takes
+// them from, so that they show up while the rest is still loading.
+//
+// load() reads the library index first. If it still matches the
+// library folder, the mascot folders are not probed, and an entry that
+// doesn't load any more is probed again. reload() loads only the
+// mascots that are new or whose files changed, see
+// LibraryIndex::changed(), and sends a marker for every mascot whose
+// folder is gone. The index is written back whenever it changed.
+template<typename Mascot>
+class MascotLoader {
+public:
+    // Loads the mascot of record from its folder, dir, on the loader
+    // thread. Unless indexed, the folder is probed and record filled in.
+    // Returns nullptr or throws if that fails.
+    using Load = Mascot *(*)(std::string const& dir,
+        LibraryIndex::Mascot &record, bool indexed, FilePipeline &pipeline);
+    // the marker for a mascot whose folder is gone
+    using Removed = Mascot *(*)(std::string const& name);
+    struct Config {
+        // the folder of the .mascot folders
+        std::string library;
+        std::string indexPath;
+        // made before the index is written for the first time
+        std::vector<std::string> cacheFolders;
+        // for load temporaries, see LoadArena. 0 takes them from the
+        // heap.
+        size_t arenaSize;
+        Load load;
+        Removed removed;
+        // where the thread logs
+        std::ostream &(*log)();
+    };
+    explicit MascotLoader(Config const& config): m_config(config) {}
+    MascotLoader(const MascotLoader &) = delete;
+    MascotLoader &operator=(const MascotLoader &) = delete;
+    ~MascotLoader() {
+        cancel();
+    }
+    // Start the first load and a reload. They return false if the thread
+    // is still running or can't be started.
+    bool load() {
+        return start(&MascotLoader::discover);
+    }
+    bool reload() {
+        return start(&MascotLoader::rescan);
+    }
+    bool running() const {
+        return m_thread.running();
+    }
+    // Set once the thread is done, everything it loaded can be popped by
+    // then. join() has to be called before the next start.
+    bool finished() const {
+        return m_finished;
+    }
+    void join() {
+        m_thread.join();
+    }
+    // mascots to load or remove, and how many of them are done
+    int total() const {
+        return m_total;
+    }
+    int done() const {
+        return m_done;
+    }
+    // main thread only
+    bool pop(Mascot *&mascot) {
+        if (!m_queue.pop(mascot)) {
+            return false;
+        }
+        ++m_popped;
+        return true;
+    }
+    // True once the thread has finished and everything it handed over
+    // was popped. Main thread only.
+    bool drained() const {
+        return m_finished && m_popped == m_pushed;
+    }
+    // Stops the thread and frees the mascots it hasn't handed over
+    void cancel() {
+        m_cancel = true;
+        m_thread.join();
+        Mascot *pending;
+        while (m_queue.pop(pending)) {
+            delete pending;
+        }
+    }
+    // the index as of the last load, loader thread only while it runs
+    LibraryIndex const& index() const {
+        return m_index;
+    }
+private:
+    bool start(void (MascotLoader::*run)()) {
+        if (m_thread.running()) {
+            return false;
+        }
+        m_run = run;
+        m_finished = false;
+        m_cancel = false;
+        m_total = 0;
+        m_done = 0;
+        m_pushed = 0;
+        m_popped = 0;
+        return m_thread.start(threadMain, this, Thread::lowPriority,
+            256 * 1024);
+    }
+    static void *threadMain(void *self) {
+        auto loader = (MascotLoader *)self;
+        try {
+            (loader->*loader->m_run)();
+        }
+        catch (std::exception &ex) {
+            loader->m_config.log() << "ERROR: " << ex.what() << std::endl;
+        }
+        loader->m_finished = true;
+        return NULL;
+    }
+    std::string folder(std::string const& name) const {
+        return m_config.library + "/" + name + ".mascot";
+    }
+    Mascot *loadMascot(LibraryIndex::Mascot &record, bool indexed,
+        FilePipeline &pipeline, LoadArena &arena)
+    {
+        auto dir = folder(record.name);
+        LoadArena::Scope arenaScope { arena };
+        try {
+            if (!indexed && !std::filesystem::is_directory(dir)) {
+                record = { record.name };
+                return nullptr;
+            }
+            return m_config.load(dir, record, indexed, pipeline);
+        }
+        catch (std::exception &ex) {
+            m_config.log() << "ERROR: " << ex.what() << std::endl;
+        }
+        return nullptr;
+    }
+    // Hands mascot to the main thread, unless it is nullptr or the
+    // loader is cancelled while the queue is full
+    void push(Mascot *mascot) {
+        while (mascot != nullptr && !m_queue.push(mascot)) {
+            if (m_cancel) {
+                delete mascot;
+                mascot = nullptr;
+            }
+            else {
+                sleepMillis(10);
+            }
+        }
+        if (mascot != nullptr) {
+            ++m_pushed;
+        }
+    }
+    void writeIndex() {
+        uint64_t size;
+        if (LibraryIndex::statPath(m_config.library, size,
+                m_index.dirMtime) &&
+            !m_index.write(m_config.indexPath))
+        {
+            m_config.log() << "W: couldn't write " << m_config.indexPath
+                << std::endl;
+        }
+    }
+    void discover() {
+        TRACE_ZONE("discoverMascots");
+        auto &log = m_config.log;
+        bool indexValid = m_index.read(m_config.indexPath) &&
+            m_index.matches(m_config.library);
+        if (indexValid) {
+            log() << "Using library index" << std::endl;
+        }
+        else {
+            std::vector<std::string> names;
+            LibraryIndex::listMascots(m_config.library, names);
+            m_index.mascots.clear();
+            for (auto &name : names) {
+                m_index.mascots.push_back({ name });
+            }
+            for (auto &cacheFolder : m_config.cacheFolders) {
+                mkdir(cacheFolder.c_str(), 0777);
+            }
+        }
+        bool indexChanged = !indexValid;
+        m_total = m_index.mascots.size();
+        FilePipeline pipeline;
+        LoadArena arena { m_config.arenaSize };
+        for (auto &record : m_index.mascots) {
+            if (m_cancel) {
+                break;
+            }
+            // entries that failed last time are always probed again
+            bool indexed = indexValid &&
+                (record.tmpl != LibraryIndex::TemplateNone ||
+                record.graphics != LibraryIndex::GraphicsNone);
+            // an edit in place doesn't change the mtime of a FAT folder,
+            // and a stale thumbnail would stay cached until the next
+            // change that does
+            if (indexed && !LibraryIndex::previewMatches(folder(record.name),
+                record))
+            {
+                log() << "Preview of " << record.name << " changed, "
+                    "rescanning" << std::endl;
+                indexed = false;
+            }
+            auto mascot = loadMascot(record, indexed, pipeline, arena);
+            if (mascot == nullptr && indexed) {
+                log() << "Index out of date for " << record.name
+                    << ", rescanning" << std::endl;
+                mascot = loadMascot(record, false, pipeline, arena);
+                indexed = false;
+            }
+            // the record was filled in again
+            if (!indexed) {
+                indexChanged = true;
+            }
+            push(mascot);
+            ++m_done;
+        }
+        log() << "Load arena peak: " << arena.peak() / 1024 << " of "
+            << arena.capacity() / 1024 << " KiB, " << arena.overflows()
+            << " overflows" << std::endl;
+        if (indexChanged && !m_cancel) {
+            // creating the cache folder changes the mtime of the library,
+            // which is why it is only recorded now
+            writeIndex();
+        }
+    }
+    void rescan() {
+        TRACE_ZONE("reloadMascots");
+        std::vector<std::string> names;
+        if (!LibraryIndex::listMascots(m_config.library, names)) {
+            m_config.log() << "W: couldn't list " << m_config.library
+                << std::endl;
+            return;
+        }
+        std::map<std::string, LibraryIndex::Mascot *> previous;
+        for (auto &record : m_index.mascots) {
+            previous[record.name] = &record;
+        }
+        std::vector<LibraryIndex::Mascot> next;
+        std::vector<size_t> changed;
+        // folders touched without changing any file of their mascot
+        bool touched = false;
+        next.reserve(names.size());
+        for (auto &name : names) {
+            auto iter = previous.find(name);
+            if (iter == previous.end()) {
+                next.push_back({ name });
+                changed.push_back(next.size() - 1);
+                continue;
+            }
+            next.push_back(*iter->second);
+            previous.erase(iter);
+            if (LibraryIndex::changed(folder(name), next.back(), touched)) {
+                changed.push_back(next.size() - 1);
+            }
+        }
+        m_total = changed.size() + previous.size();
+        if (!changed.empty()) {
+            FilePipeline pipeline;
+            LoadArena arena { m_config.arenaSize };
+            for (auto i : changed) {
+                if (m_cancel) {
+                    break;
+                }
+                push(loadMascot(next[i], false, pipeline, arena));
+                ++m_done;
+            }
+        }
+        for (auto &pair : previous) {
+            push(m_config.removed(pair.first));
+            ++m_done;
+        }
+        m_index.mascots = std::move(next);
+        if (!m_cancel && (m_total > 0 || touched)) {
+            writeIndex();
+        }
+    }
+    Config m_config;
+    Thread m_thread;
+    void (MascotLoader::*m_run)() = nullptr;
+    SpscQueue<Mascot *, 32> m_queue;
+    std::atomic<int> m_total { 0 };
+    std::atomic<int> m_done { 0 };
+    std::atomic<int> m_pushed { 0 };
+    int m_popped = 0;
+    std::atomic<bool> m_finished { false };
+    std::atomic<bool> m_cancel { false };
+    LibraryIndex m_index;
+};
@@ -0,0 +1,80 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "memory_report.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+static unsigned kib(size_t bytes) {
+    return (bytes + 1023) / 1024;
+}
+
+static std::string formatRow(const char *name, MascotMemory const& memory,
+    size_t count, size_t total)
+{
+    char line[128];
+    snprintf(line, sizeof(line), "%-18.18s %6u %5u %5u %5u %5u %5u %4u x "
+        "%4u %6u", name, kib(memory.qutexTextures), kib(memory.pngTextures),
+        kib(memory.textureFiles), kib(memory.displayLists),
+        kib(memory.spriteMap), kib(memory.tmpl), (unsigned)count,
+        kib(memory.instance), kib(total));
+    return line;
+}
+
+std::vector<std::string> formatMemoryTable(std::vector<MascotMemoryRow> rows)
+{
+    std::stable_sort(rows.begin(), rows.end(),
+        [](MascotMemoryRow const& a, MascotMemoryRow const& b) {
+            return a.memory.total(a.instances) > b.memory.total(b.instances);
+        });
+    std::vector<std::string> lines;
+    lines.push_back("KiB                 qutex   png files lists   map"
+        "  tmpl   instances  total");
+    MascotMemory sum;
+    size_t sumInstances = 0, sumTotal = 0;
+    for (auto &row : rows) {
+        auto &memory = row.memory;
+        size_t total = memory.total(row.instances);
+        lines.push_back(formatRow(row.name.c_str(), memory, row.instances,
+            total));
+        sum.qutexTextures += memory.qutexTextures;
+        sum.pngTextures += memory.pngTextures;
+        sum.textureFiles += memory.textureFiles;
+        sum.displayLists += memory.displayLists;
+        sum.spriteMap += memory.spriteMap;
+        sum.tmpl += memory.tmpl;
+        sum.instance += memory.instance * row.instances;
+        sumInstances += row.instances;
+        sumTotal += total;
+    }
+    sum.instance = sumInstances == 0 ? 0 : sum.instance / sumInstances;
+    lines.push_back(formatRow("(all)", sum, sumInstances, sumTotal));
+    return lines;
+}
+
+bool writeMemoryReport(std::vector<std::string> const& lines,
+    const char *path)
+{
+    std::ofstream out { path, std::ios::trunc };
+    for (auto &line : lines) {
+        out << line << '\n';
+    }
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,58 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Memory held by one loaded mascot, for the memory page
+struct MascotMemory {
+    // decoded textures that are resident right now
+    size_t qutexTextures = 0;
+    size_t pngTextures = 0;
+    // texture files kept for decoding them again, and alpha masks
+    size_t textureFiles = 0;
+    size_t displayLists = 0;
+    // map nodes, names and sprite objects
+    size_t spriteMap = 0;
+    // heap taken by registering the template with the factory
+    size_t tmpl = 0;
+    // heap taken by one instance, measured at the last spawn
+    size_t instance = 0;
+    // with that many instances
+    size_t total(size_t instances) const {
+        return qutexTextures + pngTextures + textureFiles + displayLists +
+            spriteMap + tmpl + instance * instances;
+    }
+};
+
+struct MascotMemoryRow {
+    std::string name;
+    MascotMemory memory;
+    size_t instances;
+};
+
+// The table of the memory page in KiB: a header, a line per mascot,
+// the biggest first, and their sum as "(all)", whose instance column is
+// the average of all instances.
+std::vector<std::string> formatMemoryTable(std::vector<MascotMemoryRow> rows);
+
+// Writes the lines of the memory page to path, returns false on failure
+bool writeMemoryReport(std::vector<std::string> const& lines,
+    const char *path);
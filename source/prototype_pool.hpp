@@ -0,0 +1,154 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Spare products spawned ahead of time, at most one per key. take()
+// hands out the spare of a key and remembers the key, so that a later
+// refill() spawns the next spare off the frame that asked for one.
+// Refills are meant for idle time, so the pool keeps what a spawn of
+// each key last cost for nextCost() to tell whether the next one fits.
+template<typename Key, typename Product>
+class PrototypePool {
+public:
+    // clock returns microseconds and times refill()
+    explicit PrototypePool(uint64_t (*clock)()): m_clock(clock) {}
+    PrototypePool(const PrototypePool &) = delete;
+    PrototypePool &operator=(const PrototypePool &) = delete;
+    // returns false if key has no spare yet
+    bool take(Key key, Product &product, size_t &bytes) {
+        if (std::find(m_queue.begin(), m_queue.end(), key) == m_queue.end()) {
+            m_queue.push_back(key);
+        }
+        auto iter = m_spares.find(key);
+        if (iter == m_spares.end()) {
+            return false;
+        }
+        product = std::move(iter->second.product);
+        bytes = iter->second.bytes;
+        m_spares.erase(iter);
+        return true;
+    }
+    // Spawns one missing spare with spawn(key, bytes), which returns the
+    // product and stores the heap it took in bytes. Returns false if no
+    // spare was missing.
+    template<typename Spawn>
+    bool refill(Spawn &&spawn) {
+        while (!m_queue.empty()) {
+            Key key = m_queue.back();
+            m_queue.pop_back();
+            if (m_spares.count(key) != 0) {
+                continue;
+            }
+            Spare spare;
+            uint64_t start = m_clock();
+            spare.product = spawn(key, spare.bytes);
+            measured(key, (uint32_t)(m_clock() - start));
+            m_spares.emplace(key, std::move(spare));
+            ++m_refills;
+            return true;
+        }
+        return false;
+    }
+    // records what a spawn of key took outside of refill()
+    void measured(Key key, uint32_t micros) {
+        m_costs[key] = micros;
+    }
+    // Microseconds the next refill() is expected to take: the last
+    // spawn of its key, or unknown if that key was never measured. 0 if
+    // no spare is missing.
+    uint32_t nextCost(uint32_t unknown) const {
+        for (auto iter = m_queue.rbegin(); iter != m_queue.rend(); ++iter) {
+            if (m_spares.count(*iter) != 0) {
+                continue;
+            }
+            auto cost = m_costs.find(*iter);
+            return cost == m_costs.end() ? unknown : cost->second;
+        }
+        return 0;
+    }
+    // drops the spare of key, for keys that are about to be freed
+    void forget(Key key) {
+        m_queue.erase(std::remove(m_queue.begin(), m_queue.end(), key),
+            m_queue.end());
+        m_spares.erase(key);
+        m_costs.erase(key);
+    }
+    // drops every spare, but keeps the measured costs
+    void clear() {
+        m_queue.clear();
+        m_spares.clear();
+    }
+    size_t spareCount() const {
+        return m_spares.size();
+    }
+    // spares built by refill() so far
+    uint64_t refills() const {
+        return m_refills;
+    }
+private:
+    struct Spare {
+        Product product {};
+        size_t bytes = 0;
+    };
+    uint64_t (*m_clock)();
+    std::vector<Key> m_queue;
+    std::map<Key, Spare> m_spares;
+    std::map<Key, uint32_t> m_costs;
+    uint64_t m_refills = 0;
+};
+
+// Spawn latencies in microseconds, the last 256 of each kind
+class SpawnLatency {
+public:
+    void add(uint32_t micros) {
+        m_samples[m_count++ % m_samples.size()] = micros;
+    }
+    size_t count() const {
+        return std::min(m_count, m_samples.size());
+    }
+    // percent of 0 to 99, 0 if there are no samples
+    uint32_t percentile(unsigned percent) const {
+        size_t count = this->count();
+        if (count == 0) {
+            return 0;
+        }
+        std::array<uint32_t, 256> sorted = m_samples;
+        std::sort(sorted.begin(), sorted.begin() + count);
+        return sorted[(count * percent) / 100];
+    }
+    void report(const char *kind) const {
+        if (count() == 0) {
+            return;
+        }
+        std::cout << "Spawn latency (" << kind << "): p50 " << percentile(50)
+            << " us, p99 " << percentile(99) << " us over " << count()
+            << " spawns" << std::endl;
+    }
+private:
+    std::array<uint32_t, 256> m_samples {};
+    size_t m_count = 0;
+};
@@ -0,0 +1,67 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include "display_list.hpp"
+
+// Where one qutex sprite is on its sheet and where it is drawn. The
+// qutex reader reports each sheet with the size of the canvas its
+// sprites were cut from, which mirrored sprites are flipped within.
+// That is not the size of the sheet's texture, which the texture
+// coordinates have to be relative to.
+struct QutexSprite {
+    int canvasWidth, canvasHeight;
+    // rectangle on the texture and offset on the canvas
+    int x, y, width, height;
+    int xoff, yoff;
+    // From the values the reader gives, with the same one pixel frame
+    // correction GRRLIB_DrawPart() needs
+    static QutexSprite fromReader(int canvasWidth, int canvasHeight,
+        int x, int y, int width, int height, int xoff, int yoff)
+    {
+        return { canvasWidth, canvasHeight, x + 1, y + 1, width - 1,
+            height - 1, xoff + 1, yoff + 1 };
+    }
+    // offset of the drawn rectangle from the sprite's position
+    int drawX(bool flipX) const {
+        return flipX ? canvasWidth - width - xoff : xoff;
+    }
+    int drawY() const {
+        return yoff;
+    }
+    // The quad for a display list, for a texture of texWidth by
+    // texHeight pixels
+    SpriteQuad quad(int texWidth, int texHeight) const {
+        float w = texWidth, h = texHeight;
+        return { (float)width, (float)height, (x + 0.001f) / w,
+            (y + 0.001f) / h, (x + width - 0.001f) / w,
+            (y + height - 0.001f) / h };
+    }
+    // Texel of the sprite's point px,py. Returns false outside of the
+    // rectangle on the texture.
+    bool texel(int px, int py, int &tx, int &ty) const {
+        px -= xoff;
+        py -= yoff;
+        if (px < 0 || px >= width || py < 0 || py >= height) {
+            return false;
+        }
+        tx = x + px;
+        ty = y + py;
+        return true;
+    }
+};
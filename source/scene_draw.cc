@@ -0,0 +1,60 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "scene_draw.hpp"
+#include <mutex>
+
+void drawConsole(TextBatch &text, ConsoleBuffer &console,
+    GRRLIB_texImg *cache)
+{
+    // Printing every line is hundreds of glyph quads, so the text is
+    // rendered into cache only when it changes and drawn as a single
+    // quad otherwise.
+    bool dirty;
+    {
+        std::lock_guard<ConsoleBuffer> guard { console };
+        dirty = console.takeDirty();
+        if (dirty) {
+            for (int i=0; i<console.lineCount(); i++) {
+                text.print(0, (i+1)*16, 0xFFFFFFFF, "%s", console.line(i));
+            }
+        }
+    }
+    if (dirty) {
+        GRRLIB_CompoStart();
+        text.flush();
+        GRRLIB_CompoEnd(0, 16, cache);
+    }
+    GRRLIB_DrawImg(0, 16, cache, 0, 1, 1, 0xFFFFFFFF);
+}
+
+void drawSpriteList(GXTexObj *texObj, const u8 *list, size_t size,
+    f32 xpos, f32 ypos)
+{
+    Mtx m, mv;
+    GX_LoadTexObj(texObj, GX_TEXMAP0);
+    GX_SetTevOp(GX_TEVSTAGE0, GX_MODULATE);
+    GX_SetVtxDesc(GX_VA_TEX0, GX_DIRECT);
+    guMtxTrans(m, xpos, ypos, 0);
+    guMtxConcat(GXmodelView2D, m, mv);
+    GX_LoadPosMtxImm(mv, GX_PNMTX0);
+    GX_CallDispList(list, size);
+    GX_LoadPosMtxImm(GXmodelView2D, GX_PNMTX0);
+    GX_SetTevOp(GX_TEVSTAGE0, GX_PASSCLR);
+    GX_SetVtxDesc(GX_VA_TEX0, GX_NONE);
+}
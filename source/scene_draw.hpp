@@ -0,0 +1,98 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <grrlib.h>
+#include "console.hpp"
+#include "text_batch.hpp"
+
+// Drawing of the console, the picker and the sprites, kept apart from
+// main.cc so that tests/raster_test.cc can render the same frames on a
+// computer, where a GRRLIB and GX shim draws into a SoftRaster.
+
+// Prints the console into cache when it changed and draws cache at
+// 0,16. This has to run before anything else is drawn in the frame
+// since GRRLIB_CompoEnd() clears the EFB.
+void drawConsole(TextBatch &text, ConsoleBuffer &console,
+    GRRLIB_texImg *cache);
+
+// Draws a sprite display list from writeSpriteQuad() with its top left
+// corner at xpos,ypos.
+void drawSpriteList(GXTexObj *texObj, const u8 *list, size_t size,
+    f32 xpos, f32 ypos);
+
+// Cell grid of the mascot picker on a screen of the given size
+struct PickerLayout {
+    static constexpr int cellWidth = 128;
+    int thumbnailSize;
+    int cellHeight;
+    int columns;
+    int visibleRows;
+    int left, top;
+    PickerLayout(int screenWidth, int screenHeight, int thumbnailSize):
+        thumbnailSize(thumbnailSize), cellHeight(thumbnailSize + 32),
+        columns(std::max(screenWidth / cellWidth, 1)),
+        visibleRows(std::max((screenHeight - 64) / cellHeight, 1)),
+        left((screenWidth - columns * cellWidth) / 2),
+        top((screenHeight - visibleRows * cellHeight) / 2) {}
+};
+
+// Draws the visible rows of the picker over a dimmed screen. name(i)
+// and thumbnail(i) give the label and the thumbnail texture, which may
+// be NULL, of the i-th mascot.
+template<typename Name, typename Thumbnail>
+void drawPicker(TextBatch &text, PickerLayout const& layout,
+    int screenWidth, int screenHeight, int count, int firstRow,
+    int selected, Name name, Thumbnail thumbnail)
+{
+    GRRLIB_Rectangle(0, 0, screenWidth, screenHeight, 0x00000088, true);
+    int cellWidth = layout.cellWidth, cellHeight = layout.cellHeight;
+    int last = std::min((firstRow + layout.visibleRows) * layout.columns,
+        count);
+    for (int i = firstRow * layout.columns; i < last; ++i) {
+        int x = layout.left + (i % layout.columns) * cellWidth;
+        int y = layout.top + (i / layout.columns - firstRow) * cellHeight;
+        int thumbX = x + (cellWidth - layout.thumbnailSize) / 2;
+        GRRLIB_texImg *texture = thumbnail(i);
+        if (texture != NULL) {
+            GRRLIB_DrawImg(thumbX, y + 4, texture, 0, 1, 1, 0xFFFFFFFF);
+        }
+        if (i == selected) {
+            GRRLIB_Rectangle(thumbX - 4, y, layout.thumbnailSize + 8,
+                layout.thumbnailSize + 8, 0xFFFFFFFF, false);
+        }
+        const char *label = name(i);
+        int maxChars = cellWidth / 8 - 1;
+        int length = std::min((int)strlen(label), maxChars);
+        text.print(x + (cellWidth - length * 8) / 2,
+            y + layout.thumbnailSize + 12,
+            i == selected ? 0xFFFFFFFF : 0xAAAAAAFF, "%.*s", length, label);
+    }
+    if (firstRow > 0) {
+        text.print(screenWidth / 2 - 8, layout.top - 20, 0xFFFFFFFF, "/\\");
+    }
+    if (last < count) {
+        text.print(screenWidth / 2 - 8,
+            layout.top + layout.visibleRows * cellHeight, 0xFFFFFFFF, "\\/");
+    }
+    // the labels belong to the picker layer, above mascots and below
+    // whatever is drawn after it
+    text.flush();
+}
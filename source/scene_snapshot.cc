@@ -0,0 +1,177 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "scene_snapshot.hpp"
+#include <cstdio>
+#include <cstring>
+
+// "SWSN", a version byte, the screen size, the mascot count and then
+// one record per mascot. Numbers are big endian.
+static const char snapshotMagic[4] = { 'S', 'W', 'S', 'N' };
+static const uint8_t snapshotVersion = 1;
+
+namespace {
+
+class Writer {
+public:
+    void u8(uint8_t value) {
+        m_data.push_back(value);
+    }
+    void u16(uint16_t value) {
+        u8(value >> 8);
+        u8(value & 0xFF);
+    }
+    void u32(uint32_t value) {
+        u16(value >> 16);
+        u16(value & 0xFFFF);
+    }
+    void f64(double value) {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        u32(bits >> 32);
+        u32(bits & 0xFFFFFFFF);
+    }
+    void bytes(const void *data, size_t size) {
+        auto start = (const uint8_t *)data;
+        m_data.insert(m_data.end(), start, start + size);
+    }
+    std::vector<uint8_t> const& data() const {
+        return m_data;
+    }
+private:
+    std::vector<uint8_t> m_data;
+};
+
+class Reader {
+public:
+    Reader(std::vector<uint8_t> const& data): m_data(data), m_pos(0),
+        m_ok(true) {}
+    uint8_t u8() {
+        if (m_pos + 1 > m_data.size()) {
+            m_ok = false;
+            return 0;
+        }
+        return m_data[m_pos++];
+    }
+    uint16_t u16() {
+        uint16_t high = u8();
+        return (high << 8) | u8();
+    }
+    uint32_t u32() {
+        uint32_t high = u16();
+        return (high << 16) | u16();
+    }
+    double f64() {
+        uint64_t high = u32();
+        uint64_t bits = (high << 32) | u32();
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    bool bytes(void *out, size_t size) {
+        if (m_pos + size > m_data.size()) {
+            m_ok = false;
+            return false;
+        }
+        memcpy(out, &m_data[m_pos], size);
+        m_pos += size;
+        return true;
+    }
+    size_t remaining() const {
+        return m_data.size() - m_pos;
+    }
+    bool ok() const {
+        return m_ok;
+    }
+private:
+    std::vector<uint8_t> const& m_data;
+    size_t m_pos;
+    bool m_ok;
+};
+
+}
+
+bool SceneSnapshot::read(std::string const& path) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t size;
+    while ((size = fread(buf, 1, sizeof(buf), file)) > 0) {
+        data.insert(data.end(), buf, buf + size);
+    }
+    fclose(file);
+
+    Reader in { data };
+    char magic[4];
+    if (!in.bytes(magic, sizeof(magic)) ||
+        memcmp(magic, snapshotMagic, sizeof(magic)) != 0 ||
+        in.u8() != snapshotVersion)
+    {
+        return false;
+    }
+    screenWidth = in.f64();
+    screenHeight = in.f64();
+    uint32_t count = in.u32();
+    // every record takes at least 19 bytes, don't trust a bad count
+    if (!in.ok() || count > in.remaining() / 19) {
+        return false;
+    }
+    mascots.clear();
+    mascots.reserve(count);
+    for (uint32_t i=0; i<count; ++i) {
+        Mascot mascot;
+        mascot.lookingRight = (in.u8() & 1) != 0;
+        mascot.x = in.f64();
+        mascot.y = in.f64();
+        mascot.name.resize(in.u16());
+        if (!in.bytes(&mascot.name[0], mascot.name.size())) {
+            return false;
+        }
+        mascots.push_back(std::move(mascot));
+    }
+    return in.ok();
+}
+
+bool SceneSnapshot::write(std::string const& path) const {
+    Writer out;
+    out.bytes(snapshotMagic, sizeof(snapshotMagic));
+    out.u8(snapshotVersion);
+    out.f64(screenWidth);
+    out.f64(screenHeight);
+    out.u32(mascots.size());
+    for (auto &mascot : mascots) {
+        if (mascot.name.size() > 0xFFFF) {
+            return false;
+        }
+        out.u8(mascot.lookingRight ? 1 : 0);
+        out.f64(mascot.x);
+        out.f64(mascot.y);
+        out.u16(mascot.name.size());
+        out.bytes(mascot.name.data(), mascot.name.size());
+    }
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == NULL) {
+        return false;
+    }
+    auto &data = out.data();
+    bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return (fclose(file) == 0) && ok;
+}
@@ -0,0 +1,39 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compact binary record of the mascots on screen, written on exit and
+// read at boot so that the scene comes back where it was left. Only
+// what the runner can set from outside of libshijima is kept: the
+// behavior of every mascot starts over from its template.
+class SceneSnapshot {
+public:
+    struct Mascot {
+        std::string name;
+        double x, y;
+        bool lookingRight;
+    };
+    // screen area the positions were recorded in
+    double screenWidth = 0, screenHeight = 0;
+    std::vector<Mascot> mascots;
+    bool read(std::string const& path);
+    bool write(std::string const& path) const;
+};
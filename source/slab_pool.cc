@@ -0,0 +1,84 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "slab_pool.hpp"
+#include <cstdlib>
+#include <malloc.h>
+
+static size_t sizeClass(size_t size) {
+    size_t index = 0;
+    while ((size_t)16 << index < size) {
+        ++index;
+    }
+    return index;
+}
+
+bool SlabPool::init(size_t capacity) {
+    if (m_base != NULL) {
+        return false;
+    }
+    size_t pages = capacity / pageSize;
+    if (pages > maxPages) {
+        pages = maxPages;
+    }
+    m_base = pages > 0 ? (uint8_t *)memalign(32, pages * pageSize) : NULL;
+    m_pageCount = (m_base != NULL) ? pages : 0;
+    return m_base != NULL;
+}
+
+void *SlabPool::allocate(size_t size) {
+    if (m_base == NULL || size > maxBlockSize) {
+        return NULL;
+    }
+    size_t index = sizeClass(size == 0 ? 1 : size);
+    size_t block = (size_t)16 << index;
+    void *ptr;
+    if (m_free[index] != NULL) {
+        ptr = m_free[index];
+        m_free[index] = m_free[index]->next;
+    }
+    else {
+        if (m_bump[index] == m_bumpEnd[index]) {
+            if (m_nextPage == m_pageCount) {
+                return NULL;
+            }
+            m_pageClass[m_nextPage] = index;
+            m_bump[index] = m_base + m_nextPage * pageSize;
+            m_bumpEnd[index] = m_bump[index] + pageSize;
+            ++m_nextPage;
+        }
+        ptr = m_bump[index];
+        m_bump[index] += block;
+    }
+    m_inUse += block;
+    return ptr;
+}
+
+size_t SlabPool::blockSize(const void *ptr) const {
+    size_t page = ((const uint8_t *)ptr - m_base) / pageSize;
+    return (size_t)16 << m_pageClass[page];
+}
+
+void SlabPool::release(void *ptr) {
+    size_t page = ((uint8_t *)ptr - m_base) / pageSize;
+    size_t index = m_pageClass[page];
+    auto block = (FreeBlock *)ptr;
+    block->next = m_free[index];
+    m_free[index] = block;
+    m_inUse -= (size_t)16 << index;
+}
@@ -0,0 +1,71 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Size-class pools for the objects every live mascot owns. The pool
+// hands out pages of one region to size classes of 16 to 512 bytes on
+// demand, and freed blocks go back to their class, so long sessions of
+// breeding and dismissing reuse the same memory instead of slowly
+// fragmenting the heap.
+//
+// The pool does not allocate through operator new, so it can sit
+// behind it, see SlabScope in alloc_counter.hpp. It is not thread
+// safe: blocks have to be allocated and freed on one thread.
+class SlabPool {
+public:
+    static constexpr size_t pageSize = 16 * 1024;
+    static constexpr size_t maxPages = 256;
+    static constexpr size_t classCount = 6;
+    static constexpr size_t maxBlockSize = 16 << (classCount - 1);
+    constexpr SlabPool() {}
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+    // Reserves capacity bytes, rounded down to whole pages.
+    bool init(size_t capacity);
+    // NULL if size is over maxBlockSize or the region is full
+    void *allocate(size_t size);
+    void release(void *ptr);
+    bool owns(const void *ptr) const {
+        return m_base != NULL && (const uint8_t *)ptr >= m_base &&
+            (const uint8_t *)ptr < m_base + m_pageCount * pageSize;
+    }
+    size_t blockSize(const void *ptr) const;
+    size_t capacity() const {
+        return m_pageCount * pageSize;
+    }
+    size_t pagesUsed() const {
+        return m_nextPage;
+    }
+    size_t bytesInUse() const {
+        return m_inUse;
+    }
+private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+    uint8_t *m_base = NULL;
+    size_t m_pageCount = 0;
+    size_t m_nextPage = 0;
+    size_t m_inUse = 0;
+    uint8_t m_pageClass[maxPages] = {};
+    FreeBlock *m_free[classCount] = {};
+    uint8_t *m_bump[classCount] = {};
+    uint8_t *m_bumpEnd[classCount] = {};
+};
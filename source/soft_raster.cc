@@ -0,0 +1,244 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "soft_raster.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include "stb_image.h"
+#include "stb_image_write.h"
+
+SoftRaster::SoftRaster(int width, int height): m_width(width),
+    m_height(height), m_pixels((size_t)width * height * 4), m_shaded(0),
+    m_blended(0) {}
+
+void SoftRaster::clear(uint32_t color) {
+    for (size_t i=0; i<m_pixels.size(); i+=4) {
+        m_pixels[i] = color >> 24;
+        m_pixels[i+1] = (color >> 16) & 0xFF;
+        m_pixels[i+2] = (color >> 8) & 0xFF;
+        m_pixels[i+3] = color & 0xFF;
+    }
+}
+
+uint32_t SoftRaster::texel(Texture const& tex, int x, int y) {
+    // 4x4 blocks of 64 bytes, AR pairs followed by GB pairs
+    const uint8_t *block = tex.data +
+        ((y / 4) * (tex.width / 4) + (x / 4)) * 64;
+    int i = ((y % 4) * 4 + (x % 4)) * 2;
+    return ((uint32_t)block[i + 1] << 24) | ((uint32_t)block[i + 32] << 16) |
+        ((uint32_t)block[i + 33] << 8) | block[i];
+}
+
+// GX_MODULATE: texel times vertex color, per channel
+static uint32_t modulate(uint32_t a, uint32_t b) {
+    uint32_t result = 0;
+    for (int shift=0; shift<32; shift+=8) {
+        uint32_t ca = (a >> shift) & 0xFF, cb = (b >> shift) & 0xFF;
+        result |= ((ca * cb + 127) / 255) << shift;
+    }
+    return result;
+}
+
+void SoftRaster::blend(int x, int y, uint32_t color) {
+    uint32_t alpha = color & 0xFF;
+    if (alpha == 0) {
+        return;
+    }
+    uint8_t *dst = &m_pixels[((size_t)y * m_width + x) * 4];
+    ++m_shaded;
+    if (alpha == 255) {
+        dst[0] = color >> 24;
+        dst[1] = (color >> 16) & 0xFF;
+        dst[2] = (color >> 8) & 0xFF;
+        dst[3] = 255;
+        return;
+    }
+    ++m_blended;
+    for (int i=0; i<3; ++i) {
+        uint32_t src = (color >> (24 - i * 8)) & 0xFF;
+        dst[i] = (src * alpha + dst[i] * (255 - alpha) + 127) / 255;
+    }
+    dst[3] = std::max<uint32_t>(dst[3], alpha);
+}
+
+// pixels whose centers lie inside [x0, x1) x [y0, y1)
+static void pixelRange(float from, float to, int limit, int &first,
+    int &last)
+{
+    first = std::max(0, (int)std::ceil(from - 0.5f));
+    last = std::min(limit, (int)std::ceil(to - 0.5f));
+}
+
+void SoftRaster::fill(float x0, float y0, float x1, float y1,
+    uint32_t color)
+{
+    int xfirst, xlast, yfirst, ylast;
+    pixelRange(x0, x1, m_width, xfirst, xlast);
+    pixelRange(y0, y1, m_height, yfirst, ylast);
+    for (int y=yfirst; y<ylast; ++y) {
+        for (int x=xfirst; x<xlast; ++x) {
+            blend(x, y, color);
+        }
+    }
+}
+
+void SoftRaster::drawPart(float xpos, float ypos, float partx, float party,
+    float partw, float parth, Texture const& tex, float scaleX,
+    float scaleY, uint32_t color)
+{
+    if (tex.data == NULL || partw <= 0 || parth <= 0 || scaleX == 0 ||
+        scaleY == 0)
+    {
+        return;
+    }
+    // GRRLIB scales around the center of the part
+    float cx = xpos + partw / 2, cy = ypos + parth / 2;
+    float hw = std::fabs(scaleX) * partw / 2;
+    float hh = std::fabs(scaleY) * parth / 2;
+    float x0 = cx - hw, x1 = cx + hw, y0 = cy - hh, y1 = cy + hh;
+    int xfirst, xlast, yfirst, ylast;
+    pixelRange(x0, x1, m_width, xfirst, xlast);
+    pixelRange(y0, y1, m_height, yfirst, ylast);
+    for (int y=yfirst; y<ylast; ++y) {
+        float v = (y + 0.5f - y0) / (y1 - y0);
+        if (scaleY < 0) {
+            v = 1 - v;
+        }
+        int ty = std::min((int)(party + v * parth), tex.height - 1);
+        for (int x=xfirst; x<xlast; ++x) {
+            float u = (x + 0.5f - x0) / (x1 - x0);
+            if (scaleX < 0) {
+                u = 1 - u;
+            }
+            int tx = std::min((int)(partx + u * partw), tex.width - 1);
+            blend(x, y, modulate(texel(tex, tx, ty), color));
+        }
+    }
+}
+
+void SoftRaster::drawImg(float xpos, float ypos, Texture const& tex,
+    float scaleX, float scaleY, uint32_t color)
+{
+    drawPart(xpos, ypos, 0, 0, tex.width, tex.height, tex, scaleX, scaleY,
+        color);
+}
+
+void SoftRaster::quad(float x0, float y0, float x1, float y1, float s0,
+    float t0, float s1, float t1, Texture const *tex, uint32_t color)
+{
+    if (x0 > x1) {
+        std::swap(x0, x1);
+        std::swap(s0, s1);
+    }
+    if (y0 > y1) {
+        std::swap(y0, y1);
+        std::swap(t0, t1);
+    }
+    if (x1 - x0 <= 0 || y1 - y0 <= 0) {
+        return;
+    }
+    if (tex == NULL || tex->data == NULL) {
+        fill(x0, y0, x1, y1, color);
+        return;
+    }
+    int xfirst, xlast, yfirst, ylast;
+    pixelRange(x0, x1, m_width, xfirst, xlast);
+    pixelRange(y0, y1, m_height, yfirst, ylast);
+    for (int y=yfirst; y<ylast; ++y) {
+        float t = t0 + (t1 - t0) * (y + 0.5f - y0) / (y1 - y0);
+        int ty = std::min(std::max((int)(t * tex->height), 0),
+            tex->height - 1);
+        for (int x=xfirst; x<xlast; ++x) {
+            float s = s0 + (s1 - s0) * (x + 0.5f - x0) / (x1 - x0);
+            int tx = std::min(std::max((int)(s * tex->width), 0),
+                tex->width - 1);
+            blend(x, y, modulate(texel(*tex, tx, ty), color));
+        }
+    }
+}
+
+void SoftRaster::rectangle(float x, float y, float width, float height,
+    uint32_t color, bool filled)
+{
+    if (filled) {
+        fill(x, y, x + width, y + height, color);
+        return;
+    }
+    // one pixel wide outline, like the GX_LINESTRIP GRRLIB draws
+    fill(x, y, x + width, y + 1, color);
+    fill(x, y + height - 1, x + width, y + height, color);
+    fill(x, y + 1, x + 1, y + height - 1, color);
+    fill(x + width - 1, y + 1, x + width, y + height - 1, color);
+}
+
+void SoftRaster::printf(float xpos, float ypos, TileSet const& font,
+    uint32_t color, const char *text, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, text);
+    int len = vsnprintf(buf, sizeof(buf), text, args);
+    va_end(args);
+    if (len < 0 || font.tileWidth <= 0 || font.tileHeight <= 0) {
+        return;
+    }
+    len = std::min(len, (int)sizeof(buf) - 1);
+    int columns = font.texture.width / font.tileWidth;
+    int tileCount = columns * (font.texture.height / font.tileHeight);
+    for (int i=0; i<len; ++i) {
+        int tile = (int)(unsigned char)buf[i] - font.tileStart;
+        if (tile < 0 || tile >= tileCount) {
+            continue;
+        }
+        drawPart(xpos + i * font.tileWidth, ypos,
+            (tile % columns) * font.tileWidth,
+            (tile / columns) * font.tileHeight,
+            font.tileWidth, font.tileHeight, font.texture, 1, 1, color);
+    }
+}
+
+bool SoftRaster::writePNG(const char *path) const {
+    return stbi_write_png(path, m_width, m_height, 4, m_pixels.data(),
+        m_width * 4) != 0;
+}
+
+long SoftRaster::compareWithPNG(const char *path, int tolerance) const {
+    int width, height, comp;
+    uint8_t *golden = stbi_load(path, &width, &height, &comp, 4);
+    if (golden == NULL) {
+        return -1;
+    }
+    if (width != m_width || height != m_height) {
+        stbi_image_free(golden);
+        return -1;
+    }
+    long diff = 0;
+    for (size_t i=0; i<m_pixels.size(); i+=4) {
+        for (size_t j=i; j<i+4; ++j) {
+            if (std::abs((int)m_pixels[j] - (int)golden[j]) > tolerance) {
+                ++diff;
+                break;
+            }
+        }
+    }
+    stbi_image_free(golden);
+    return diff;
+}
@@ -0,0 +1,97 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU implementation of the GRRLIB primitives Shijima-Wii draws with,
+// for checking frames against golden images and measuring fill cost
+// on a computer. Textures are read in the same tiled GX_TF_RGBA8 layout
+// GRRLIB uploads, colors are 0xRRGGBBAA like in GRRLIB, and blending
+// is source alpha over the framebuffer like GRRLIB's default blend
+// mode. Texels are sampled with nearest filtering.
+//
+// This does not depend on libogc and is not part of the Wii build. The
+// host tests draw through it with the GRRLIB and GX shim in tests/host.
+class SoftRaster {
+public:
+    struct Texture {
+        const uint8_t *data;
+        int width, height;
+    };
+    // GRRLIB tileset font, see GRRLIB_InitTileSet()
+    struct TileSet {
+        Texture texture;
+        int tileWidth, tileHeight;
+        int tileStart;
+    };
+    SoftRaster(int width, int height);
+    int width() const {
+        return m_width;
+    }
+    int height() const {
+        return m_height;
+    }
+    void clear(uint32_t color);
+    // GRRLIB_DrawPart() and GRRLIB_DrawImg() without rotation. A
+    // negative scale mirrors the image around its center.
+    void drawPart(float xpos, float ypos, float partx, float party,
+        float partw, float parth, Texture const& tex, float scaleX,
+        float scaleY, uint32_t color);
+    void drawImg(float xpos, float ypos, Texture const& tex, float scaleX,
+        float scaleY, uint32_t color);
+    void rectangle(float x, float y, float width, float height,
+        uint32_t color, bool filled);
+    // An axis aligned GX_QUADS quad from x0,y0 to x1,y1 with texture
+    // coordinates s0,t0 at the first corner and s1,t1 at the opposite
+    // one, modulated by color. Without a texture only color is drawn.
+    void quad(float x0, float y0, float x1, float y1, float s0, float t0,
+        float s1, float t1, Texture const *tex, uint32_t color);
+    void printf(float xpos, float ypos, TileSet const& font, uint32_t color,
+        const char *text, ...) __attribute__((format(printf, 6, 7)));
+    // RGBA texel of a GX_TF_RGBA8 texture, like GRRLIB_GetPixelFromtexImg()
+    static uint32_t texel(Texture const& tex, int x, int y);
+    // RGBA8 framebuffer, rows from the top
+    const uint8_t *pixels() const {
+        return m_pixels.data();
+    }
+    bool writePNG(const char *path) const;
+    // Number of pixels that differ from the PNG at path by more than
+    // tolerance in any channel, or -1 if it couldn't be read or has
+    // another size.
+    long compareWithPNG(const char *path, int tolerance) const;
+    // pixels written, and those of them that mixed with the framebuffer
+    // because their alpha was neither 0 nor 255, since resetStats()
+    uint64_t shadedPixels() const {
+        return m_shaded;
+    }
+    uint64_t blendedPixels() const {
+        return m_blended;
+    }
+    void resetStats() {
+        m_shaded = m_blended = 0;
+    }
+private:
+    void blend(int x, int y, uint32_t color);
+    void fill(float x0, float y0, float x1, float y1, uint32_t color);
+    int m_width, m_height;
+    std::vector<uint8_t> m_pixels;
+    uint64_t m_shaded;
+    uint64_t m_blended;
+};
@@ -0,0 +1,116 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Uniform grid over a rectangular area for point queries. Items are
+// stored in every cell their rectangle touches; anything outside of
+// the area is clamped into the border cells. Clearing keeps the
+// memory of every cell, so rebuilding the grid each frame does not
+// allocate once it has warmed up.
+template<typename T>
+class SpatialGrid {
+public:
+    SpatialGrid(): m_columns(0), m_rows(0), m_cellSize(1) {}
+    void reset(double width, double height, double cellSize) {
+        m_cellSize = cellSize;
+        m_columns = std::max((int)std::ceil(width / cellSize), 1);
+        m_rows = std::max((int)std::ceil(height / cellSize), 1);
+        m_cells.clear();
+        m_cells.resize(m_columns * m_rows);
+    }
+    void clear() {
+        for (auto &cell : m_cells) {
+            cell.clear();
+        }
+    }
+    void insert(T const& item, double x, double y, double width,
+        double height)
+    {
+        int x0 = column(x), x1 = column(x + width);
+        int y0 = row(y), y1 = row(y + height);
+        for (int cy=y0; cy<=y1; ++cy) {
+            for (int cx=x0; cx<=x1; ++cx) {
+                m_cells[cy * m_columns + cx].push_back(item);
+            }
+        }
+    }
+    void remove(T const& item) {
+        for (auto &cell : m_cells) {
+            cell.erase(std::remove(cell.begin(), cell.end(), item),
+                cell.end());
+        }
+    }
+    // Calls callback for the items of the cell containing x,y, most
+    // recently inserted first, until it returns true.
+    template<typename F>
+    bool findAt(double x, double y, F callback) const {
+        if (m_cells.empty()) {
+            return false;
+        }
+        auto &cell = m_cells[row(y) * m_columns + column(x)];
+        for (auto iter = cell.rbegin(); iter != cell.rend(); ++iter) {
+            if (callback(*iter)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    // Calls callback for the items of every cell that overlaps the
+    // square of the given radius around x,y. Items inserted with a
+    // rectangle may be visited more than once.
+    template<typename F>
+    void forEachNear(double x, double y, double radius, F callback) const {
+        if (m_cells.empty()) {
+            return;
+        }
+        int x0 = column(x - radius), x1 = column(x + radius);
+        int y0 = row(y - radius), y1 = row(y + radius);
+        for (int cy=y0; cy<=y1; ++cy) {
+            for (int cx=x0; cx<=x1; ++cx) {
+                for (auto &item : m_cells[cy * m_columns + cx]) {
+                    callback(item);
+                }
+            }
+        }
+    }
+private:
+    int column(double x) const {
+        return clampIndex(x, m_columns);
+    }
+    int row(double y) const {
+        return clampIndex(y, m_rows);
+    }
+    int clampIndex(double pos, int count) const {
+        double index = std::floor(pos / m_cellSize);
+        if (!(index >= 0)) {
+            return 0;
+        }
+        if (index >= count) {
+            return count - 1;
+        }
+        return (int)index;
+    }
+    std::vector<std::vector<T>> m_cells;
+    int m_columns;
+    int m_rows;
+    double m_cellSize;
+};
@@ -0,0 +1,47 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+// Reduces the image path of an animation frame ("img/Shime1.png") to
+// the key sprites are stored under ("shime1"): no directory, no
+// extension, ASCII lowercase. The key is written to buffer, so looking
+// up a sprite on every frame does not allocate. Returns an empty view
+// with a NULL data pointer if the key does not fit.
+inline std::string_view spriteKey(std::string_view name, char *buffer,
+    size_t capacity)
+{
+    auto slash = name.find_last_of('/');
+    if (slash != std::string_view::npos) {
+        name.remove_prefix(slash + 1);
+    }
+    auto dot = name.find_last_of('.');
+    if (dot != std::string_view::npos && dot != 0 && name != "..") {
+        name = name.substr(0, dot);
+    }
+    if (name.size() > capacity) {
+        return {};
+    }
+    for (size_t i=0; i<name.size(); ++i) {
+        char c = name[i];
+        buffer[i] = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+    }
+    return { buffer, name.size() };
+}
@@ -0,0 +1,106 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "text_batch.hpp"
+#include <cstdarg>
+#include <cstdio>
+
+void TextBatch::init(GRRLIB_texImg *font, size_t capacity) {
+    m_font = font;
+    m_glyphs.clear();
+    // one GX_Begin() takes at most 65535 vertices
+    if (capacity > 65535 / 4) {
+        capacity = 65535 / 4;
+    }
+    m_glyphs.reserve(capacity);
+}
+
+void TextBatch::print(f32 xpos, f32 ypos, u32 color, const char *text, ...) {
+    if (m_font == NULL) {
+        return;
+    }
+    char buf[256];
+    va_list args;
+    va_start(args, text);
+    int len = vsnprintf(buf, sizeof(buf), text, args);
+    va_end(args);
+    if (len < 0) {
+        return;
+    }
+    if (len > (int)sizeof(buf) - 1) {
+        len = sizeof(buf) - 1;
+    }
+    u32 tileCount = m_font->nbtilew * m_font->nbtileh;
+    for (int i=0; i<len; ++i) {
+        int tile = (int)(unsigned char)buf[i] - (int)m_font->tilestart;
+        if (tile < 0 || (u32)tile >= tileCount) {
+            continue;
+        }
+        if (m_glyphs.size() == m_glyphs.capacity()) {
+            flush();
+        }
+        m_glyphs.push_back({ xpos + i * m_font->tilew, ypos, color,
+            (u32)tile });
+    }
+}
+
+void TextBatch::flush() {
+    if (m_glyphs.empty()) {
+        return;
+    }
+    GXTexObj texObj;
+    GX_InitTexObj(&texObj, m_font->data, m_font->w, m_font->h,
+        GX_TF_RGBA8, GX_CLAMP, GX_CLAMP, GX_FALSE);
+    if (!GRRLIB_Settings.antialias) {
+        GX_InitTexObjLOD(&texObj, GX_NEAR, GX_NEAR, 0.0f, 0.0f, 0.0f,
+            0, 0, GX_ANISO_1);
+    }
+    GX_LoadTexObj(&texObj, GX_TEXMAP0);
+    GX_SetTevOp(GX_TEVSTAGE0, GX_MODULATE);
+    GX_SetVtxDesc(GX_VA_TEX0, GX_DIRECT);
+    GX_LoadPosMtxImm(GXmodelView2D, GX_PNMTX0);
+
+    f32 tw = m_font->tilew, th = m_font->tileh;
+    f32 sw = tw / m_font->w, sh = th / m_font->h;
+    GX_Begin(GX_QUADS, GX_VTXFMT0, m_glyphs.size() * 4);
+    for (auto &glyph : m_glyphs) {
+        f32 s1 = (glyph.tile % m_font->nbtilew) * sw;
+        f32 t1 = (glyph.tile / m_font->nbtilew) * sh;
+        f32 s2 = s1 + sw, t2 = t1 + sh;
+        GX_Position3f32(glyph.x, glyph.y, 0);
+        GX_Color1u32(glyph.color);
+        GX_TexCoord2f32(s1, t1);
+        GX_Position3f32(glyph.x + tw, glyph.y, 0);
+        GX_Color1u32(glyph.color);
+        GX_TexCoord2f32(s2, t1);
+        GX_Position3f32(glyph.x + tw, glyph.y + th, 0);
+        GX_Color1u32(glyph.color);
+        GX_TexCoord2f32(s2, t2);
+        GX_Position3f32(glyph.x, glyph.y + th, 0);
+        GX_Color1u32(glyph.color);
+        GX_TexCoord2f32(s1, t2);
+    }
+    GX_End();
+
+    GX_SetTevOp(GX_TEVSTAGE0, GX_PASSCLR);
+    GX_SetVtxDesc(GX_VA_TEX0, GX_NONE);
+
+    m_glyphCount += m_glyphs.size();
+    ++m_drawCount;
+    m_glyphs.clear();
+}
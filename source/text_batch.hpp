@@ -0,0 +1,54 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <grrlib.h>
+#include <vector>
+
+// Collects the glyphs printed with a GRRLIB tileset font during a frame
+// and submits them as a single textured quad stream in flush(), instead
+// of one GX_Begin()/GX_End() with its own texture setup per character
+// like GRRLIB_Printf() does.
+class TextBatch {
+public:
+    TextBatch(): m_font(NULL), m_glyphCount(0), m_drawCount(0) {}
+    void init(GRRLIB_texImg *font, size_t capacity);
+    void print(f32 xpos, f32 ypos, u32 color, const char *text, ...)
+        __attribute__((format(printf, 5, 6)));
+    void flush();
+    // glyphs and draw calls submitted since the last resetStats()
+    unsigned glyphCount() const {
+        return m_glyphCount;
+    }
+    unsigned drawCount() const {
+        return m_drawCount;
+    }
+    void resetStats() {
+        m_glyphCount = m_drawCount = 0;
+    }
+private:
+    struct Glyph {
+        f32 x, y;
+        u32 color;
+        u32 tile;
+    };
+    GRRLIB_texImg *m_font;
+    std::vector<Glyph> m_glyphs;
+    unsigned m_glyphCount;
+    unsigned m_drawCount;
+};
@@ -0,0 +1,304 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Cache state of a slot, kept in the slot as m_links
+template<typename Slot>
+struct TextureCacheLinks {
+    Slot *prev = nullptr;
+    Slot *next = nullptr;
+    bool cached = false;
+    // decoded ahead and not drawn since
+    bool prefetched = false;
+    uint32_t lastUse = 0;
+    // frame of the draw that missed it, 0 if no draw is waiting
+    uint32_t waitingSince = 0;
+    // the slots drawn after this one the last two times a mascot moved
+    // on from it, the latest first
+    Slot *successors[2] = {};
+};
+
+// Least recently drawn list of the resident slots, with the decoded
+// bytes kept under a budget. Textures in use this frame are never
+// evicted, so the budget can be exceeded for a frame.
+//
+// A draw that misses doesn't decode. The slot waits for prefetch(),
+// which runs in idle time, and the caller draws something else, unless
+// the slot has waited for maxWaitFrames already.
+//
+// prefetch() also decodes what is likely to be drawn next. libshijima
+// doesn't expose the frames of an action or which action comes next,
+// so they are learned from the slots that mascots draw: the chain of
+// latest successors of a slot stands for the rest of its action, and
+// the other successor for the action that followed last time.
+//
+// A slot should only get successors from its own set, such as the
+// sheets of one mascot, and a set has to be removed as a whole before
+// the next prefetch(), so that no chain leads to a freed slot.
+//
+// Slot has to make TextureCache a friend, keep a TextureCacheLinks<Slot>
+// as m_links, and have resident(), failed(), decodedBytes(),
+// expectedBytes(), bool load() and unload().
+template<typename Slot>
+class TextureCache {
+public:
+    static constexpr uint32_t maxWaitFrames = 3;
+    // slots along the chain of successors that prefetch() looks at
+    static constexpr int prefetchDepth = 3;
+    explicit TextureCache(size_t budget): m_budget(budget) {}
+    // Makes slot resident for a draw. Returns false if the draw has to
+    // wait for idle time.
+    bool draw(Slot *slot) {
+        auto &links = slot->m_links;
+        links.prefetched = false;
+        if (slot->resident()) {
+            ++m_hits;
+            return use(slot);
+        }
+        if (slot->failed()) {
+            return false;
+        }
+        if (links.waitingSince == 0) {
+            ++m_misses;
+            links.waitingSince = m_frame;
+            m_waiting.push_back(slot);
+        }
+        if (m_frame - links.waitingSince < maxWaitFrames) {
+            return false;
+        }
+        // no idle time came, so the draw pays for it
+        ++m_lateDecodes;
+        stopWaiting(slot);
+        return use(slot);
+    }
+    // Makes slot resident right away, for callers that need the pixels
+    bool acquire(Slot *slot) {
+        slot->m_links.prefetched = false;
+        if (slot->resident()) {
+            ++m_hits;
+        }
+        else if (!slot->failed()) {
+            ++m_misses;
+        }
+        stopWaiting(slot);
+        return use(slot);
+    }
+    // records that a mascot drew next right after prev
+    void follow(Slot *prev, Slot *next) {
+        auto &successors = prev->m_links.successors;
+        if (successors[0] != next) {
+            successors[1] = successors[0];
+            successors[0] = next;
+        }
+        if (std::find(m_prefetch.begin(), m_prefetch.end(), next) ==
+            m_prefetch.end())
+        {
+            m_prefetch.push_back(next);
+        }
+    }
+    // for slots about to be freed
+    void remove(Slot *slot) {
+        if (slot->m_links.cached) {
+            unlink(slot);
+        }
+        stopWaiting(slot);
+        m_prefetch.erase(std::remove(m_prefetch.begin(), m_prefetch.end(),
+            slot), m_prefetch.end());
+    }
+    void beginFrame() {
+        ++m_frame;
+    }
+    // Decodes one texture, one that a draw waits for first. Returns
+    // false if there is none or if a predicted one would evict a
+    // texture that is about to be drawn.
+    bool prefetch() {
+        while (!m_waiting.empty()) {
+            auto slot = m_waiting.front();
+            m_waiting.pop_front();
+            slot->m_links.waitingSince = 0;
+            if (slot->resident() || slot->failed()) {
+                continue;
+            }
+            ++m_idleDecodes;
+            use(slot);
+            return true;
+        }
+        while (!m_prefetch.empty()) {
+            auto next = predict(m_prefetch.back());
+            if (next == nullptr) {
+                m_prefetch.pop_back();
+                continue;
+            }
+            // don't make room by evicting what is about to be drawn
+            if (m_budget != 0 && m_resident + next->expectedBytes() >
+                m_budget && m_tail != nullptr &&
+                (m_tail->m_links.prefetched ||
+                m_tail->m_links.lastUse == m_frame))
+            {
+                return false;
+            }
+            ++m_prefetches;
+            use(next);
+            next->m_links.prefetched = true;
+            return true;
+        }
+        return false;
+    }
+    // decoded size of the texture the next prefetch() is likely to
+    // decode, 0 if there is none
+    size_t nextPrefetchBytes() {
+        for (auto slot : m_waiting) {
+            if (!slot->resident() && !slot->failed()) {
+                return slot->expectedBytes();
+            }
+        }
+        for (auto iter = m_prefetch.rbegin(); iter != m_prefetch.rend();
+            ++iter)
+        {
+            if (auto next = predict(*iter)) {
+                return next->expectedBytes();
+            }
+        }
+        return 0;
+    }
+    size_t budget() const {
+        return m_budget;
+    }
+    size_t residentBytes() const {
+        return m_resident;
+    }
+    size_t peakBytes() const {
+        return m_peak;
+    }
+    uint64_t hits() const {
+        return m_hits;
+    }
+    uint64_t misses() const {
+        return m_misses;
+    }
+    uint64_t prefetches() const {
+        return m_prefetches;
+    }
+    // misses that were decoded in idle time
+    uint64_t idleDecodes() const {
+        return m_idleDecodes;
+    }
+    // misses that were decoded by a draw after maxWaitFrames
+    uint64_t lateDecodes() const {
+        return m_lateDecodes;
+    }
+    uint64_t evictions() const {
+        return m_evictions;
+    }
+    // hits per 1000 draws
+    unsigned hitRate() const {
+        uint64_t total = m_hits + m_misses;
+        return total == 0 ? 1000 : (unsigned)(m_hits * 1000 / total);
+    }
+private:
+    // The first slot after from that isn't resident: along the chain of
+    // latest successors, each step followed by its other successor
+    Slot *predict(Slot *from) {
+        Slot *step = from;
+        for (int depth=0; depth<prefetchDepth && step != nullptr; ++depth) {
+            auto &successors = step->m_links.successors;
+            for (auto candidate : successors) {
+                if (candidate != nullptr && !candidate->resident() &&
+                    !candidate->failed())
+                {
+                    return candidate;
+                }
+            }
+            step = successors[0];
+        }
+        return nullptr;
+    }
+    void stopWaiting(Slot *slot) {
+        if (slot->m_links.waitingSince != 0) {
+            slot->m_links.waitingSince = 0;
+            m_waiting.erase(std::remove(m_waiting.begin(), m_waiting.end(),
+                slot), m_waiting.end());
+        }
+    }
+    bool use(Slot *slot) {
+        if (!slot->load()) {
+            return false;
+        }
+        slot->m_links.lastUse = m_frame;
+        if (slot->m_links.cached) {
+            unlink(slot);
+        }
+        link(slot);
+        m_peak = std::max(m_peak, m_resident);
+        while (m_budget != 0 && m_resident > m_budget && m_tail != nullptr &&
+            m_tail->m_links.lastUse != m_frame)
+        {
+            auto victim = m_tail;
+            unlink(victim);
+            victim->unload();
+            ++m_evictions;
+        }
+        return true;
+    }
+    void link(Slot *slot) {
+        auto &links = slot->m_links;
+        links.prev = nullptr;
+        links.next = m_head;
+        if (m_head != nullptr) {
+            m_head->m_links.prev = slot;
+        }
+        m_head = slot;
+        if (m_tail == nullptr) {
+            m_tail = slot;
+        }
+        links.cached = true;
+        m_resident += slot->decodedBytes();
+    }
+    void unlink(Slot *slot) {
+        auto &links = slot->m_links;
+        (links.prev != nullptr ? links.prev->m_links.next : m_head) =
+            links.next;
+        (links.next != nullptr ? links.next->m_links.prev : m_tail) =
+            links.prev;
+        links.prev = links.next = nullptr;
+        links.cached = false;
+        m_resident -= slot->decodedBytes();
+    }
+    Slot *m_head = nullptr;
+    Slot *m_tail = nullptr;
+    // slots that draws wait for, oldest first
+    std::deque<Slot *> m_waiting;
+    // slots that mascots moved on to, latest last
+    std::vector<Slot *> m_prefetch;
+    size_t m_budget;
+    size_t m_resident = 0;
+    size_t m_peak = 0;
+    uint32_t m_frame = 1;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+    uint64_t m_prefetches = 0;
+    uint64_t m_idleDecodes = 0;
+    uint64_t m_lateDecodes = 0;
+    uint64_t m_evictions = 0;
+};
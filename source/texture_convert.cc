@@ -0,0 +1,240 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "texture_convert.hpp"
+#include <cstring>
+
+// TEXTURE_CONVERT_WORDS can be defined to test the Wii kernel on a
+// little endian host, where its loads and stores are byte swapped
+#if defined(TEXTURE_CONVERT_WORDS)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXTURE_CONVERT_SSE2
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define TEXTURE_CONVERT_WORDS
+#endif
+
+const char *textureConvertKernel() {
+    #if defined(TEXTURE_CONVERT_SSE2)
+    return "sse2";
+    #elif defined(TEXTURE_CONVERT_WORDS)
+    return "words";
+    #else
+    return "scalar";
+    #endif
+}
+
+void tileRGBA8Scalar(const uint8_t *rgba, int width, int height,
+    uint8_t *tiles)
+{
+    for (int ty=0; ty<height; ty+=4) {
+        for (int tx=0; tx<width; tx+=4) {
+            for (int y=0; y<4; ++y) {
+                const uint8_t *src = rgba + ((ty + y) * width + tx) * 4;
+                for (int x=0; x<4; ++x) {
+                    int i = (y * 4 + x) * 2;
+                    tiles[i] = src[x * 4 + 3];
+                    tiles[i + 1] = src[x * 4];
+                    tiles[32 + i] = src[x * 4 + 1];
+                    tiles[32 + i + 1] = src[x * 4 + 2];
+                }
+            }
+            tiles += 64;
+        }
+    }
+}
+
+size_t alphaMaskSize(int width, int height) {
+    return (size_t)((width + 7) / 8) * height;
+}
+
+void buildAlphaMaskScalar(const uint8_t *rgba, int width, int height,
+    uint8_t *mask)
+{
+    memset(mask, 0, alphaMaskSize(width, height));
+    int stride = (width + 7) / 8;
+    for (int y=0; y<height; ++y) {
+        for (int x=0; x<width; ++x) {
+            if (rgba[(y * width + x) * 4 + 3] != 0) {
+                mask[y * stride + x / 8] |= 0x80 >> (x % 8);
+            }
+        }
+    }
+}
+
+#if defined(TEXTURE_CONVERT_SSE2)
+
+// 16-bit values in the low half of each 32-bit lane, sign extended so
+// that _mm_packs_epi32() keeps them intact
+static inline __m128i lowHalves(__m128i value) {
+    return _mm_srai_epi32(_mm_slli_epi32(value, 16), 16);
+}
+
+// A little endian lane holds A << 24 | B << 16 | G << 8 | R. The pairs
+// are stored as A, R and G, B, so as 16-bit values R << 8 | A and
+// B << 8 | G.
+static inline void tileRows(__m128i row0, __m128i row1, uint8_t *ar,
+    uint8_t *gb)
+{
+    const __m128i low = _mm_set1_epi32(0xFF);
+    __m128i ar0 = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(row0, low), 8),
+        _mm_srli_epi32(row0, 24));
+    __m128i ar1 = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(row1, low), 8),
+        _mm_srli_epi32(row1, 24));
+    __m128i gb0 = _mm_srai_epi32(_mm_slli_epi32(row0, 8), 16);
+    __m128i gb1 = _mm_srai_epi32(_mm_slli_epi32(row1, 8), 16);
+    _mm_storeu_si128((__m128i *)ar, _mm_packs_epi32(lowHalves(ar0),
+        lowHalves(ar1)));
+    _mm_storeu_si128((__m128i *)gb, _mm_packs_epi32(gb0, gb1));
+}
+
+void tileRGBA8(const uint8_t *rgba, int width, int height, uint8_t *tiles) {
+    size_t stride = (size_t)width * 4;
+    for (int ty=0; ty<height; ty+=4) {
+        const uint8_t *src = rgba + ty * stride;
+        for (int tx=0; tx<width; tx+=4) {
+            __m128i rows[4];
+            for (int y=0; y<4; ++y) {
+                rows[y] = _mm_loadu_si128((const __m128i *)(src + y * stride));
+            }
+            tileRows(rows[0], rows[1], tiles, tiles + 32);
+            tileRows(rows[2], rows[3], tiles + 16, tiles + 48);
+            src += 16;
+            tiles += 64;
+        }
+    }
+}
+
+static inline uint8_t reverseBits(uint8_t bits) {
+    bits = (bits & 0xF0) >> 4 | (bits & 0x0F) << 4;
+    bits = (bits & 0xCC) >> 2 | (bits & 0x33) << 2;
+    return (bits & 0xAA) >> 1 | (bits & 0x55) << 1;
+}
+
+void buildAlphaMask(const uint8_t *rgba, int width, int height,
+    uint8_t *mask)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int stride = (width + 7) / 8;
+    int full = width / 8;
+    for (int y=0; y<height; ++y) {
+        const uint8_t *src = rgba + (size_t)y * width * 4;
+        uint8_t *out = mask + (size_t)y * stride;
+        for (int x=0; x<full; ++x) {
+            __m128i px0 = _mm_loadu_si128((const __m128i *)src);
+            __m128i px1 = _mm_loadu_si128((const __m128i *)(src + 16));
+            // one bit per lane where alpha is 0, first pixel lowest
+            int empty = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(
+                _mm_srli_epi32(px0, 24), zero))) |
+                _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(
+                _mm_srli_epi32(px1, 24), zero))) << 4;
+            out[x] = reverseBits(~empty & 0xFF);
+            src += 32;
+        }
+        if (full < stride) {
+            uint8_t bits = 0;
+            for (int x=full*8; x<width; ++x, src += 4) {
+                if (src[3] != 0) {
+                    bits |= 0x80 >> (x % 8);
+                }
+            }
+            out[full] = bits;
+        }
+    }
+}
+
+#elif defined(TEXTURE_CONVERT_WORDS)
+
+// A big endian word holds R << 24 | G << 16 | B << 8 | A, rotating it
+// left by 8 bits puts A, R in its low half. The PowerPC does each pair
+// with one rotate-and-mask instruction.
+static inline uint32_t load32(const uint8_t *src) {
+    uint32_t value;
+    memcpy(&value, src, 4);
+    #if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap32(value);
+    #endif
+    return value;
+}
+
+static inline void store32(uint8_t *dst, uint32_t value) {
+    #if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap32(value);
+    #endif
+    memcpy(dst, &value, 4);
+}
+
+static inline uint32_t rotl8(uint32_t value) {
+    return (value << 8) | (value >> 24);
+}
+
+void tileRGBA8(const uint8_t *rgba, int width, int height, uint8_t *tiles) {
+    size_t stride = (size_t)width * 4;
+    for (int ty=0; ty<height; ty+=4) {
+        const uint8_t *src = rgba + ty * stride;
+        for (int tx=0; tx<width; tx+=4) {
+            for (int y=0; y<4; ++y) {
+                const uint8_t *row = src + y * stride;
+                uint32_t p0 = load32(row), p1 = load32(row + 4);
+                uint32_t p2 = load32(row + 8), p3 = load32(row + 12);
+                uint8_t *ar = tiles + y * 8, *gb = tiles + 32 + y * 8;
+                store32(ar, (rotl8(p0) << 16) | (rotl8(p1) & 0xFFFF));
+                store32(ar + 4, (rotl8(p2) << 16) | (rotl8(p3) & 0xFFFF));
+                store32(gb, ((p0 << 8) & 0xFFFF0000) | ((p1 >> 8) & 0xFFFF));
+                store32(gb + 4, ((p2 << 8) & 0xFFFF0000) |
+                    ((p3 >> 8) & 0xFFFF));
+            }
+            src += 16;
+            tiles += 64;
+        }
+    }
+}
+
+void buildAlphaMask(const uint8_t *rgba, int width, int height,
+    uint8_t *mask)
+{
+    int stride = (width + 7) / 8;
+    for (int y=0; y<height; ++y) {
+        const uint8_t *src = rgba + (size_t)y * width * 4;
+        uint8_t *out = mask + (size_t)y * stride;
+        for (int x=0; x<width; x+=8) {
+            uint8_t bits = 0;
+            for (int i=0; i<8; ++i, src += 4) {
+                bits <<= 1;
+                if (x + i < width && (load32(src) & 0xFF) != 0) {
+                    bits |= 1;
+                }
+            }
+            out[x / 8] = bits;
+        }
+    }
+}
+
+#else
+
+void tileRGBA8(const uint8_t *rgba, int width, int height, uint8_t *tiles) {
+    tileRGBA8Scalar(rgba, width, height, tiles);
+}
+
+void buildAlphaMask(const uint8_t *rgba, int width, int height,
+    uint8_t *mask)
+{
+    buildAlphaMaskScalar(rgba, width, height, mask);
+}
+
+#endif
@@ -0,0 +1,52 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Conversions from decoded RGBA8 images (row by row, 4 bytes per pixel
+// in R, G, B, A order) to what the textures of mascots need. Each has a
+// scalar reference and the kernel picked at compile time, which is what
+// the unsuffixed name calls:
+//  - SSE2 on x86 hosts
+//  - 32-bit word operations on big endian targets like the Wii, whose
+//    CPU has no integer SIMD (paired singles only work on floats)
+//  - the scalar reference everywhere else
+
+// Name of the kernel the unsuffixed functions use
+const char *textureConvertKernel();
+
+// Writes the 4x4 tiles of GX_TF_RGBA8: per tile, the alpha and red
+// bytes of its 16 pixels, then their green and blue bytes. width and
+// height have to be multiples of 4, tiles holds width * height * 4
+// bytes.
+void tileRGBA8(const uint8_t *rgba, int width, int height, uint8_t *tiles);
+void tileRGBA8Scalar(const uint8_t *rgba, int width, int height,
+    uint8_t *tiles);
+
+// One bit per pixel, set where alpha is not 0. Rows start on a byte and
+// the first pixel of a byte is its most significant bit.
+size_t alphaMaskSize(int width, int height);
+void buildAlphaMask(const uint8_t *rgba, int width, int height,
+    uint8_t *mask);
+void buildAlphaMaskScalar(const uint8_t *rgba, int width, int height,
+    uint8_t *mask);
+
+inline bool alphaMaskAt(const uint8_t *mask, int width, int x, int y) {
+    return (mask[y * ((width + 7) / 8) + x / 8] >> (7 - x % 8)) & 1;
+}
@@ -0,0 +1,200 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+
+// Minimal threading primitives. On the Wii these wrap libogc's LWP
+// threads, mutexes and condition variables, elsewhere the standard
+// library equivalents.
+
+#ifdef GEKKO
+#include <ogc/lwp.h>
+#include <ogc/mutex.h>
+#include <ogc/cond.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+#endif
+
+class Mutex {
+public:
+    Mutex(const Mutex &) = delete;
+    Mutex &operator=(const Mutex &) = delete;
+#ifdef GEKKO
+    Mutex() {
+        LWP_MutexInit(&m_mutex, false);
+    }
+    ~Mutex() {
+        LWP_MutexDestroy(m_mutex);
+    }
+    void lock() {
+        LWP_MutexLock(m_mutex);
+    }
+    void unlock() {
+        LWP_MutexUnlock(m_mutex);
+    }
+private:
+    friend class CondVar;
+    mutex_t m_mutex;
+#else
+    Mutex() {}
+    void lock() {
+        m_mutex.lock();
+    }
+    void unlock() {
+        m_mutex.unlock();
+    }
+private:
+    std::mutex m_mutex;
+#endif
+};
+
+class CondVar {
+public:
+    CondVar(const CondVar &) = delete;
+    CondVar &operator=(const CondVar &) = delete;
+#ifdef GEKKO
+    CondVar() {
+        LWP_CondInit(&m_cond);
+    }
+    ~CondVar() {
+        LWP_CondDestroy(m_cond);
+    }
+    // the mutex must be locked by the caller
+    void wait(Mutex &mutex) {
+        LWP_CondWait(m_cond, mutex.m_mutex);
+    }
+    void waitFor(Mutex &mutex, unsigned millis) {
+        // libogc takes a relative timeout
+        struct timespec timeout;
+        timeout.tv_sec = millis / 1000;
+        timeout.tv_nsec = (millis % 1000) * 1000000;
+        LWP_CondTimedWait(m_cond, mutex.m_mutex, &timeout);
+    }
+    void signal() {
+        LWP_CondSignal(m_cond);
+    }
+    void broadcast() {
+        LWP_CondBroadcast(m_cond);
+    }
+private:
+    cond_t m_cond;
+#else
+    CondVar() {}
+    void wait(Mutex &mutex) {
+        m_cond.wait(mutex);
+    }
+    void waitFor(Mutex &mutex, unsigned millis) {
+        m_cond.wait_for(mutex, std::chrono::milliseconds(millis));
+    }
+    void signal() {
+        m_cond.notify_one();
+    }
+    void broadcast() {
+        m_cond.notify_all();
+    }
+private:
+    std::condition_variable_any m_cond;
+#endif
+};
+
+class Thread {
+public:
+    // Priorities follow libogc, higher runs first. The main thread runs
+    // at 64, so background work should stay below that and only runs
+    // while the main thread waits for the GPU or vsync.
+    static constexpr int lowPriority = 40;
+    Thread(const Thread &) = delete;
+    Thread &operator=(const Thread &) = delete;
+    ~Thread() {
+        join();
+    }
+#ifdef GEKKO
+    Thread(): m_thread(LWP_THREAD_NULL) {}
+    bool start(void *(*entry)(void *), void *arg, int priority,
+        size_t stackSize = 64 * 1024)
+    {
+        if (m_thread != LWP_THREAD_NULL) {
+            return false;
+        }
+        return LWP_CreateThread(&m_thread, entry, arg, NULL, stackSize,
+            priority) >= 0;
+    }
+    bool running() const {
+        return m_thread != LWP_THREAD_NULL;
+    }
+    void join() {
+        if (m_thread != LWP_THREAD_NULL) {
+            LWP_JoinThread(m_thread, NULL);
+            m_thread = LWP_THREAD_NULL;
+        }
+    }
+private:
+    lwp_t m_thread;
+#else
+    // pthreads rather than std::thread, so that host tests can make
+    // thread creation fail by wrapping pthread_create()
+    Thread(): m_running(false) {}
+    bool start(void *(*entry)(void *), void *arg, int priority,
+        size_t stackSize = 64 * 1024)
+    {
+        (void)priority;
+        (void)stackSize;
+        if (m_running) {
+            return false;
+        }
+        m_running = pthread_create(&m_thread, NULL, entry, arg) == 0;
+        return m_running;
+    }
+    bool running() const {
+        return m_running;
+    }
+    void join() {
+        if (m_running) {
+            pthread_join(m_thread, NULL);
+            m_running = false;
+        }
+    }
+private:
+    pthread_t m_thread;
+    bool m_running;
+#endif
+};
+
+#ifdef GEKKO
+typedef lwp_t ThreadId;
+inline ThreadId currentThreadId() {
+    return LWP_GetSelf();
+}
+inline void sleepMillis(unsigned millis) {
+    usleep(millis * 1000);
+}
+#else
+typedef std::thread::id ThreadId;
+inline ThreadId currentThreadId() {
+    return std::this_thread::get_id();
+}
+inline void sleepMillis(unsigned millis) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+}
+#endif
@@ -0,0 +1,355 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "thumbnail_cache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include "stb_image.h"
+#include "stb_image_write.h"
+#include "texture_convert.hpp"
+
+bool renderThumbnail(const uint8_t *image, int imageWidth, int imageHeight,
+    SpriteRegion const& region, uint8_t *rgba)
+{
+    int width = region.spriteWidth, height = region.spriteHeight;
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    int step = std::max((std::max(width, height) + thumbnailSize - 1) /
+        thumbnailSize, 1);
+    int thumbWidth = width / step, thumbHeight = height / step;
+    int left = (thumbnailSize - thumbWidth) / 2;
+    int top = (thumbnailSize - thumbHeight) / 2;
+    // the part of the sprite that is on the image
+    int minX = std::max(region.xoff, region.xoff - region.x);
+    int minY = std::max(region.yoff, region.yoff - region.y);
+    int endX = std::min(region.xoff + region.width,
+        region.xoff - region.x + imageWidth);
+    int endY = std::min(region.yoff + region.height,
+        region.yoff - region.y + imageHeight);
+    for (int y=0; y<thumbHeight; ++y) {
+        for (int x=0; x<thumbWidth; ++x) {
+            // alpha-weighted average so that transparent pixels don't
+            // darken the edges
+            uint32_t r = 0, g = 0, b = 0, a = 0;
+            for (int sy=y*step; sy<(y+1)*step; ++sy) {
+                if (sy < minY || sy >= endY) {
+                    continue;
+                }
+                const uint8_t *line = &image[(size_t)(sy - region.yoff +
+                    region.y) * imageWidth * 4];
+                for (int sx=x*step; sx<(x+1)*step; ++sx) {
+                    if (sx < minX || sx >= endX) {
+                        continue;
+                    }
+                    const uint8_t *color = &line[(sx - region.xoff +
+                        region.x) * 4];
+                    uint32_t alpha = color[3];
+                    r += color[0] * alpha;
+                    g += color[1] * alpha;
+                    b += color[2] * alpha;
+                    a += alpha;
+                }
+            }
+            uint8_t *out = &rgba[((top + y) * thumbnailSize + left + x) * 4];
+            if (a > 0) {
+                out[0] = r / a;
+                out[1] = g / a;
+                out[2] = b / a;
+                out[3] = a / (step * step);
+            }
+        }
+    }
+    return true;
+}
+
+bool renderThumbnail(const uint8_t *file, size_t size,
+    SpriteRegion const& region, uint8_t *rgba)
+{
+    int width, height, comp;
+    uint8_t *image = stbi_load_from_memory(file, (int)size, &width, &height,
+        &comp, 4);
+    bool ok = image != NULL && renderThumbnail(image, width, height,
+        region, rgba);
+    stbi_image_free(image);
+    return ok;
+}
+
+bool writeThumbnail(const uint8_t *file, size_t size,
+    SpriteRegion const& region, std::string const& path)
+{
+    std::vector<uint8_t> rgba(thumbnailSize * thumbnailSize * 4, 0);
+    if (!renderThumbnail(file, size, region, &rgba[0])) {
+        return false;
+    }
+    return stbi_write_png(path.c_str(), thumbnailSize, thumbnailSize, 4,
+        &rgba[0], thumbnailSize * 4) != 0;
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    {
+        std::lock_guard<Mutex> lock { m_mutex };
+        m_stop = true;
+        m_wake.broadcast();
+    }
+    m_thread.join();
+    for (auto &pair : m_entries) {
+        GRRLIB_FreeTexture(pair.second.texture);
+    }
+}
+
+GRRLIB_texImg *ThumbnailCache::get(ThumbnailSource *source) {
+    auto iter = m_entries.find(source);
+    if (iter != m_entries.end()) {
+        iter->second.used = true;
+        return iter->second.texture;
+    }
+    if (std::find(m_pending.begin(), m_pending.end(), source) ==
+        m_pending.end())
+    {
+        m_pending.push_back(source);
+    }
+    return NULL;
+}
+
+bool ThumbnailCache::loadPending() {
+    if (uploadLoaded()) {
+        return true;
+    }
+    bool requested = requestPending();
+    return regenerate() || requested;
+}
+
+void ThumbnailCache::beginFrame() {
+    m_pending.clear();
+    for (auto &pair : m_entries) {
+        pair.second.used = false;
+    }
+}
+
+void ThumbnailCache::endFrame() {
+    for (auto iter = m_entries.begin(); iter != m_entries.end(); ) {
+        if (!iter->second.used) {
+            GRRLIB_FreeTexture(iter->second.texture);
+            iter = m_entries.erase(iter);
+        }
+        else {
+            ++iter;
+        }
+    }
+    if (m_openedAt != 0 && m_pending.empty()) {
+        m_readyMicros = (uint32_t)(m_clock() - m_openedAt);
+        m_openedAt = 0;
+    }
+}
+
+void ThumbnailCache::forget(ThumbnailSource *source) {
+    m_pending.erase(std::remove(m_pending.begin(), m_pending.end(), source),
+        m_pending.end());
+    m_missing.erase(std::remove(m_missing.begin(), m_missing.end(), source),
+        m_missing.end());
+    // a job that is still on its way is dropped when it arrives
+    m_requested.erase(source);
+    auto iter = m_entries.find(source);
+    if (iter != m_entries.end()) {
+        GRRLIB_FreeTexture(iter->second.texture);
+        m_entries.erase(iter);
+    }
+}
+
+size_t ThumbnailCache::nextRenderBytes() const {
+    auto source = nextMissing();
+    const uint8_t *file;
+    size_t size;
+    SpriteRegion region;
+    if (source == nullptr || !source->thumbnailImage(file, size, region)) {
+        return 0;
+    }
+    return size;
+}
+
+void *ThumbnailCache::threadMain(void *self) {
+    ((ThumbnailCache *)self)->run();
+    return NULL;
+}
+
+void ThumbnailCache::run() {
+    std::unique_lock<Mutex> lock { m_mutex };
+    while (!m_stop) {
+        if (!m_requests.empty()) {
+            auto job = std::move(m_requests.front());
+            m_requests.pop_front();
+            lock.unlock();
+            process(job);
+            lock.lock();
+            m_loaded.push_back(std::move(job));
+        }
+        else {
+            m_wake.wait(m_mutex);
+        }
+    }
+}
+
+void ThumbnailCache::process(Job &job) {
+    if (job.render) {
+        render(job);
+    }
+    else {
+        read(job);
+    }
+}
+
+void ThumbnailCache::read(Job &job) {
+    int width, height, comp;
+    uint8_t *rgba = stbi_load(job.path.c_str(), &width, &height, &comp, 4);
+    job.ok = rgba != NULL && width == thumbnailSize &&
+        height == thumbnailSize;
+    if (job.ok) {
+        job.pixels.resize(thumbnailSize * thumbnailSize * 4);
+        tileRGBA8(rgba, width, height, &job.pixels[0]);
+    }
+    stbi_image_free(rgba);
+}
+
+void ThumbnailCache::render(Job &job) {
+    std::vector<uint8_t> rgba(thumbnailSize * thumbnailSize * 4, 0);
+    job.ok = renderThumbnail(&job.image[0], job.image.size(), job.region,
+        &rgba[0]);
+    std::vector<uint8_t>().swap(job.image);
+    if (!job.ok) {
+        return;
+    }
+    if (stbi_write_png(job.path.c_str(), thumbnailSize, thumbnailSize, 4,
+        &rgba[0], thumbnailSize * 4) == 0)
+    {
+        m_log() << "W: couldn't write " << job.path << std::endl;
+    }
+    job.pixels.resize(rgba.size());
+    tileRGBA8(&rgba[0], thumbnailSize, thumbnailSize, &job.pixels[0]);
+}
+
+// Queues job for the thread, or runs it right away if the thread can't
+// be started
+void ThumbnailCache::submit(Job &&job) {
+    if (!m_thread.running() && !m_threadFailed &&
+        !m_thread.start(threadMain, this, Thread::lowPriority, 64 * 1024))
+    {
+        m_log() << "W: couldn't start the thumbnail thread" << std::endl;
+        m_threadFailed = true;
+    }
+    if (m_threadFailed) {
+        process(job);
+        m_loaded.push_back(std::move(job));
+        return;
+    }
+    std::lock_guard<Mutex> lock { m_mutex };
+    m_requests.push_back(std::move(job));
+    m_wake.broadcast();
+}
+
+static GRRLIB_texImg *upload(const uint8_t *tiles) {
+    auto texture = GRRLIB_CreateEmptyTexture(thumbnailSize, thumbnailSize);
+    if (texture != NULL) {
+        memcpy(texture->data, tiles, thumbnailSize * thumbnailSize * 4);
+        GRRLIB_FlushTex(texture);
+    }
+    return texture;
+}
+
+bool ThumbnailCache::uploadLoaded() {
+    Job job;
+    {
+        std::lock_guard<Mutex> lock { m_mutex };
+        if (m_loaded.empty()) {
+            return false;
+        }
+        job = std::move(m_loaded.back());
+        m_loaded.pop_back();
+    }
+    // dropped if the source was forgotten since
+    if (m_requested.erase(job.source) == 0 ||
+        job.path != job.source->thumbnailPath())
+    {
+        return true;
+    }
+    if (job.ok) {
+        m_entries[job.source] = { upload(&job.pixels[0]), true };
+    }
+    else if (job.render) {
+        // kept as a failed entry so that it isn't asked for again
+        m_entries[job.source] = { NULL, true };
+    }
+    else if (std::find(m_missing.begin(), m_missing.end(), job.source) ==
+        m_missing.end())
+    {
+        m_missing.push_back(job.source);
+    }
+    return true;
+}
+
+bool ThumbnailCache::requestPending() {
+    bool requested = false;
+    for (auto source : m_pending) {
+        if (m_requested.count(source) != 0 ||
+            std::find(m_missing.begin(), m_missing.end(), source) !=
+            m_missing.end())
+        {
+            continue;
+        }
+        m_requested.insert(source);
+        submit({ source, source->thumbnailPath(), false, {}, {}, {}, false });
+        requested = true;
+    }
+    return requested;
+}
+
+// the first missing thumbnail that is visible
+ThumbnailSource *ThumbnailCache::nextMissing() const {
+    for (auto source : m_missing) {
+        if (std::find(m_pending.begin(), m_pending.end(), source) !=
+            m_pending.end())
+        {
+            return source;
+        }
+    }
+    return nullptr;
+}
+
+// Hands a missing thumbnail that is visible to the thread to render. The
+// image file is copied as the source can be freed before the thread is
+// done, see forget().
+bool ThumbnailCache::regenerate() {
+    auto source = nextMissing();
+    if (source == nullptr) {
+        return false;
+    }
+    m_missing.erase(std::find(m_missing.begin(), m_missing.end(), source));
+    const uint8_t *file;
+    size_t size;
+    SpriteRegion region;
+    if (!source->thumbnailImage(file, size, region) || size == 0) {
+        m_entries[source] = { NULL, true };
+        return true;
+    }
+    Job job { source, source->thumbnailPath(), true,
+        std::vector<uint8_t>(file, file + size), region, {}, false };
+    m_requested.insert(source);
+    submit(std::move(job));
+    return true;
+}
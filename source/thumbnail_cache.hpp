@@ -0,0 +1,164 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <grrlib.h>
+#include "thread.hpp"
+
+// side of the square picker thumbnails, in pixels
+constexpr int thumbnailSize = 64;
+
+// The part of an image a sprite shows. The sprite's point px,py is the
+// image's pixel x + px - xoff, y + py - yoff inside of the rectangle
+// x, y, width, height, and transparent outside of it.
+struct SpriteRegion {
+    int spriteWidth, spriteHeight;
+    int x, y, width, height;
+    int xoff, yoff;
+};
+
+// Scales the sprite of region down to fit a thumbnailSize square,
+// averaging the covered pixels, into rgba, which has to be cleared.
+// image is the RGBA image of region. Returns false if the sprite is
+// empty.
+bool renderThumbnail(const uint8_t *image, int imageWidth, int imageHeight,
+    SpriteRegion const& region, uint8_t *rgba);
+
+// The same from the image file of region, which is decoded first. Safe
+// on any thread.
+bool renderThumbnail(const uint8_t *file, size_t size,
+    SpriteRegion const& region, uint8_t *rgba);
+
+// Renders the thumbnail of region and writes it to path as a PNG
+bool writeThumbnail(const uint8_t *file, size_t size,
+    SpriteRegion const& region, std::string const& path);
+
+// Something the picker shows a thumbnail of
+class ThumbnailSource {
+public:
+    virtual ~ThumbnailSource() {}
+    // where the thumbnail file is kept
+    virtual std::string thumbnailPath() const = 0;
+    // The image file of the sprite a missing thumbnail is rendered from
+    // and where the sprite is on it. Returns false if there is none.
+    virtual bool thumbnailImage(const uint8_t *&file, size_t &size,
+        SpriteRegion &region) const = 0;
+};
+
+// Thumbnails of the picker, only the ones on screen are kept in memory.
+// get() only asks for them. The files are read and decoded on a thread
+// of their own, and loadPending() turns them into textures in idle
+// time. A missing file gets rendered again by the thread from a copy of
+// the source's image file, and written back to its path. Everything but
+// the thread is main thread only.
+class ThumbnailCache {
+public:
+    // clock returns microseconds, log is where the thread reports files
+    // it couldn't write
+    ThumbnailCache(uint64_t (*clock)(), std::ostream &(*log)()):
+        m_clock(clock), m_log(log) {}
+    ThumbnailCache(const ThumbnailCache &) = delete;
+    ThumbnailCache &operator=(const ThumbnailCache &) = delete;
+    ~ThumbnailCache();
+    // Returns NULL until the thumbnail is loaded
+    GRRLIB_texImg *get(ThumbnailSource *source);
+    // One step of loading the thumbnails asked for this frame: uploads
+    // a thumbnail the thread has read or rendered, or hands new ones to
+    // the thread. Returns false if there is nothing to do.
+    bool loadPending();
+    void beginFrame();
+    // frees every thumbnail that was not drawn this frame
+    void endFrame();
+    void clear() {
+        beginFrame();
+        endFrame();
+    }
+    // for a source that is about to be freed
+    void forget(ThumbnailSource *source);
+    size_t residentCount() const {
+        return m_entries.size();
+    }
+    size_t residentBytes() const {
+        return m_entries.size() * thumbnailSize * thumbnailSize * 4;
+    }
+    // size of the image file the next step copies for the thread, 0 if
+    // there is no thumbnail to render
+    size_t nextRenderBytes() const;
+    // the picker was opened, see readyMicros()
+    void opened() {
+        m_openedAt = m_clock();
+    }
+    // time from the last opened() to the first frame that had every
+    // visible thumbnail
+    uint32_t readyMicros() const {
+        return m_readyMicros;
+    }
+private:
+    struct Entry {
+        GRRLIB_texImg *texture;
+        bool used;
+    };
+    // A file read by the thread, or a thumbnail for it to render from
+    // image and write, and the result tiled for GX
+    struct Job {
+        ThumbnailSource *source;
+        std::string path;
+        bool render;
+        std::vector<uint8_t> image;
+        SpriteRegion region;
+        std::vector<uint8_t> pixels;
+        bool ok;
+    };
+    static void *threadMain(void *self);
+    void run();
+    void process(Job &job);
+    static void read(Job &job);
+    void render(Job &job);
+    void submit(Job &&job);
+    bool uploadLoaded();
+    bool requestPending();
+    ThumbnailSource *nextMissing() const;
+    bool regenerate();
+    uint64_t (*m_clock)();
+    std::ostream &(*m_log)();
+    std::map<ThumbnailSource *, Entry> m_entries;
+    // asked for this frame and not resident
+    std::vector<ThumbnailSource *> m_pending;
+    // handed to the thread and not back yet
+    std::set<ThumbnailSource *> m_requested;
+    // no usable file, to be rendered again
+    std::vector<ThumbnailSource *> m_missing;
+    // shared with the thread
+    Mutex m_mutex;
+    CondVar m_wake;
+    std::deque<Job> m_requests;
+    std::vector<Job> m_loaded;
+    bool m_stop = false;
+    Thread m_thread;
+    bool m_threadFailed = false;
+    uint64_t m_openedAt = 0;
+    uint32_t m_readyMicros = 0;
+};
@@ -0,0 +1,131 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#ifdef SHIJIMA_WII_TRACE
+
+#include "trace.hpp"
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include "thread.hpp"
+
+#ifdef GEKKO
+#include <ogc/lwp_watchdog.h>
+#else
+#include <chrono>
+#endif
+
+namespace {
+
+// durations are in timer ticks, which would wrap after about 70 s
+// on the Wii in 32 bits
+struct Event {
+    const char *name;
+    uint64_t start;
+    uint64_t duration;
+    uint32_t thread;
+};
+
+// 32768 events, the oldest ones are overwritten
+constexpr uint32_t ringSize = 1 << 15;
+Event ring[ringSize];
+std::atomic<uint32_t> ringNext { 0 };
+
+constexpr uint32_t maxThreads = 8;
+ThreadId threads[maxThreads];
+std::atomic<uint32_t> threadCount { 0 };
+Mutex threadMutex;
+
+uint64_t now() {
+#ifdef GEKKO
+    return gettime();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint64_t toMicros(uint64_t ticks) {
+#ifdef GEKKO
+    return ticks_to_microsecs(ticks);
+#else
+    return ticks;
+#endif
+}
+
+// small index for the current thread, the same for its whole life
+uint32_t threadIndex() {
+    ThreadId self = currentThreadId();
+    uint32_t count = threadCount.load(std::memory_order_acquire);
+    for (uint32_t i=0; i<count; ++i) {
+        if (threads[i] == self) {
+            return i;
+        }
+    }
+    std::lock_guard<Mutex> lock { threadMutex };
+    count = threadCount.load(std::memory_order_relaxed);
+    if (count == maxThreads) {
+        return maxThreads;
+    }
+    threads[count] = self;
+    threadCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+}
+
+TraceZone::TraceZone(const char *name): m_name(name), m_start(now()) {}
+
+TraceZone::~TraceZone() {
+    uint64_t end = now();
+    uint32_t index = ringNext.fetch_add(1, std::memory_order_relaxed);
+    Event &event = ring[index % ringSize];
+    event.name = m_name;
+    event.start = m_start;
+    event.duration = end - m_start;
+    event.thread = threadIndex();
+}
+
+bool traceWriteJSON(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        return false;
+    }
+    uint32_t end = ringNext.load(std::memory_order_relaxed);
+    uint32_t begin = end > ringSize ? end - ringSize : 0;
+    uint64_t origin = UINT64_MAX;
+    for (uint32_t i=begin; i<end; ++i) {
+        if (ring[i % ringSize].start < origin) {
+            origin = ring[i % ringSize].start;
+        }
+    }
+    fputs("{\"traceEvents\":[\n", file);
+    for (uint32_t i=begin; i<end; ++i) {
+        Event &event = ring[i % ringSize];
+        // zone names are literals without quotes or backslashes
+        fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+            "\"tid\":%u,\"ts\":%llu,\"dur\":%llu}\n", i == begin ? "" : ",",
+            event.name, (unsigned)event.thread,
+            (unsigned long long)toMicros(event.start - origin),
+            (unsigned long long)toMicros(event.duration));
+    }
+    fputs("],\"displayTimeUnit\":\"ms\"}\n", file);
+    return fclose(file) == 0;
+}
+
+#endif
@@ -0,0 +1,52 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+#pragma once
+
+// Timed zones for seeing what a slow boot or a hitching frame is made
+// of. Built with SHIJIMA_WII_TRACE, every TRACE_ZONE() records its
+// start and duration into a preallocated ring that traceWriteJSON()
+// converts to the Chrome trace event format, which Perfetto and
+// chrome://tracing open. Without it TRACE_ZONE() expands to nothing.
+
+#ifdef SHIJIMA_WII_TRACE
+
+#include <cstdint>
+
+// name has to be a string literal, only the pointer is kept
+class TraceZone {
+public:
+    explicit TraceZone(const char *name);
+    ~TraceZone();
+    TraceZone(const TraceZone &) = delete;
+    TraceZone &operator=(const TraceZone &) = delete;
+private:
+    const char *m_name;
+    uint64_t m_start;
+};
+
+bool traceWriteJSON(const char *path);
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__) { name }
+
+#else
+
+#define TRACE_ZONE(name) do {} while (0)
+
+#endif
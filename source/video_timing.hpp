@@ -0,0 +1,54 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <cstdint>
+
+// Frame timing of the Wii's video modes. viTVMode keeps the video format
+// (VI_NTSC, VI_PAL, ...) in its upper bits and the scan mode in the
+// lower two, so a whole mode such as VI_TVMODE_PAL_INT never equals
+// VI_PAL.
+//
+// Mascots tick 50 times per second. Only PAL refreshes at 50 Hz, MPAL,
+// EURGB60 and the other formats at 59.94 Hz, so those skip the tick of
+// one frame in six. Before the format was read from the upper bits,
+// every mode compared unequal to VI_PAL and VI_MPAL: PAL skipped ticks
+// too and ran at 41.7 ticks per second, while the 60 Hz modes were
+// right by accident.
+
+// VI_PAL in gccore.h
+constexpr uint32_t videoFormatPal = 1;
+
+inline bool fiftyHertz(uint32_t viTVMode) {
+    return (viTVMode >> 2) == videoFormatPal;
+}
+
+inline uint32_t framePeriodMicros(uint32_t viTVMode) {
+    return fiftyHertz(viTVMode) ? 20000 : 16683;
+}
+
+// Whether the frame at phase, a counter of frames modulo 6, ticks
+inline bool ticksAtPhase(uint8_t phase) {
+    return phase != 5;
+}
+
+// The phase of the next frame. It is 0 at 50 Hz, so that every frame
+// ticks, also after a replay started at the phase of a 60 Hz recording.
+inline uint8_t nextTickPhase(uint32_t viTVMode, uint8_t phase) {
+    return fiftyHertz(viTVMode) ? 0 : (phase + 1) % 6;
+}
@@ -0,0 +1,275 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Checks the byte accounting of the allocation shim against what the
+// allocator reports: liveHeapBytes() and AllocScope must move by the
+// malloc_usable_size() of every block, slab blocks count with their
+// class size, scopes nest, and a scope only sees its own thread. Slab
+// blocks deleted on another thread go back to the pool.
+
+#include <atomic>
+#include <cstdint>
+#include <malloc.h>
+#include <vector>
+#include "alloc_counter.hpp"
+#include "slab_pool.hpp"
+#include "test.hpp"
+#include "thread.hpp"
+
+static std::atomic<bool> go { false };
+
+static void *threadAllocate(void *arg) {
+    auto blocks = (std::vector<char *> *)arg;
+    while (!go.load()) {
+        sleepMillis(0);
+    }
+    for (auto &block : *blocks) {
+        block = new char[1000];
+    }
+    return NULL;
+}
+
+static void *threadDelete(void *arg) {
+    delete[] (char *)arg;
+    return NULL;
+}
+
+struct ScopedThread {
+    long bytes;
+    long expected;
+};
+
+static void *threadScope(void *arg) {
+    auto result = (ScopedThread *)arg;
+    std::vector<char *> blocks;
+    blocks.reserve(100);
+    AllocScope scope;
+    result->expected = 0;
+    for (int i=0; i<100; ++i) {
+        blocks.push_back(new char[100 + i * 7]);
+        result->expected += malloc_usable_size(blocks.back());
+        sleepMillis(0);
+    }
+    result->bytes = scope.bytes();
+    for (auto block : blocks) {
+        delete[] block;
+    }
+    return NULL;
+}
+
+int main() {
+    std::vector<char *> blocks;
+    blocks.reserve(1000);
+
+    // live bytes follow malloc_usable_size()
+    size_t live = liveHeapBytes();
+    size_t usable = 0;
+    for (int i=0; i<1000; ++i) {
+        blocks.push_back(new char[1 + (i * 37) % 5000]);
+        usable += malloc_usable_size(blocks.back());
+    }
+    CHECK_EQ(liveHeapBytes() - live, usable);
+    for (auto block : blocks) {
+        delete[] block;
+    }
+    blocks.clear();
+    CHECK_EQ(liveHeapBytes(), live);
+
+    // over-aligned types are counted too
+    struct alignas(64) Aligned {
+        char bytes[64];
+    };
+    {
+        uint32_t count = allocationCount();
+        live = liveHeapBytes();
+        auto single = new Aligned;
+        auto array = new Aligned[5];
+        CHECK_EQ(allocationCount() - count, (uint32_t)2);
+        CHECK_EQ((uintptr_t)single % 64, (uintptr_t)0);
+        CHECK_EQ((uintptr_t)array % 64, (uintptr_t)0);
+        // no array cookie, the type is trivially destructible
+        CHECK_EQ(liveHeapBytes() - live, malloc_usable_size(single) +
+            malloc_usable_size(array));
+        delete single;
+        delete[] array;
+        CHECK_EQ(liveHeapBytes(), live);
+    }
+
+    // nested scopes: the outer one includes the inner one
+    {
+        AllocScope outer;
+        char *a = new char[300];
+        long aBytes = malloc_usable_size(a);
+        long innerBytes;
+        {
+            AllocScope inner;
+            char *b = new char[4000];
+            innerBytes = malloc_usable_size(b);
+            CHECK_EQ(inner.bytes(), innerBytes);
+            CHECK_EQ(outer.bytes(), aBytes);
+            blocks.push_back(b);
+        }
+        CHECK_EQ(outer.bytes(), aBytes + innerBytes);
+        delete[] a;
+        CHECK_EQ(outer.bytes(), innerBytes);
+        delete[] blocks.back();
+        blocks.clear();
+        CHECK_EQ(outer.bytes(), 0);
+    }
+
+    // another thread allocating while a scope is open is not counted
+    {
+        std::vector<char *> other(200);
+        Thread thread;
+        CHECK(thread.start(threadAllocate, &other, Thread::lowPriority));
+        AllocScope scope;
+        go.store(true);
+        char *mine = new char[64];
+        thread.join();
+        CHECK_EQ(scope.bytes(), (long)malloc_usable_size(mine));
+        delete[] mine;
+        for (auto block : other) {
+            delete[] block;
+        }
+    }
+
+    // threads with scopes of their own at the same time
+    {
+        ScopedThread results[4];
+        Thread threads[4];
+        for (int i=0; i<4; ++i) {
+            CHECK(threads[i].start(threadScope, &results[i],
+                Thread::lowPriority));
+        }
+        for (int i=0; i<4; ++i) {
+            threads[i].join();
+            CHECK_EQ(results[i].bytes, results[i].expected);
+        }
+    }
+
+    // slab blocks count with the size of their class
+    CHECK(initInstanceSlabs(SlabPool::pageSize * 8));
+    {
+        live = liveHeapBytes();
+        AllocScope scope;
+        SlabScope slabScope;
+        char *small = new char[20];
+        char *large = new char[SlabPool::maxBlockSize + 1];
+        CHECK(instanceSlabs().owns(small));
+        CHECK(!instanceSlabs().owns(large));
+        long expected = instanceSlabs().blockSize(small) +
+            malloc_usable_size(large);
+        CHECK_EQ(instanceSlabs().blockSize(small), (size_t)32);
+        CHECK_EQ(scope.bytes(), expected);
+        CHECK_EQ((long)(liveHeapBytes() - live), expected);
+        delete[] small;
+        delete[] large;
+        CHECK_EQ(liveHeapBytes(), live);
+        CHECK_EQ(instanceSlabs().bytesInUse(), (size_t)0);
+    }
+
+    // disabled scopes, scopes of other threads and over-aligned types
+    // take the heap
+    {
+        SlabScope slabScope;
+        auto aligned = new Aligned;
+        CHECK(!instanceSlabs().owns(aligned));
+        delete aligned;
+    }
+    {
+        SlabScope slabScope { false };
+        char *block = new char[20];
+        CHECK(!instanceSlabs().owns(block));
+        delete[] block;
+    }
+    // nested scopes put back the state they found
+    {
+        SlabScope outer;
+        char *before = new char[20];
+        char *paused, *inner;
+        {
+            SlabScope disabled { false };
+            paused = new char[20];
+            {
+                SlabScope enabled;
+                inner = new char[20];
+            }
+            char *stillPaused = new char[20];
+            CHECK(!instanceSlabs().owns(stillPaused));
+            delete[] stillPaused;
+        }
+        char *after = new char[20];
+        CHECK(instanceSlabs().owns(before));
+        CHECK(!instanceSlabs().owns(paused));
+        CHECK(instanceSlabs().owns(inner));
+        CHECK(instanceSlabs().owns(after));
+        delete[] before;
+        delete[] paused;
+        delete[] inner;
+        delete[] after;
+    }
+    {
+        SlabScope slabScope;
+        {
+            SlabScope nested;
+        }
+        char *block = new char[20];
+        CHECK(instanceSlabs().owns(block));
+        delete[] block;
+    }
+    {
+        char *block = new char[20];
+        CHECK(!instanceSlabs().owns(block));
+        delete[] block;
+    }
+    {
+        std::vector<char *> other(10);
+        Thread thread;
+        go.store(true);
+        SlabScope slabScope;
+        CHECK(thread.start(threadAllocate, &other, Thread::lowPriority));
+        thread.join();
+        for (auto block : other) {
+            CHECK(!instanceSlabs().owns(block));
+            delete[] block;
+        }
+    }
+
+    // a slab block deleted on another thread goes back to the pool on
+    // the next allocation of the thread that owns it
+    {
+        live = liveHeapBytes();
+        char *block;
+        {
+            SlabScope slabScope;
+            block = new char[20];
+        }
+        Thread thread;
+        CHECK(thread.start(threadDelete, block, Thread::lowPriority));
+        thread.join();
+        CHECK_EQ(liveHeapBytes(), live);
+        CHECK_EQ(instanceSlabs().bytesInUse(), (size_t)32);
+        SlabScope slabScope;
+        char *again = new char[20];
+        CHECK(again == block);
+        CHECK_EQ(instanceSlabs().bytesInUse(), (size_t)32);
+        delete[] again;
+        CHECK_EQ(instanceSlabs().bytesInUse(), (size_t)0);
+    }
+    return testResult();
+}
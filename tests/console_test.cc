@@ -0,0 +1,158 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Checks the console line ring and measures what logging costs: the
+// time and allocations per line written through cout's ConsoleWriter,
+// and the per-frame check of an idle console.
+
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include "alloc_counter.hpp"
+#include "console.hpp"
+#include "test.hpp"
+#include "thread.hpp"
+
+struct CharWriter {
+    ConsoleBuffer *console;
+    int id;
+};
+
+// writes every character on its own, which must still reach the
+// console as whole lines
+static void *writeChars(void *arg) {
+    auto job = (CharWriter *)arg;
+    ConsoleWriter writer { *job->console };
+    std::ostream out { &writer };
+    char line[64];
+    for (int i=0; i<200; ++i) {
+        int size = std::snprintf(line, sizeof(line),
+            "thread %d line %03d %s", job->id, i,
+            std::string(20 + job->id * 5, 'a' + job->id).c_str());
+        for (int c=0; c<size; ++c) {
+            out.put(line[c]);
+        }
+        out.put('\n');
+    }
+    out.flush();
+    return NULL;
+}
+
+static std::string lineText(ConsoleBuffer &console, int i) {
+    std::lock_guard<ConsoleBuffer> lock { console };
+    return console.line(i);
+}
+
+int main() {
+    ConsoleBuffer console;
+    ConsoleWriter writer { console };
+    std::ostream out { &writer };
+
+    // the oldest lines are dropped once the ring is full
+    console.resize(3);
+    CHECK(console.takeDirty());
+    CHECK(!console.takeDirty());
+    for (int i=0; i<5; ++i) {
+        out << "line " << i << std::endl;
+    }
+    CHECK(console.takeDirty());
+    CHECK_EQ(console.lineCount(), 3);
+    CHECK(lineText(console, 0) == "line 2");
+    CHECK(lineText(console, 2) == "line 4");
+
+    // long lines wrap at 80 columns, even past the writer's buffer
+    console.clear();
+    out << std::string(200, 'x') << '\n' << std::flush;
+    CHECK_EQ(console.lineCount(), 3);
+    CHECK_EQ(lineText(console, 0).size(), (size_t)80);
+    CHECK_EQ(lineText(console, 2).size(), (size_t)40);
+
+    // a line is not committed before its newline or a flush
+    console.clear();
+    console.takeDirty();
+    out << "partial";
+    CHECK(!console.takeDirty());
+    CHECK_EQ(console.lineCount(), 0);
+    out << " line\n" << std::flush;
+    CHECK(console.takeDirty());
+    CHECK(lineText(console, 0) == "partial line");
+
+    // lines of threads that write a character at a time don't mix
+    console.resize(1000);
+    CharWriter jobs[4];
+    Thread threads[4];
+    for (int i=0; i<4; ++i) {
+        jobs[i] = { &console, i };
+        CHECK(threads[i].start(writeChars, &jobs[i], Thread::lowPriority));
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    CHECK_EQ(console.lineCount(), 800);
+    int next[4] = {};
+    int broken = 0;
+    for (int i=0; i<console.lineCount(); ++i) {
+        std::string text = lineText(console, i);
+        int id, number;
+        if (std::sscanf(text.c_str(), "thread %d line %d", &id, &number) != 2 ||
+            id < 0 || id > 3 || number != next[id] ||
+            text != "thread " + std::to_string(id) + " line " +
+                text.substr(text.find("line ") + 5, 3) + " " +
+                std::string(20 + id * 5, 'a' + id))
+        {
+            ++broken;
+            continue;
+        }
+        ++next[id];
+    }
+    CHECK_EQ(broken, 0);
+
+    // logging throughput, the loader prints a few lines per mascot
+    console.resize(28);
+    const int lines = 200000;
+    for (int i=0; i<100; ++i) {
+        out << "Loaded mascot " << i << " (" << i * 3 << " sprites)\n";
+    }
+    uint32_t allocations = allocationCount();
+    double start = testMicros();
+    for (int i=0; i<lines; ++i) {
+        out << "Loaded mascot " << i << " (" << i * 3 << " sprites)\n";
+    }
+    out.flush();
+    double micros = testMicros() - start;
+    allocations = allocationCount() - allocations;
+    std::printf("logging: %.0f ns/line, %u allocations in %d lines\n",
+        micros * 1000 / lines, allocations, lines);
+    CHECK_EQ(allocations, 0u);
+
+    // an idle frame only checks the dirty flag
+    console.takeDirty();
+    const int frames = 1000000;
+    int redraws = 0;
+    start = testMicros();
+    for (int i=0; i<frames; ++i) {
+        std::lock_guard<ConsoleBuffer> lock { console };
+        redraws += console.takeDirty();
+    }
+    micros = testMicros() - start;
+    std::printf("idle frame: %.1f ns, %d redraws\n", micros * 1000 / frames,
+        redraws);
+    CHECK_EQ(redraws, 0);
+    return testResult();
+}
@@ -0,0 +1,96 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Checks the bytes of the sprite display lists against the command
+// stream GX_Begin(GX_QUADS, GX_VTXFMT0, 4) with GX_Position3f32(),
+// GX_Color1u32() and GX_TexCoord2f32() writes to the FIFO.
+
+#include <cstring>
+#include <vector>
+#include "display_list.hpp"
+#include "test.hpp"
+
+static void expectU32(std::vector<uint8_t> &bytes, uint32_t value) {
+    bytes.push_back(value >> 24);
+    bytes.push_back((value >> 16) & 0xFF);
+    bytes.push_back((value >> 8) & 0xFF);
+    bytes.push_back(value & 0xFF);
+}
+
+static void expectF32(std::vector<uint8_t> &bytes, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    expectU32(bytes, bits);
+}
+
+static void expectVertex(std::vector<uint8_t> &bytes, float x, float y,
+    uint32_t color, float s, float t)
+{
+    expectF32(bytes, x);
+    expectF32(bytes, y);
+    expectF32(bytes, 0);
+    expectU32(bytes, color);
+    expectF32(bytes, s);
+    expectF32(bytes, t);
+}
+
+static void checkQuad(SpriteQuad const& quad, bool flipX, uint32_t color) {
+    std::vector<uint8_t> expected { 0x80, 0x00, 0x04 };
+    float left = flipX ? quad.s2 : quad.s1;
+    float right = flipX ? quad.s1 : quad.s2;
+    expectVertex(expected, 0, 0, color, left, quad.t1);
+    expectVertex(expected, quad.width, 0, color, right, quad.t1);
+    expectVertex(expected, quad.width, quad.height, color, right, quad.t2);
+    expectVertex(expected, 0, quad.height, color, left, quad.t2);
+    CHECK_EQ(expected.size(), (size_t)99);
+    expected.resize(spriteQuadListSize, 0);
+
+    alignas(32) uint8_t buffer[spriteQuadListSize + 32];
+    std::memset(buffer, 0xAA, sizeof(buffer));
+    size_t size = writeSpriteQuad(buffer, sizeof(buffer), quad, flipX, color);
+    CHECK_EQ(size, spriteQuadListSize);
+    CHECK(std::memcmp(buffer, expected.data(), spriteQuadListSize) == 0);
+    // nothing is written past the padded list
+    CHECK_EQ(buffer[spriteQuadListSize], 0xAA);
+}
+
+int main() {
+    checkQuad({ 128, 96, 0.25f, 0.5f, 0.5f, 0.75f }, false, 0xFFFFFFFF);
+    checkQuad({ 128, 96, 0.25f, 0.5f, 0.5f, 0.75f }, true, 0xFFFFFFFF);
+    checkQuad({ 1, 1, 0, 0, 1, 1 }, true, 0x12345678);
+
+    // too small: nothing usable comes back and the buffer is not
+    // overrun
+    alignas(32) uint8_t small[spriteQuadListSize];
+    std::memset(small, 0xAA, sizeof(small));
+    SpriteQuad quad { 64, 64, 0, 0, 1, 1 };
+    CHECK_EQ(writeSpriteQuad(small, 96, quad, false, 0xFFFFFFFF), (size_t)0);
+    CHECK_EQ(small[96], 0xAA);
+
+    // lists are padded with GX_NOP to whole 32-byte blocks
+    uint8_t buffer[64];
+    DisplayListWriter writer { buffer, sizeof(buffer) };
+    writer.begin(DisplayListWriter::quads, DisplayListWriter::vtxfmt0, 1);
+    writer.position(1, 2, 3);
+    CHECK_EQ(writer.size(), (size_t)15);
+    CHECK_EQ(writer.finish(), (size_t)32);
+    for (size_t i=15; i<32; ++i) {
+        CHECK_EQ(buffer[i], 0);
+    }
+    return testResult();
+}
@@ -0,0 +1,211 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Reads sprite sheets through FilePipeline from storage as slow as an
+// SD card, with a decoding step after every file. The test is linked
+// with -Wl,--wrap=fopen,--wrap=fread,--wrap=pthread_create, so the
+// pipeline's file access and thread creation come here. It checks that
+// the reader opens the next file while the current one is still being
+// decoded, and never more files than it has buffers for, that files
+// come out complete and in order, and that a file that can't be read
+// doesn't stop the ones after it. It also checks that the pipeline
+// still delivers every file when its thread can't be created, and
+// prints how long reading, decoding and both pipelined take.
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "file_pipeline.hpp"
+#include "test.hpp"
+
+// seek and per block transfer time of an SD card through libfat. The
+// card works while the CPU waits, so these sleep.
+static double openMicros = 0, blockMicros = 0;
+// sheets opened since the last resetOpened()
+static std::atomic<int> openedFiles { 0 };
+static bool failThreads = false;
+
+static void spin(double micros) {
+    double start = testMicros();
+    while (testMicros() - start < micros) {}
+}
+
+static void sleepMicros(double micros) {
+    std::this_thread::sleep_for(std::chrono::duration<double,
+        std::micro>(micros));
+}
+
+extern "C" FILE *__real_fopen(const char *path, const char *mode);
+extern "C" FILE *__wrap_fopen(const char *path, const char *mode) {
+    if (std::strstr(path, "sheet") != NULL && mode[0] == 'r') {
+        ++openedFiles;
+    }
+    sleepMicros(openMicros);
+    return __real_fopen(path, mode);
+}
+
+extern "C" size_t __real_fread(void *ptr, size_t size, size_t count,
+    FILE *file);
+extern "C" size_t __wrap_fread(void *ptr, size_t size, size_t count,
+    FILE *file)
+{
+    sleepMicros(blockMicros * size * count / FilePipeline::blockSize);
+    return __real_fread(ptr, size, count, file);
+}
+
+extern "C" int __real_pthread_create(pthread_t *thread,
+    const pthread_attr_t *attr, void *(*entry)(void *), void *arg);
+extern "C" int __wrap_pthread_create(pthread_t *thread,
+    const pthread_attr_t *attr, void *(*entry)(void *), void *arg)
+{
+    if (failThreads) {
+        return EAGAIN;
+    }
+    return __real_pthread_create(thread, attr, entry, arg);
+}
+
+namespace fs = std::filesystem;
+
+static const int fileCount = 24;
+static const int slotCount = 3;
+
+static size_t fileSize(int i) {
+    return 200 * 1024 + i * 7919;
+}
+
+static uint8_t fileByte(int i, size_t offset) {
+    return (uint8_t)(offset * 31 + i);
+}
+
+static bool checkFile(FilePipeline::File const& file, int i) {
+    if (!file.ok || file.size != fileSize(i)) {
+        return false;
+    }
+    for (size_t offset=0; offset<file.size; offset+=4093) {
+        if (file.data[offset] != fileByte(i, offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Waits up to a few seconds for the reader to open count files
+static bool waitOpened(int count) {
+    double start = testMicros();
+    while (openedFiles < count) {
+        if (testMicros() - start > 5000000) {
+            return false;
+        }
+        sleepMicros(100);
+    }
+    return true;
+}
+
+// Reads paths and spends decodeMicros on every file, returns the time
+// it took. Unless the pipeline is synchronous, the reader has to open
+// the next file while the current one is held, without running more
+// than the ring of buffers ahead.
+static double readAll(FilePipeline &pipeline,
+    std::vector<fs::path> const& paths, double decodeMicros, int missing)
+{
+    double start = testMicros();
+    openedFiles = 0;
+    bool synchronous = !pipeline.start(paths);
+    FilePipeline::File file;
+    int i = 0;
+    int count = paths.size();
+    while (pipeline.next(file)) {
+        if (i == missing) {
+            CHECK(!file.ok);
+            CHECK(file.data == NULL);
+        }
+        else {
+            CHECK(checkFile(file, i));
+        }
+        if (synchronous) {
+            CHECK_EQ((int)openedFiles, i + 1);
+        }
+        else {
+            CHECK(i + 1 == count || waitOpened(i + 2));
+            CHECK(openedFiles <= i + slotCount);
+        }
+        spin(decodeMicros);
+        ++i;
+    }
+    CHECK_EQ(i, count);
+    return testMicros() - start;
+}
+
+int main() {
+    fs::path dir = fs::absolute("file_pipeline_test.files");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::vector<fs::path> paths;
+    for (int i=0; i<fileCount; ++i) {
+        paths.push_back(dir / ("sheet" + std::to_string(i) + ".png"));
+        std::vector<uint8_t> data(fileSize(i));
+        for (size_t offset=0; offset<data.size(); ++offset) {
+            data[offset] = fileByte(i, offset);
+        }
+        FILE *file = std::fopen(paths.back().c_str(), "wb");
+        std::fwrite(data.data(), 1, data.size(), file);
+        std::fclose(file);
+    }
+
+    // without a reader thread, every file is read by next()
+    {
+        failThreads = true;
+        FilePipeline pipeline { slotCount };
+        CHECK(!pipeline.start(paths));
+        readAll(pipeline, paths, 0, -1);
+        failThreads = false;
+    }
+
+    openMicros = 3000;
+    blockMicros = 6000;
+    FilePipeline pipeline { slotCount };
+    double readMicros = readAll(pipeline, paths, 0, -1);
+    double decodeMicros = 8000;
+    double overlappedMicros = readAll(pipeline, paths, decodeMicros, -1);
+    // timing depends on the machine, so it is only reported
+    std::printf("%d files: reading %.0f ms, decoding %.0f ms, "
+        "pipelined %.0f ms\n", fileCount, readMicros / 1000,
+        fileCount * decodeMicros / 1000, overlappedMicros / 1000);
+
+    // a missing file in the middle, and a list given up half way
+    fs::remove(paths[5]);
+    readAll(pipeline, paths, 0, 5);
+    pipeline.start(paths);
+    FilePipeline::File file;
+    CHECK(pipeline.next(file));
+    CHECK(checkFile(file, 0));
+    std::vector<fs::path> rest { paths.begin() + 6, paths.end() };
+    pipeline.start(rest);
+    CHECK(pipeline.next(file));
+    CHECK(checkFile(file, 6));
+
+    fs::remove_all(dir);
+    return testResult();
+}
@@ -0,0 +1,109 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Runs the per-frame work of the runner that does not need the GPU
+// (sprite lookups, hit test grid, console output and display lists)
+// for many frames and checks that once it has warmed up, a frame does
+// not allocate at all.
+
+#include <map>
+#include <ostream>
+#include <string>
+#include "alloc_counter.hpp"
+#include "console.hpp"
+#include "display_list.hpp"
+#include "spatial_grid.hpp"
+#include "sprite_name.hpp"
+#include "test.hpp"
+
+static const char *frameNames[] = {
+    "img/shime1.png", "img/Shime2.png", "shime3.PNG", "/img/shime4.png",
+    "shime5", "img/sub/Shime6.png"
+};
+
+struct Scene {
+    std::map<std::string, int, std::less<>> sprites;
+    SpatialGrid<int> grid;
+    ConsoleBuffer console;
+    ConsoleWriter writer { console };
+    std::ostream log { &writer };
+    alignas(32) uint8_t lists[64][spriteQuadListSize];
+    int found = 0;
+};
+
+static void runFrame(Scene &scene, int frame) {
+    scene.grid.clear();
+    for (int i=0; i<64; ++i) {
+        auto name = frameNames[(frame + i) % 6];
+        char buffer[256];
+        auto key = spriteKey(name, buffer, sizeof(buffer));
+        auto iter = scene.sprites.find(key);
+        if (iter != scene.sprites.end()) {
+            ++scene.found;
+        }
+        double x = (frame * 3 + i * 37) % 640;
+        double y = (i * 53) % 480;
+        scene.grid.insert(i, x, y, 128, 128);
+        SpriteQuad quad { 128, 128, 0, 0, 1, 1 };
+        writeSpriteQuad(scene.lists[i], sizeof(scene.lists[i]), quad,
+            (i & 1) != 0, 0xFFFFFFFF);
+    }
+    int hit = -1;
+    scene.grid.findAt(320, 240, [&](int item) {
+        hit = item;
+        return true;
+    });
+    scene.log << "frame " << frame << " hit " << hit << '\n';
+}
+
+int main() {
+    Scene scene;
+    scene.console.resize(20);
+    for (int i=1; i<=6; ++i) {
+        scene.sprites["shime" + std::to_string(i)] = i;
+    }
+    scene.grid.reset(640, 480, 64);
+
+    // mascots walk across the screen in 640 frames, which grows every
+    // grid cell to the most items it will ever hold
+    for (int frame=0; frame<640; ++frame) {
+        runFrame(scene, frame);
+    }
+    uint32_t before = allocationCount();
+    for (int frame=640; frame<1640; ++frame) {
+        runFrame(scene, frame);
+    }
+    uint32_t allocations = allocationCount() - before;
+    std::printf("allocations in 1000 frames: %u\n", allocations);
+    CHECK_EQ(allocations, 0u);
+    CHECK_EQ(scene.found, 1640 * 64);
+    CHECK(scene.console.lineCount() == 20);
+
+    // the counter itself has to see allocations for the check to mean
+    // anything
+    before = allocationCount();
+    std::string path { "img/a/path/long/enough/to/not/fit/inline.png" };
+    CHECK(allocationCount() != before);
+
+    char small[4];
+    CHECK(spriteKey("img/Shime1.png", small, sizeof(small)).data() == NULL);
+    char buffer[16];
+    CHECK(spriteKey("img/Shime1.png", buffer, sizeof(buffer)) == "shime1");
+    CHECK(spriteKey(".hidden", buffer, sizeof(buffer)) == ".hidden");
+    return testResult();
+}
@@ -0,0 +1,73 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// The part of libogc's gccore.h that the drawing code uses, for host
+// builds. GX calls are implemented by soft_grrlib.cc on a SoftRaster.
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef float f32;
+typedef f32 Mtx[3][4];
+
+typedef struct {
+    void *data;
+    u16 width, height;
+} GXTexObj;
+
+#define GX_FALSE 0
+#define GX_TRUE 1
+#define GX_TF_RGBA8 0x6
+#define GX_CLAMP 0
+#define GX_NEAR 0
+#define GX_ANISO_1 0
+#define GX_TEXMAP0 0
+#define GX_TEVSTAGE0 0
+#define GX_MODULATE 0
+#define GX_PASSCLR 4
+#define GX_VA_TEX0 13
+#define GX_DIRECT 1
+#define GX_NONE 0
+#define GX_QUADS 0x80
+#define GX_VTXFMT0 0
+#define GX_PNMTX0 0
+
+void GX_InitTexObj(GXTexObj *obj, void *img, u16 width, u16 height, u8 fmt,
+    u8 wrapS, u8 wrapT, u8 mipmap);
+void GX_InitTexObjLOD(GXTexObj *obj, u8 minFilter, u8 magFilter, f32 minLod,
+    f32 maxLod, f32 lodBias, u8 biasClamp, u8 edgeLod, u8 maxAniso);
+void GX_LoadTexObj(GXTexObj *obj, u8 map);
+void GX_SetTevOp(u8 stage, u8 mode);
+void GX_SetVtxDesc(u8 attr, u8 type);
+void GX_LoadPosMtxImm(Mtx mtx, u32 index);
+void GX_Begin(u8 primitive, u8 vtxfmt, u16 count);
+void GX_Position3f32(f32 x, f32 y, f32 z);
+void GX_Color1u32(u32 color);
+void GX_TexCoord2f32(f32 s, f32 t);
+void GX_End();
+void GX_CallDispList(const void *list, u32 size);
+void guMtxIdentity(Mtx mtx);
+void guMtxTrans(Mtx mtx, f32 x, f32 y, f32 z);
+void guMtxConcat(Mtx a, Mtx b, Mtx ab);
+void DCFlushRange(void *start, u32 size);
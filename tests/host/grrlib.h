@@ -0,0 +1,59 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <gccore.h>
+
+// The part of GRRLIB that the drawing code uses, for host builds.
+// soft_grrlib.cc draws with SoftRaster, see soft_grrlib.hpp.
+
+typedef struct GRRLIB_texImg {
+    u32 w, h;
+    int handlex, handley;
+    int offsetx, offsety;
+    bool tiledtex;
+    u32 tilew, tileh;
+    u32 nbtilew, nbtileh;
+    u32 tilestart;
+    f32 ofnormaltexx, ofnormaltexy;
+    void *data;
+} GRRLIB_texImg;
+
+typedef struct {
+    bool antialias;
+} GRRLIB_drawSettings;
+
+extern Mtx GXmodelView2D;
+extern GRRLIB_drawSettings GRRLIB_Settings;
+
+GRRLIB_texImg *GRRLIB_CreateEmptyTexture(u32 width, u32 height);
+void GRRLIB_FreeTexture(GRRLIB_texImg *tex);
+void GRRLIB_FlushTex(GRRLIB_texImg *tex);
+void GRRLIB_InitTileSet(GRRLIB_texImg *tex, u32 tilew, u32 tileh,
+    u32 tilestart);
+void GRRLIB_DrawImg(f32 xpos, f32 ypos, const GRRLIB_texImg *tex,
+    f32 degrees, f32 scaleX, f32 scaleY, u32 color);
+void GRRLIB_DrawPart(f32 xpos, f32 ypos, f32 partx, f32 party, f32 partw,
+    f32 parth, const GRRLIB_texImg *tex, f32 degrees, f32 scaleX,
+    f32 scaleY, u32 color);
+void GRRLIB_Rectangle(f32 x, f32 y, f32 width, f32 height, u32 color,
+    bool filled);
+void GRRLIB_Printf(f32 xpos, f32 ypos, const GRRLIB_texImg *tex, u32 color,
+    f32 zoom, const char *text, ...) __attribute__((format(printf, 6, 7)));
+void GRRLIB_CompoStart();
+void GRRLIB_CompoEnd(int posx, int posy, GRRLIB_texImg *tex);
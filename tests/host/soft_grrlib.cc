@@ -0,0 +1,366 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#include "soft_grrlib.hpp"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "texture_convert.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+Mtx GXmodelView2D = {
+    { 1, 0, 0, 0 },
+    { 0, 1, 0, 0 },
+    { 0, 0, 1, 0 }
+};
+GRRLIB_drawSettings GRRLIB_Settings = { false };
+
+namespace {
+
+struct Vertex {
+    f32 x, y;
+    u32 color;
+    f32 s, t;
+};
+
+SoftRaster *target = NULL;
+SoftStats stats = {};
+SoftRaster::Texture boundTexture = {};
+bool textured = false;
+bool modulated = false;
+Mtx position = {
+    { 1, 0, 0, 0 },
+    { 0, 1, 0, 0 },
+    { 0, 0, 1, 0 }
+};
+std::vector<Vertex> vertices;
+
+// FIFO bytes of the GX calls: a command byte or register write and its
+// payload
+const unsigned positionBytes = 12;
+const unsigned colorBytes = 4;
+const unsigned texCoordBytes = 8;
+const unsigned beginBytes = 3;
+const unsigned matrixBytes = 5 + 48;
+const unsigned loadTextureBytes = 7 * 5;
+const unsigned tevOpBytes = 3 * 5;
+const unsigned vtxDescBytes = 6;
+const unsigned callListBytes = 9;
+const unsigned efbCopyBytes = 6 * 5;
+// GRRLIB_DrawImg(), GRRLIB_DrawPart() and each character of
+// GRRLIB_Printf() load the texture and a matrix, set up the TEV and
+// the vertex format, draw a quad and restore all but the texture
+const unsigned grrlibQuadBytes = loadTextureBytes + 2 * (matrixBytes +
+    tevOpBytes + vtxDescBytes) + beginBytes + 4 * (positionBytes +
+    colorBytes + texCoordBytes);
+// GRRLIB_Rectangle() draws untextured
+unsigned grrlibShapeBytes(unsigned count) {
+    return 2 * (tevOpBytes + vtxDescBytes) + beginBytes + count *
+        (positionBytes + colorBytes);
+}
+
+SoftRaster::Texture texture(const GRRLIB_texImg *tex) {
+    return { (const uint8_t *)tex->data, (int)tex->w, (int)tex->h };
+}
+
+// GX_QUADS only, the runner draws nothing else with GX directly
+void drawVertices() {
+    stats.vertices += vertices.size();
+    ++stats.drawCalls;
+    if (target == NULL) {
+        vertices.clear();
+        return;
+    }
+    auto tex = (textured && modulated) ? &boundTexture : NULL;
+    for (size_t i=0; i+3<vertices.size(); i+=4) {
+        auto &a = vertices[i], &c = vertices[i + 2];
+        target->quad(a.x, a.y, c.x, c.y, a.s, a.t, c.s, c.t, tex, a.color);
+    }
+    vertices.clear();
+}
+
+void addVertex(f32 x, f32 y, f32 z) {
+    Vertex vertex {};
+    vertex.x = position[0][0] * x + position[0][1] * y +
+        position[0][2] * z + position[0][3];
+    vertex.y = position[1][0] * x + position[1][1] * y +
+        position[1][2] * z + position[1][3];
+    vertices.push_back(vertex);
+}
+
+uint32_t readU32(const u8 *bytes) {
+    return ((uint32_t)bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) |
+        bytes[3];
+}
+
+f32 readF32(const u8 *bytes) {
+    uint32_t bits = readU32(bytes);
+    f32 value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+}
+
+void softBind(SoftRaster *raster) {
+    target = raster;
+}
+
+SoftStats const& softStats() {
+    return stats;
+}
+
+void softResetStats() {
+    stats = {};
+}
+
+GRRLIB_texImg *softLoadTexture(const u8 *png, size_t size) {
+    int width, height, comp;
+    u8 *rgba = stbi_load_from_memory(png, size, &width, &height, &comp, 4);
+    if (rgba == NULL) {
+        return NULL;
+    }
+    auto tex = GRRLIB_CreateEmptyTexture(width, height);
+    tileRGBA8(rgba, width, height, (u8 *)tex->data);
+    stbi_image_free(rgba);
+    return tex;
+}
+
+GRRLIB_texImg *GRRLIB_CreateEmptyTexture(u32 width, u32 height) {
+    auto tex = (GRRLIB_texImg *)std::calloc(1, sizeof(GRRLIB_texImg));
+    tex->w = width;
+    tex->h = height;
+    tex->data = std::calloc(width * height, 4);
+    return tex;
+}
+
+void GRRLIB_FreeTexture(GRRLIB_texImg *tex) {
+    if (tex != NULL) {
+        std::free(tex->data);
+        std::free(tex);
+    }
+}
+
+void GRRLIB_FlushTex(GRRLIB_texImg *) {}
+
+void GRRLIB_InitTileSet(GRRLIB_texImg *tex, u32 tilew, u32 tileh,
+    u32 tilestart)
+{
+    tex->tiledtex = true;
+    tex->tilew = tilew;
+    tex->tileh = tileh;
+    tex->nbtilew = tex->w / tilew;
+    tex->nbtileh = tex->h / tileh;
+    tex->tilestart = tilestart;
+}
+
+void GRRLIB_DrawImg(f32 xpos, f32 ypos, const GRRLIB_texImg *tex, f32,
+    f32 scaleX, f32 scaleY, u32 color)
+{
+    ++stats.drawCalls;
+    stats.vertices += 4;
+    stats.fifoBytes += grrlibQuadBytes;
+    if (target != NULL && tex != NULL) {
+        target->drawImg(xpos, ypos, texture(tex), scaleX, scaleY, color);
+    }
+}
+
+void GRRLIB_DrawPart(f32 xpos, f32 ypos, f32 partx, f32 party, f32 partw,
+    f32 parth, const GRRLIB_texImg *tex, f32, f32 scaleX, f32 scaleY,
+    u32 color)
+{
+    ++stats.drawCalls;
+    stats.vertices += 4;
+    stats.fifoBytes += grrlibQuadBytes;
+    if (target != NULL && tex != NULL) {
+        target->drawPart(xpos, ypos, partx, party, partw, parth,
+            texture(tex), scaleX, scaleY, color);
+    }
+}
+
+void GRRLIB_Rectangle(f32 x, f32 y, f32 width, f32 height, u32 color,
+    bool filled)
+{
+    ++stats.drawCalls;
+    stats.vertices += filled ? 4 : 5;
+    stats.fifoBytes += grrlibShapeBytes(filled ? 4 : 5);
+    if (target != NULL) {
+        target->rectangle(x, y, width, height, color, filled);
+    }
+}
+
+void GRRLIB_Printf(f32 xpos, f32 ypos, const GRRLIB_texImg *tex, u32 color,
+    f32, const char *text, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, text);
+    int len = vsnprintf(buf, sizeof(buf), text, args);
+    va_end(args);
+    if (len < 0) {
+        return;
+    }
+    // one GRRLIB_DrawPart() per character
+    unsigned count = std::min(len, (int)sizeof(buf) - 1);
+    stats.drawCalls += count;
+    stats.vertices += 4 * count;
+    stats.fifoBytes += grrlibQuadBytes * count;
+    if (target != NULL && tex != NULL) {
+        SoftRaster::TileSet font { texture(tex), (int)tex->tilew,
+            (int)tex->tileh, (int)tex->tilestart };
+        target->printf(xpos, ypos, font, color, "%s", buf);
+    }
+}
+
+void GRRLIB_CompoStart() {}
+
+// Copies the screen area at posx,posy the size of tex into tex and
+// clears the screen, like the EFB copy. GRRLIB's EFB has no alpha
+// channel, so the copy is opaque.
+void GRRLIB_CompoEnd(int posx, int posy, GRRLIB_texImg *tex) {
+    stats.fifoBytes += efbCopyBytes;
+    if (target == NULL) {
+        return;
+    }
+    std::vector<u8> rgba(tex->w * tex->h * 4, 0);
+    for (u32 y=0; y<tex->h; ++y) {
+        for (u32 x=0; x<tex->w; ++x) {
+            int sx = posx + x, sy = posy + y;
+            u8 *dst = &rgba[(y * tex->w + x) * 4];
+            if (sx < target->width() && sy < target->height()) {
+                std::memcpy(dst, target->pixels() +
+                    ((size_t)sy * target->width() + sx) * 4, 4);
+            }
+            dst[3] = 255;
+        }
+    }
+    tileRGBA8(rgba.data(), tex->w, tex->h, (u8 *)tex->data);
+    target->clear(0x000000FF);
+}
+
+void GX_InitTexObj(GXTexObj *obj, void *img, u16 width, u16 height, u8,
+    u8, u8, u8)
+{
+    obj->data = img;
+    obj->width = width;
+    obj->height = height;
+}
+
+void GX_InitTexObjLOD(GXTexObj *, u8, u8, f32, f32, f32, u8, u8, u8) {}
+
+void GX_LoadTexObj(GXTexObj *obj, u8) {
+    stats.fifoBytes += loadTextureBytes;
+    boundTexture = { (const uint8_t *)obj->data, obj->width, obj->height };
+}
+
+void GX_SetTevOp(u8, u8 mode) {
+    stats.fifoBytes += tevOpBytes;
+    modulated = mode == GX_MODULATE;
+}
+
+void GX_SetVtxDesc(u8 attr, u8 type) {
+    stats.fifoBytes += vtxDescBytes;
+    if (attr == GX_VA_TEX0) {
+        textured = type != GX_NONE;
+    }
+}
+
+void GX_LoadPosMtxImm(Mtx mtx, u32) {
+    stats.fifoBytes += matrixBytes;
+    std::memcpy(position, mtx, sizeof(Mtx));
+}
+
+void GX_Begin(u8, u8, u16 count) {
+    stats.fifoBytes += beginBytes;
+    vertices.clear();
+    vertices.reserve(count);
+}
+
+void GX_Position3f32(f32 x, f32 y, f32 z) {
+    stats.fifoBytes += positionBytes;
+    addVertex(x, y, z);
+}
+
+void GX_Color1u32(u32 color) {
+    stats.fifoBytes += colorBytes;
+    vertices.back().color = color;
+}
+
+void GX_TexCoord2f32(f32 s, f32 t) {
+    stats.fifoBytes += texCoordBytes;
+    vertices.back().s = s;
+    vertices.back().t = t;
+}
+
+void GX_End() {
+    drawVertices();
+}
+
+// Reads back the GX_QUADS lists of DisplayListWriter
+void GX_CallDispList(const void *list, u32 size) {
+    stats.fifoBytes += callListBytes;
+    auto bytes = (const u8 *)list;
+    u32 pos = 0;
+    while (pos + 3 <= size && bytes[pos] != 0) {
+        u32 count = (bytes[pos + 1] << 8) | bytes[pos + 2];
+        pos += 3;
+        vertices.clear();
+        for (u32 i=0; i<count && pos + 24 <= size; ++i, pos += 24) {
+            addVertex(readF32(bytes + pos), readF32(bytes + pos + 4),
+                readF32(bytes + pos + 8));
+            vertices.back().color = readU32(bytes + pos + 12);
+            vertices.back().s = readF32(bytes + pos + 16);
+            vertices.back().t = readF32(bytes + pos + 20);
+        }
+        drawVertices();
+    }
+}
+void guMtxIdentity(Mtx mtx) {
+    for (int i=0; i<3; ++i) {
+        for (int j=0; j<4; ++j) {
+            mtx[i][j] = i == j ? 1 : 0;
+        }
+    }
+}
+
+void guMtxTrans(Mtx mtx, f32 x, f32 y, f32 z) {
+    guMtxIdentity(mtx);
+    mtx[0][3] = x;
+    mtx[1][3] = y;
+    mtx[2][3] = z;
+}
+
+void guMtxConcat(Mtx a, Mtx b, Mtx ab) {
+    Mtx result;
+    for (int i=0; i<3; ++i) {
+        for (int j=0; j<4; ++j) {
+            result[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] +
+                a[i][2] * b[2][j] + (j == 3 ? a[i][3] : 0);
+        }
+    }
+    std::memcpy(ab, result, sizeof(Mtx));
+}
+
+void DCFlushRange(void *, u32) {}
@@ -0,0 +1,44 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <cstddef>
+#include <grrlib.h>
+#include "soft_raster.hpp"
+
+// Binds the GRRLIB and GX shim to the raster it draws into. Calls made
+// while nothing is bound are only counted.
+void softBind(SoftRaster *raster);
+
+// GRRLIB_LoadTexture() for a PNG of the given size
+GRRLIB_texImg *softLoadTexture(const u8 *png, size_t size);
+
+// Draw calls (GX_Begin(), display lists and GRRLIB primitives, which
+// are one GX_Begin() each except GRRLIB_Printf(), which is one per
+// character), vertices and bytes written to the GX FIFO submitted since
+// the last softResetStats(). The FIFO bytes are what the CPU writes for
+// each call on the Wii, close to but not exactly what libogc and GRRLIB
+// emit. The GPU reads display lists from memory, so their vertices
+// don't count.
+struct SoftStats {
+    unsigned drawCalls;
+    unsigned vertices;
+    unsigned fifoBytes;
+};
+SoftStats const& softStats();
+void softResetStats();
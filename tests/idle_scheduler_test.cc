@@ -0,0 +1,187 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Runs IdleScheduler against a fake clock that only moves when a frame
+// or a slice does work. Checks that slices only start when their
+// estimate fits, that the estimate of a job follows what it expects of
+// its next slice, corrected by how far off it was, and prints how much
+// of the idle time a simulated session of frames used and how often it
+// overran.
+
+#include <cstdio>
+#include "idle_scheduler.hpp"
+#include "test.hpp"
+
+static uint64_t now = 0;
+
+static uint64_t fakeClock() {
+    return now;
+}
+
+static unsigned nextRandom(unsigned &seed) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7FFF;
+}
+
+int main() {
+    // a slice is skipped if what the job expects doesn't fit
+    {
+        IdleScheduler scheduler { fakeClock };
+        int runs = 0;
+        scheduler.submit("big", [&] {
+            ++runs;
+            now += 4000;
+            return IdleResult::Done;
+        }, [] { return 5000u; });
+        now = 0;
+        CHECK_EQ(scheduler.run(3000), 0u);
+        CHECK_EQ(runs, 0);
+        CHECK_EQ(scheduler.run(6000), 1u);
+        CHECK_EQ(runs, 1);
+        CHECK_EQ(scheduler.pending(), 0u);
+        CHECK_EQ(scheduler.overruns(), 0u);
+    }
+
+    // without one, a slice is assumed to take firstEstimateMicros, and
+    // after that as long as the longest recent one
+    {
+        IdleScheduler scheduler { fakeClock };
+        int runs = 0;
+        scheduler.submit("measured", [&] {
+            ++runs;
+            now += 2500;
+            return IdleResult::Continue;
+        });
+        now = 0;
+        CHECK_EQ(scheduler.run(IdleScheduler::firstEstimateMicros - 1), 0u);
+        // runs once, then 2500 us no longer fit
+        now = 0;
+        CHECK_EQ(scheduler.run(4000), 1u);
+        CHECK_EQ(scheduler.overruns(), 0u);
+        now = 0;
+        CHECK_EQ(scheduler.run(2499), 0u);
+        now = 0;
+        CHECK_EQ(scheduler.run(5000), 2u);
+        CHECK_EQ(runs, 3);
+    }
+
+    // a job that takes twice as long as it expects gets twice the time
+    {
+        IdleScheduler scheduler { fakeClock };
+        uint32_t expected = 1000;
+        scheduler.submit("slow", [&] {
+            now += expected * 2;
+            return IdleResult::Continue;
+        }, [&] { return expected; });
+        now = 0;
+        CHECK_EQ(scheduler.run(1000), 1u);
+        CHECK_EQ(scheduler.overruns(), 1u);
+        expected = 500;
+        now = 0;
+        CHECK_EQ(scheduler.run(999), 0u);
+        now = 0;
+        CHECK_EQ(scheduler.run(1000), 1u);
+        CHECK_EQ(scheduler.overruns(), 1u);
+    }
+
+    // Yield waits for the next run, Done drops the job
+    {
+        IdleScheduler scheduler { fakeClock };
+        int yields = 0, left = 3;
+        scheduler.submit("yields", [&] {
+            ++yields;
+            now += 10;
+            return IdleResult::Yield;
+        }, [] { return 10u; });
+        scheduler.submit("three", [&] {
+            now += 10;
+            return --left == 0 ? IdleResult::Done : IdleResult::Continue;
+        }, [] { return 10u; });
+        now = 0;
+        CHECK_EQ(scheduler.run(10000), 4u);
+        CHECK_EQ(yields, 1);
+        CHECK_EQ(scheduler.pending(), 1u);
+        CHECK_EQ(scheduler.run(now + 10000), 1u);
+        CHECK_EQ(yields, 2);
+    }
+
+    // A session of 60 Hz frames with 3 ms kept before vsync, where the
+    // frame itself takes 6 to 16 ms. A decode job's slices depend on the
+    // size of the texture, which it tells with its Estimate, and a
+    // thumbnail job's are short.
+    {
+        const uint64_t period = 16683, margin = 3000;
+        const int frames = 20000;
+        IdleScheduler scheduler { fakeClock };
+        unsigned seed = 5;
+        unsigned nextTexture = 64 * 64;
+        uint64_t decoded = 0, thumbnails = 0;
+        scheduler.submit("texture prefetch", [&] {
+            if (nextRandom(seed) % 4 == 0) {
+                return IdleResult::Yield;
+            }
+            // 60 ns per pixel, give or take 10%
+            now += nextTexture * 60 / 1000 * (90 + nextRandom(seed) % 21) /
+                100;
+            ++decoded;
+            static const unsigned sizes[] = { 64, 128, 256 };
+            unsigned side = sizes[nextRandom(seed) % 3];
+            nextTexture = side * side;
+            return IdleResult::Continue;
+        }, [&] {
+            return (uint32_t)(nextTexture * 60 / 1000);
+        });
+        scheduler.submit("thumbnails", [&] {
+            if (nextRandom(seed) % 2 == 0) {
+                return IdleResult::Yield;
+            }
+            now += 150 + nextRandom(seed) % 100;
+            ++thumbnails;
+            return IdleResult::Continue;
+        });
+        uint64_t idle = 0, late = 0;
+        now = 0;
+        for (int i=0; i<frames; ++i) {
+            uint64_t frameStart = i * period;
+            now = frameStart + 6000 + nextRandom(seed) % 10000;
+            uint64_t deadline = frameStart + period - margin;
+            if (now < deadline) {
+                idle += deadline - now;
+            }
+            scheduler.run(deadline);
+            if (now > frameStart + period) {
+                ++late;
+            }
+        }
+        std::printf("%d frames: %llu of %llu ms of idle time used, %llu "
+            "slices (%llu decodes, %llu thumbnails), %llu overruns, %llu "
+            "missed vsyncs\n", frames,
+            (unsigned long long)scheduler.busyMicros() / 1000,
+            (unsigned long long)idle / 1000,
+            (unsigned long long)scheduler.slices(),
+            (unsigned long long)decoded, (unsigned long long)thumbnails,
+            (unsigned long long)scheduler.overruns(),
+            (unsigned long long)late);
+        CHECK(decoded > 0 && thumbnails > 0);
+        // only the noise of the decodes can overrun, and never past the
+        // margin
+        CHECK(scheduler.overruns() < scheduler.slices() / 50);
+        CHECK_EQ(late, 0u);
+    }
+    return testResult();
+}
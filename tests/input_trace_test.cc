@@ -0,0 +1,240 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Headless replay: records a session of a small stand-in for the
+// mascot simulation, driven the way shijimaWiiTick() drives the real
+// one (drag with A, dismiss with B, NTSC tick skip), to an input
+// trace, then plays the trace back without any input and checks the
+// state hash of every frame. Also checks that the header carries what
+// the replay needs, that spares built in idle time and mascots that
+// arrive from the loader have to be replayed where they were recorded,
+// and that a damaged trace ends the replay.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "input_trace.hpp"
+#include "test.hpp"
+
+static const uint32_t buttonA = 0x0008, buttonB = 0x0004;
+
+struct Body {
+    float x, y, dx;
+    bool dragging, dead;
+};
+
+class Simulation {
+public:
+    Simulation(TraceHeader const& header): m_phase(header.tickPhase) {
+        std::srand(header.seed);
+        m_width = header.width;
+        m_height = header.height;
+        for (int i=0; i<header.mascots; ++i) {
+            arrive();
+        }
+    }
+    // a mascot loaded while the session runs
+    void arrive() {
+        m_bodies.push_back({ (float)(std::rand() % m_width),
+            (float)(std::rand() % m_height),
+            (float)(std::rand() % 5 - 2), false, false });
+    }
+    // a spare mascot picks its first behavior when it is built
+    void refill() {
+        m_spares.push_back(std::rand() % 8);
+    }
+    void frame(InputFrame const& input) {
+        if (input.irValid && (input.down & (buttonA | buttonB))) {
+            for (auto &body : m_bodies) {
+                if (std::fabs(body.x - input.x) < 32 &&
+                    std::fabs(body.y - input.y) < 32)
+                {
+                    body.dragging |= (input.down & buttonA) != 0;
+                    body.dead |= (input.down & buttonB) != 0;
+                    // a dismissed mascot is replaced by a spare
+                    if (body.dead && !m_spares.empty()) {
+                        body.dx = m_spares.back() - 4;
+                        body.dead = false;
+                        m_spares.pop_back();
+                    }
+                    break;
+                }
+            }
+        }
+        bool dragging = input.irValid && ((input.held | input.down) & buttonA);
+        for (auto &body : m_bodies) {
+            body.dragging &= dragging;
+            if (m_phase == 5 || body.dead) {
+                continue;
+            }
+            if (body.dragging) {
+                body.x = input.x;
+                body.y = input.y;
+                continue;
+            }
+            body.x += body.dx;
+            body.y = std::min(body.y + 2, (float)m_height);
+            if (body.x < 0 || body.x > m_width) {
+                body.dx = -body.dx;
+                // mascots pick a new pace when they turn around
+                body.dx += (std::rand() % 3 - 1) * 0.5f;
+            }
+        }
+        m_phase = (m_phase + 1) % 6;
+    }
+    uint32_t hash() const {
+        uint32_t hash = fnv1aBasis;
+        for (auto &body : m_bodies) {
+            uint8_t flags = (body.dragging ? 1 : 0) | (body.dead ? 2 : 0);
+            hash = fnv1a(hash, &body.x, sizeof(body.x));
+            hash = fnv1a(hash, &body.y, sizeof(body.y));
+            hash = fnv1a(hash, &body.dx, sizeof(body.dx));
+            hash = fnv1a(hash, &flags, sizeof(flags));
+        }
+        return hash;
+    }
+private:
+    std::vector<Body> m_bodies;
+    std::vector<int> m_spares;
+    int m_width, m_height;
+    uint8_t m_phase;
+};
+
+// Plays the trace at path back and returns the first frame whose state
+// differs from the recording, or -1 if none does.
+static long replay(const char *path, TraceHeader const *header,
+    uint32_t *frames, bool refills = true, bool arrivals = true)
+{
+    InputTraceReader reader;
+    CHECK(reader.open(path));
+    Simulation sim { header != NULL ? *header : reader.header() };
+    InputFrame input;
+    uint32_t hash;
+    long diverged = -1;
+    while (reader.next(input, hash)) {
+        for (uint32_t i=0; refills && i<input.refills; ++i) {
+            sim.refill();
+        }
+        for (uint32_t i=0; arrivals && i<input.arrivals; ++i) {
+            sim.arrive();
+        }
+        sim.frame(input);
+        if (sim.hash() != hash && diverged < 0) {
+            diverged = reader.frames() - 1;
+        }
+    }
+    *frames = reader.frames();
+    return diverged;
+}
+
+int main() {
+    const char *path = "input_trace_test.trace";
+    const uint32_t frameCount = 3000;
+    // a session that started in the middle of the NTSC cycle with the
+    // picker open
+    TraceHeader header { 1234, 640, 480, 3, true, 20 };
+    InputTraceWriter writer;
+    CHECK(writer.open(path, header));
+    Simulation sim { header };
+    std::vector<InputFrame> inputs;
+    InputFrame input {};
+    for (uint32_t i=0; i<frameCount; ++i) {
+        // the pointer drifts, with buttons every now and then
+        input.irValid = (i % 400) < 350;
+        input.x = 320 + 300 * std::sin(i * 0.01f);
+        input.y = 240 + 200 * std::cos(i * 0.013f);
+        uint32_t previous = input.held;
+        input.held = (i % 97) < 30 ? buttonA : 0;
+        input.down = input.held & ~previous;
+        input.up = previous & ~input.held;
+        if (i % 251 == 0) {
+            input.down |= buttonB;
+        }
+        // spares are built whenever a frame has time left
+        input.refills = (i * 7919) % 13 < 2 ? 1 + i % 2 : 0;
+        for (uint32_t j=0; j<input.refills; ++j) {
+            sim.refill();
+        }
+        // the loader is still going for the first 1000 frames
+        input.arrivals = i < 1000 && i % 97 == 5 ? 1 : 0;
+        for (uint32_t j=0; j<input.arrivals; ++j) {
+            sim.arrive();
+        }
+        sim.frame(input);
+        writer.write(input, sim.hash());
+        inputs.push_back(input);
+    }
+    CHECK_EQ(writer.frames(), frameCount);
+    writer.close();
+
+    InputTraceReader reader;
+    CHECK(reader.open(path));
+    CHECK_EQ(reader.header().seed, header.seed);
+    CHECK_EQ(reader.header().width, header.width);
+    CHECK_EQ(reader.header().height, header.height);
+    CHECK_EQ(reader.header().tickPhase, header.tickPhase);
+    CHECK(reader.header().pickerVisible);
+    CHECK_EQ(reader.header().mascots, header.mascots);
+    uint32_t hash;
+    for (auto &recorded : inputs) {
+        CHECK(reader.next(input, hash));
+        CHECK(input.irValid == recorded.irValid);
+        CHECK_EQ(input.down, recorded.down);
+        CHECK_EQ(input.held, recorded.held);
+        CHECK_EQ(input.up, recorded.up);
+        CHECK_EQ(input.refills, recorded.refills);
+        CHECK_EQ(input.arrivals, recorded.arrivals);
+        if (recorded.irValid) {
+            CHECK(input.x == recorded.x && input.y == recorded.y);
+        }
+    }
+    CHECK(!reader.next(input, hash));
+
+    uint32_t frames;
+    CHECK_EQ(replay(path, NULL, &frames), -1L);
+    CHECK_EQ(frames, frameCount);
+    // starting from another point of the NTSC cycle doesn't replay
+    TraceHeader wrongPhase = header;
+    wrongPhase.tickPhase = 0;
+    long diverged = replay(path, &wrongPhase, &frames);
+    CHECK(diverged >= 0 && diverged < 6);
+    std::printf("replayed %u frames, diverged at frame %ld with the wrong "
+        "tick phase\n", frameCount, diverged);
+    // nor does leaving the spares to the replay's own idle time
+    CHECK(replay(path, NULL, &frames, false) >= 0);
+    // or the mascots that arrived from the loader
+    CHECK(replay(path, NULL, &frames, true, false) >= 0);
+
+    // a cut off trace stops where it is damaged
+    std::vector<char> data;
+    FILE *file = std::fopen(path, "rb");
+    char buffer[4096];
+    size_t size;
+    while ((size = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + size);
+    }
+    std::fclose(file);
+    file = std::fopen(path, "wb");
+    std::fwrite(data.data(), 1, data.size() - 3, file);
+    std::fclose(file);
+    CHECK_EQ(replay(path, NULL, &frames), -1L);
+    CHECK_EQ(frames, frameCount - 1);
+    std::remove(path);
+    return testResult();
+}
@@ -0,0 +1,216 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Builds a library of 200 fake mascot folders and measures what it
+// costs to tell whether the library index still describes it, against
+// a stat() of every indexed file, on a filesystem where every stat()
+// takes as long as it does on an SD card. The test is linked with
+// -Wl,--wrap=stat, so the stat() calls of library_index.cc come here.
+// Also checks that the index notices added sprites and mascots, and
+// that files named like a mascot folder are not taken for one, and
+// that a preview file edited in place is noticed although no folder
+// changed.
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <sys/stat.h>
+#include "library_index.hpp"
+#include "test.hpp"
+
+static unsigned statCalls = 0;
+static double statMicros = 0;
+
+extern "C" int __real_stat(const char *path, struct stat *st);
+extern "C" int __wrap_stat(const char *path, struct stat *st) {
+    ++statCalls;
+    if (statMicros > 0) {
+        double start = testMicros();
+        while (testMicros() - start < statMicros) {}
+    }
+    return __real_stat(path, st);
+}
+
+namespace fs = std::filesystem;
+
+static const int mascotCount = 200;
+static const int spritesPerMascot = 46;
+
+static void touch(fs::path const& path) {
+    FILE *file = std::fopen(path.c_str(), "wb");
+    CHECK(file != NULL);
+    std::fputs(path.filename().c_str(), file);
+    std::fclose(file);
+}
+
+// everything an hour in the past, so that changes get a new mtime
+static void age(fs::path const& path) {
+    auto old = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    for (auto &entry : fs::recursive_directory_iterator { path }) {
+        fs::last_write_time(entry.path(), old);
+    }
+    fs::last_write_time(path, old);
+}
+
+static std::string mascotDir(fs::path const& library, int i) {
+    return (library / ("Mascot" + std::to_string(i) + ".mascot")).string();
+}
+
+// what the loader records after probing every mascot
+static void refresh(fs::path const& library, LibraryIndex &index) {
+    for (auto &mascot : index.mascots) {
+        CHECK(LibraryIndex::statFiles(mascotDir(library,
+            std::stoi(mascot.name.substr(6))), mascot));
+    }
+    uint64_t size;
+    CHECK(LibraryIndex::statPath(library.string(), size, index.dirMtime));
+}
+
+static void buildLibrary(fs::path const& library, LibraryIndex &index) {
+    fs::remove_all(library);
+    fs::create_directories(library);
+    index.mascots.clear();
+    for (int i=0; i<mascotCount; ++i) {
+        fs::path dir = mascotDir(library, i);
+        fs::create_directories(dir / "img");
+        touch(dir / "actions.xml");
+        touch(dir / "behaviors.xml");
+        LibraryIndex::Mascot mascot;
+        mascot.name = "Mascot" + std::to_string(i);
+        mascot.tmpl = LibraryIndex::TemplateXML;
+        mascot.graphics = LibraryIndex::GraphicsPNG;
+        mascot.files.push_back({ "actions.xml", 0, 0, false });
+        mascot.files.push_back({ "behaviors.xml", 0, 0, false });
+        mascot.files.push_back({ "img", 0, 0, true });
+        for (int j=0; j<spritesPerMascot; ++j) {
+            std::string name = "img/shime" + std::to_string(j + 1) + ".png";
+            touch(dir / name);
+            mascot.files.push_back({ name, 0, 0, false });
+        }
+        mascot.preview = "img/shime1.png";
+        index.mascots.push_back(std::move(mascot));
+    }
+    // a stray file and the cache folder are not mascots
+    touch(library / "notes.mascot");
+    fs::create_directories(library / ".cache");
+    std::sort(index.mascots.begin(), index.mascots.end(),
+        [](LibraryIndex::Mascot const& a, LibraryIndex::Mascot const& b) {
+            return a.name < b.name;
+        });
+    age(library);
+    refresh(library, index);
+}
+
+int main() {
+    fs::path library = fs::absolute("library_index_test.library");
+    std::string indexPath = "library_index_test.index";
+    LibraryIndex built;
+    buildLibrary(library, built);
+
+    std::vector<std::string> names;
+    CHECK(LibraryIndex::listMascots(library.string(), names));
+    CHECK_EQ(names.size(), (size_t)mascotCount);
+
+    CHECK(built.write(indexPath));
+    LibraryIndex index;
+    CHECK(index.read(indexPath));
+    CHECK_EQ(index.mascots.size(), (size_t)mascotCount);
+    CHECK_EQ(index.mascots[0].mtime, built.mascots[0].mtime);
+    CHECK_EQ(index.mascots[0].files.size(), built.mascots[0].files.size());
+    CHECK(index.mascots[0].files[2].folder);
+    CHECK(!index.mascots[0].files[3].folder);
+    CHECK(index.mascots[0].preview == "img/shime1.png");
+
+    // a boot that can use the index, on a filesystem with SD latency
+    statMicros = 200;
+    statCalls = 0;
+    double start = testMicros();
+    CHECK(index.matches(library.string()));
+    double matchMicros = testMicros() - start;
+    unsigned matchCalls = statCalls;
+
+    // checking every file instead
+    statCalls = 0;
+    start = testMicros();
+    for (auto &mascot : index.mascots) {
+        auto current = mascot;
+        CHECK(LibraryIndex::statFiles(library.string() + "/" + mascot.name +
+            ".mascot", current));
+    }
+    double filesMicros = testMicros() - start;
+    unsigned filesCalls = statCalls;
+    statMicros = 0;
+    std::printf("%d mascots: index check %.0f ms (%u stat), "
+        "every file %.0f ms (%u stat)\n", mascotCount, matchMicros / 1000,
+        matchCalls, filesMicros / 1000, filesCalls);
+    CHECK(matchCalls < filesCalls / 10);
+
+    // the preview edited in place, as FAT leaves the folder mtime alone
+    {
+        auto &mascot = index.mascots[3];
+        std::string dir = library.string() + "/" + mascot.name + ".mascot";
+        CHECK(LibraryIndex::previewMatches(dir, mascot));
+        auto dirTime = fs::last_write_time(dir);
+        auto imgTime = fs::last_write_time(dir + "/img");
+        FILE *file = std::fopen((dir + "/img/shime1.png").c_str(), "wb");
+        CHECK(file != NULL);
+        std::fputs("edited in place", file);
+        std::fclose(file);
+        fs::last_write_time(dir + "/img", imgTime);
+        fs::last_write_time(dir, dirTime);
+        CHECK(index.matches(library.string()));
+        CHECK(!LibraryIndex::previewMatches(dir, mascot));
+        bool touched = false;
+        auto record = mascot;
+        CHECK(LibraryIndex::changed(dir, record, touched));
+        // other sprites are only checked when their folder changed
+        record = index.mascots[4];
+        std::string other = library.string() + "/" + record.name +
+            ".mascot";
+        CHECK(LibraryIndex::previewMatches(other, record));
+        CHECK(!LibraryIndex::changed(other, record, touched));
+        CHECK(!touched);
+        CHECK(LibraryIndex::statFiles(dir, mascot));
+        CHECK(LibraryIndex::previewMatches(dir, mascot));
+    }
+
+    // a sprite added to one mascot
+    touch(library / "Mascot17.mascot" / "img" / "shime47.png");
+    CHECK(!index.matches(library.string()));
+    age(library);
+    CHECK(index.read(indexPath));
+    CHECK(!index.matches(library.string()));
+
+    // a mascot folder added
+    for (auto &mascot : built.mascots) {
+        if (mascot.name == "Mascot17") {
+            mascot.files.push_back({ "img/shime47.png", 0, 0, false });
+        }
+    }
+    refresh(library, built);
+    CHECK(built.write(indexPath));
+    CHECK(index.read(indexPath));
+    CHECK(index.matches(library.string()));
+    fs::create_directories(library / "New.mascot");
+    CHECK(!index.matches(library.string()));
+
+    fs::remove_all(library);
+    std::remove(indexPath.c_str());
+    return testResult();
+}
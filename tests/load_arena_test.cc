@@ -0,0 +1,244 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Replays the allocations of loading a mascot library against a model
+// of a first-fit heap, once with the load temporaries taken from the
+// heap and once from a LoadArena, and compares the largest free block
+// before and after the load and the free space left in holes too small
+// for a decoded sprite. The arena variant places its temporaries
+// with a real LoadArena, so anything that overflows it goes to the
+// model heap like it does on the Wii.
+
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include "load_arena.hpp"
+#include "test.hpp"
+
+// First-fit heap over [0, size) that coalesces freed neighbours, with
+// the 32 byte granularity of the Wii's malloc()
+class HeapModel {
+public:
+    explicit HeapModel(size_t size) {
+        m_free[0] = size;
+    }
+    // returns the offset of the block, or -1 if nothing is large enough
+    long allocate(size_t size) {
+        size = (size + 31) & ~(size_t)31;
+        for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+            if (it->second >= size) {
+                size_t offset = it->first, rest = it->second - size;
+                m_free.erase(it);
+                if (rest > 0) {
+                    m_free[offset + size] = rest;
+                }
+                m_used[offset] = size;
+                return (long)offset;
+            }
+        }
+        return -1;
+    }
+    void release(long offset) {
+        if (offset < 0) {
+            return;
+        }
+        auto used = m_used.find((size_t)offset);
+        CHECK(used != m_used.end());
+        size_t start = used->first, size = used->second;
+        m_used.erase(used);
+        auto next = m_free.lower_bound(start);
+        if (next != m_free.end() && next->first == start + size) {
+            size += next->second;
+            next = m_free.erase(next);
+        }
+        if (next != m_free.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == start) {
+                prev->second += size;
+                return;
+            }
+        }
+        m_free[start] = size;
+    }
+    size_t largestFree() const {
+        size_t largest = 0;
+        for (auto &block : m_free) {
+            largest = std::max(largest, block.second);
+        }
+        return largest;
+    }
+    size_t freeBlocks() const {
+        return m_free.size();
+    }
+    // free bytes in blocks smaller than size
+    size_t freeBelow(size_t size) const {
+        size_t total = 0;
+        for (auto &block : m_free) {
+            total += block.second < size ? block.second : 0;
+        }
+        return total;
+    }
+    size_t usedBlocks() const {
+        return m_used.size();
+    }
+private:
+    std::map<size_t, size_t> m_free;
+    std::map<size_t, size_t> m_used;
+};
+
+// Where the temporaries of one load go: the heap model, or the arena
+// with the heap model as its fallback
+class Loader {
+public:
+    Loader(HeapModel &heap, LoadArena *arena): m_heap(heap), m_arena(arena) {}
+    void *allocate(size_t size) {
+        if (m_arena != NULL) {
+            void *ptr = loadMalloc(size);
+            if (m_arena->owns(ptr)) {
+                return ptr;
+            }
+            free(ptr);
+        }
+        long offset = m_heap.allocate(size);
+        CHECK(offset >= 0);
+        m_fallback.push_back(offset);
+        return (void *)(intptr_t)(offset | 1);
+    }
+    void release(void *ptr) {
+        if (ptr == NULL) {
+            return;
+        }
+        if (((intptr_t)ptr & 1) == 0) {
+            loadFree(ptr);
+            return;
+        }
+        long offset = (intptr_t)ptr & ~(intptr_t)1;
+        m_heap.release(offset);
+        for (auto &fallback : m_fallback) {
+            if (fallback == offset) {
+                fallback = m_fallback.back();
+                m_fallback.pop_back();
+                break;
+            }
+        }
+    }
+    // temporaries that were not released
+    size_t leaked() const {
+        return m_fallback.size();
+    }
+private:
+    HeapModel &m_heap;
+    LoadArena *m_arena;
+    std::vector<long> m_fallback;
+};
+
+struct LoadResult {
+    size_t largestBefore;
+    size_t largestFree;
+    size_t freeBlocks;
+    size_t stranded;
+    size_t leaked;
+    size_t arenaPeak;
+    size_t arenaOverflows;
+};
+
+static const size_t heapSize = 40 * 1024 * 1024;
+static const int mascotCount = 32;
+static const int spritesPerMascot = 46;
+// a decoded 128x128 sprite
+static const size_t holeSize = 128 * 128 * 4;
+
+// The allocations of loadMascot(): the XML and its parse, then for each
+// sprite the encoded PNG, which stays, and for sheets that aren't a
+// multiple of 4 the resize of MascotSpritePNG: decode, 1 MiB scratch
+// and re-encode, of which only the copy in the texture slot stays.
+static LoadResult loadLibrary(size_t arenaSize) {
+    HeapModel heap { heapSize };
+    size_t largestBefore = heap.largestFree();
+    LoadArena arena { arenaSize };
+    long arenaBlock = arenaSize > 0 ? heap.allocate(arenaSize) : -1;
+    Loader loader { heap, arenaSize > 0 ? &arena : NULL };
+    std::vector<long> kept;
+    std::srand(1);
+    for (int i=0; i<mascotCount; ++i) {
+        LoadArena::Scope scope { arena };
+        kept.push_back(heap.allocate(4096));
+        void *xml = loader.allocate(60 * 1024 + std::rand() % 40000);
+        void *tree = loader.allocate(200 * 1024);
+        for (int j=0; j<spritesPerMascot; ++j) {
+            size_t encoded = 4 * 1024 + std::rand() % 12000;
+            bool resize = (j % 3) == 0;
+            if (!resize) {
+                kept.push_back(heap.allocate(encoded));
+                continue;
+            }
+            void *data = loader.allocate(encoded);
+            void *oldBuf = loader.allocate(126 * 126 * 4);
+            void *buf = loader.allocate(512 * 512 * 4);
+            void *newPng = loader.allocate(encoded + 2048);
+            kept.push_back(heap.allocate(encoded + 2048));
+            loader.release(newPng);
+            loader.release(buf);
+            loader.release(oldBuf);
+            loader.release(data);
+        }
+        loader.release(tree);
+        loader.release(xml);
+    }
+    heap.release(arenaBlock);
+    LoadResult result { largestBefore, heap.largestFree(), heap.freeBlocks(),
+        heap.freeBelow(holeSize), loader.leaked(), arena.peak(),
+        arena.overflows() };
+    // everything the mascots kept goes away with them again
+    for (long block : kept) {
+        CHECK(block >= 0);
+        heap.release(block);
+    }
+    CHECK_EQ(heap.usedBlocks(), (size_t)0);
+    CHECK_EQ(heap.freeBlocks(), (size_t)1);
+    return result;
+}
+
+static void print(const char *name, LoadResult const& result) {
+    std::printf("%-12s largest free block %5zu -> %5zu KiB, %3zu free "
+        "blocks, %4zu KiB in holes, arena peak %4zu KiB, %3zu overflows\n",
+        name, result.largestBefore / 1024, result.largestFree / 1024,
+        result.freeBlocks, result.stranded / 1024, result.arenaPeak / 1024,
+        result.arenaOverflows);
+}
+
+int main() {
+    auto heap = loadLibrary(0);
+    auto small = loadLibrary(1024 * 1024);
+    auto arena = loadLibrary(4 * 1024 * 1024);
+    print("heap", heap);
+    print("1 MiB arena", small);
+    print("4 MiB arena", arena);
+    CHECK_EQ(heap.leaked, (size_t)0);
+    CHECK_EQ(small.leaked, (size_t)0);
+    CHECK_EQ(arena.leaked, (size_t)0);
+    // LOAD_ARENA_SIZE fits a whole mascot. The kept blocks are packed
+    // behind the arena, whose block is free again afterwards, instead
+    // of around the holes the temporaries leave.
+    CHECK_EQ(arena.arenaOverflows, (size_t)0);
+    CHECK(arena.freeBlocks < heap.freeBlocks);
+    CHECK(arena.stranded < heap.stranded / 4);
+    // overflowing temporaries fall back to the heap and are freed there
+    CHECK(small.arenaOverflows > 0);
+    return testResult();
+}
@@ -0,0 +1,341 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Runs MascotLoader over a library of fake mascot folders: the first
+// boot probes every folder and writes the index, the next boot loads
+// from the index, an indexed entry that fails is probed again, a
+// reload picks up a replaced file and a removed folder, a preview edited
+// in place is noticed although its folder kept its mtime, and
+// cancelling frees what wasn't handed over.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mascot_loader.hpp"
+#include "test.hpp"
+
+namespace fs = std::filesystem;
+
+static std::atomic<int> liveMascots { 0 };
+
+struct FakeMascot {
+    FakeMascot(std::string name, bool indexed, bool removed):
+        name(name), indexed(indexed), removed(removed)
+    {
+        ++liveMascots;
+    }
+    ~FakeMascot() {
+        --liveMascots;
+    }
+    std::string name;
+    bool indexed;
+    bool removed;
+};
+
+static std::atomic<int> loadCalls { 0 };
+static std::atomic<int> loadMillis { 0 };
+// indexed loads of these fail, like a mascot whose index entry is stale
+static std::set<std::string> failIndexed;
+
+// A mascot is a folder with actions.xml and img/shime1.png
+static FakeMascot *loadFake(std::string const& dir,
+    LibraryIndex::Mascot &record, bool indexed, FilePipeline &)
+{
+    ++loadCalls;
+    if (loadMillis > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(loadMillis));
+    }
+    if (indexed && failIndexed.count(record.name) != 0) {
+        return nullptr;
+    }
+    if (!indexed) {
+        // the folder is recorded even if it fails, like MascotData does
+        record.files.clear();
+        LibraryIndex::statFiles(dir, record);
+        if (!fs::exists(dir + "/actions.xml")) {
+            return nullptr;
+        }
+        record.tmpl = LibraryIndex::TemplateXML;
+        record.graphics = LibraryIndex::GraphicsPNG;
+        record.files = { { "img", 0, 0, true },
+            { "actions.xml", 0, 0, false },
+            { "img/shime1.png", 0, 0, false } };
+        record.preview = "img/shime1.png";
+        if (!LibraryIndex::statFiles(dir, record)) {
+            return nullptr;
+        }
+    }
+    return new FakeMascot { record.name, indexed, false };
+}
+
+static FakeMascot *removedFake(std::string const& name) {
+    return new FakeMascot { name, false, true };
+}
+
+static std::ostringstream logged;
+
+static std::ostream &log() {
+    return logged;
+}
+
+static void writeFile(fs::path const& path, std::string const& text) {
+    FILE *file = std::fopen(path.c_str(), "wb");
+    CHECK(file != NULL);
+    if (file != NULL) {
+        std::fputs(text.c_str(), file);
+        std::fclose(file);
+    }
+}
+
+// Rewrites the preview of a mascot and puts back the mtimes of its
+// folders, which is all FAT does for an edit in place
+static void editPreview(fs::path const& library, std::string const& name,
+    std::string const& text)
+{
+    auto dir = library / (name + ".mascot");
+    auto dirTime = fs::last_write_time(dir);
+    auto imgTime = fs::last_write_time(dir / "img");
+    writeFile(dir / "img" / "shime1.png", text);
+    fs::last_write_time(dir / "img", imgTime);
+    fs::last_write_time(dir, dirTime);
+}
+
+static void makeMascot(fs::path const& library, std::string const& name) {
+    auto dir = library / (name + ".mascot");
+    fs::create_directories(dir / "img");
+    writeFile(dir / "actions.xml", "<actions/>");
+    writeFile(dir / "img" / "shime1.png", "png");
+}
+
+// everything an hour in the past, so that changes get a new mtime
+static void age(fs::path const& path) {
+    auto old = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    for (auto &entry : fs::recursive_directory_iterator { path }) {
+        fs::last_write_time(entry.path(), old);
+    }
+    fs::last_write_time(path, old);
+}
+
+// Waits for the loader and pops everything it loaded
+static std::vector<FakeMascot *> finish(MascotLoader<FakeMascot> &loader) {
+    std::vector<FakeMascot *> mascots;
+    for (int i=0; i<5000 && !loader.finished(); ++i) {
+        FakeMascot *mascot;
+        while (loader.pop(mascot)) {
+            mascots.push_back(mascot);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(loader.finished());
+    loader.join();
+    FakeMascot *mascot;
+    while (loader.pop(mascot)) {
+        mascots.push_back(mascot);
+    }
+    return mascots;
+}
+
+static int countIndexed(std::vector<FakeMascot *> const& mascots) {
+    int indexed = 0;
+    for (auto mascot : mascots) {
+        indexed += mascot->indexed;
+    }
+    return indexed;
+}
+
+static void freeAll(std::vector<FakeMascot *> &mascots) {
+    for (auto mascot : mascots) {
+        delete mascot;
+    }
+    mascots.clear();
+}
+
+int main() {
+    fs::path root = fs::absolute("mascot_loader_test.root");
+    fs::path library = root / "Shijima";
+    fs::path cache = library / ".cache";
+    fs::remove_all(root);
+    fs::create_directories(library);
+    for (auto name : { "Alpha", "Beta", "Gamma", "Delta" }) {
+        makeMascot(library, name);
+    }
+    // a folder that isn't a mascot is listed, but doesn't load
+    fs::create_directories(library / "Empty.mascot");
+    age(library);
+    MascotLoader<FakeMascot>::Config config { library.string(),
+        (cache / "library.index").string(), { cache.string() }, 64 * 1024,
+        loadFake, removedFake, log };
+
+    // the first boot probes every folder and writes the index. The
+    // loader is only drained once the mascots it finished are popped.
+    {
+        MascotLoader<FakeMascot> loader { config };
+        CHECK(loader.load());
+        for (int i=0; i<5000 && !loader.finished(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(loader.finished());
+        CHECK(!loader.drained());
+        auto mascots = finish(loader);
+        CHECK(loader.drained());
+        CHECK_EQ(mascots.size(), 4u);
+        CHECK_EQ(countIndexed(mascots), 0);
+        CHECK_EQ(loader.total(), 5);
+        CHECK_EQ(loader.done(), 5);
+        CHECK(fs::exists(cache / "library.index"));
+        CHECK(loader.index().matches(library.string()));
+        freeAll(mascots);
+    }
+
+    // the next boot trusts the index, and probes the failed entry again
+    loadCalls = 0;
+    {
+        MascotLoader<FakeMascot> loader { config };
+        logged.str("");
+        CHECK(loader.load());
+        auto mascots = finish(loader);
+        CHECK_EQ(mascots.size(), 4u);
+        CHECK_EQ(countIndexed(mascots), 4);
+        // Empty.mascot failed last time, so it is probed again
+        CHECK_EQ(loadCalls.load(), 5);
+        CHECK(logged.str().find("Using library index") != std::string::npos);
+        freeAll(mascots);
+    }
+
+    // an indexed entry that fails is probed again and the index updated
+    failIndexed = { "Gamma" };
+    loadCalls = 0;
+    {
+        MascotLoader<FakeMascot> loader { config };
+        logged.str("");
+        CHECK(loader.load());
+        auto mascots = finish(loader);
+        CHECK_EQ(mascots.size(), 4u);
+        CHECK_EQ(countIndexed(mascots), 3);
+        CHECK_EQ(loadCalls.load(), 6);
+        CHECK(logged.str().find("Index out of date for Gamma") !=
+            std::string::npos);
+        freeAll(mascots);
+    }
+    failIndexed.clear();
+
+    // A reload after replacing a file of Beta, which changes the mtime of
+    // its folder, removing Delta and adding Epsilon
+    {
+        MascotLoader<FakeMascot> loader { config };
+        CHECK(loader.load());
+        auto mascots = finish(loader);
+        CHECK_EQ(mascots.size(), 4u);
+        freeAll(mascots);
+
+        auto beta = library / "Beta.mascot";
+        writeFile(beta / "actions.new", "<actions>changed</actions>");
+        fs::rename(beta / "actions.new", beta / "actions.xml");
+        fs::remove_all(library / "Delta.mascot");
+        makeMascot(library, "Epsilon");
+        loadCalls = 0;
+        CHECK(loader.reload());
+        mascots = finish(loader);
+        std::set<std::string> loaded, removed;
+        for (auto mascot : mascots) {
+            (mascot->removed ? removed : loaded).insert(mascot->name);
+        }
+        // Empty.mascot still fails, so it is tried again too
+        CHECK(loaded == (std::set<std::string> { "Beta", "Epsilon" }));
+        CHECK(removed == (std::set<std::string> { "Delta" }));
+        CHECK_EQ(loadCalls.load(), 3);
+        CHECK_EQ(loader.total(), 4);
+        CHECK(loader.index().matches(library.string()));
+        freeAll(mascots);
+
+        // nothing changed since
+        loadCalls = 0;
+        CHECK(loader.reload());
+        mascots = finish(loader);
+        CHECK(mascots.empty());
+        CHECK_EQ(loadCalls.load(), 1);
+    }
+
+    // a preview edited in place is probed again on the next boot, so
+    // that its thumbnail is written again, and by a reload
+    editPreview(library, "Alpha", "a different png");
+    loadCalls = 0;
+    {
+        MascotLoader<FakeMascot> loader { config };
+        logged.str("");
+        CHECK(loader.load());
+        auto mascots = finish(loader);
+        CHECK_EQ(mascots.size(), 4u);
+        CHECK_EQ(countIndexed(mascots), 3);
+        for (auto mascot : mascots) {
+            CHECK_EQ(mascot->indexed, mascot->name != "Alpha");
+        }
+        CHECK(logged.str().find("Preview of Alpha changed") !=
+            std::string::npos);
+        CHECK_EQ(loadCalls.load(), 5);
+        freeAll(mascots);
+
+        editPreview(library, "Gamma", "another png");
+        CHECK(loader.index().matches(library.string()));
+        loadCalls = 0;
+        CHECK(loader.reload());
+        mascots = finish(loader);
+        CHECK_EQ(mascots.size(), 1u);
+        CHECK(mascots[0]->name == "Gamma");
+        CHECK_EQ(loadCalls.load(), 2);
+        freeAll(mascots);
+    }
+    // and the index written after the boot has the new preview
+    loadCalls = 0;
+    {
+        MascotLoader<FakeMascot> loader { config };
+        CHECK(loader.load());
+        auto mascots = finish(loader);
+        CHECK_EQ(countIndexed(mascots), 4);
+        CHECK_EQ(loadCalls.load(), 5);
+        freeAll(mascots);
+    }
+
+    // Cancelling a load that has filled the queue, which holds 31,
+    // frees the mascots it still holds
+    for (int i=0; i<40; ++i) {
+        makeMascot(library, "Many" + std::to_string(i));
+    }
+    loadMillis = 1;
+    {
+        MascotLoader<FakeMascot> loader { config };
+        CHECK(loader.load());
+        for (int i=0; i<5000 && loader.done() < 31; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(loader.done() >= 31);
+        loader.cancel();
+        CHECK(!loader.running());
+        CHECK_EQ(liveMascots.load(), 0);
+    }
+    CHECK_EQ(liveMascots.load(), 0);
+
+    fs::remove_all(root);
+    return testResult();
+}
@@ -0,0 +1,119 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Formats the memory table for a few mascots with known sizes and
+// checks the order, the columns, the sum row and the written file.
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "memory_report.hpp"
+#include "test.hpp"
+
+static const size_t KiB = 1024;
+
+// the numbers of a table line, without its name
+static std::vector<unsigned> columns(std::string const& line) {
+    std::vector<unsigned> values;
+    const char *p = line.c_str() + 18;
+    unsigned value;
+    int used;
+    while (sscanf(p, " %u%n", &value, &used) == 1 ||
+        sscanf(p, " x %u%n", &value, &used) == 1)
+    {
+        values.push_back(value);
+        p += used;
+    }
+    return values;
+}
+
+int main() {
+    MascotMemory small;
+    small.pngTextures = 10 * KiB;
+    small.textureFiles = 20 * KiB;
+    small.spriteMap = 2 * KiB;
+    small.tmpl = 8 * KiB;
+    small.instance = 3 * KiB;
+    MascotMemory large;
+    large.qutexTextures = 512 * KiB;
+    large.textureFiles = 100 * KiB;
+    large.displayLists = 4 * KiB;
+    large.spriteMap = 6 * KiB;
+    large.tmpl = 30 * KiB;
+    large.instance = 5 * KiB;
+    CHECK_EQ(small.total(0), 40 * KiB);
+    CHECK_EQ(small.total(2), 46 * KiB);
+    CHECK_EQ(large.total(1), 657 * KiB);
+
+    // a small mascot with many instances can outweigh a larger one,
+    // and a name longer than the column is cut
+    std::vector<MascotMemoryRow> rows {
+        { "Small", small, 2 },
+        { "Large", large, 1 },
+        { "Unused one with a long name", MascotMemory(), 0 },
+        { "Crowd", small, 200 },
+    };
+    auto lines = formatMemoryTable(rows);
+    for (auto &line : lines) {
+        printf("%s\n", line.c_str());
+    }
+    CHECK_EQ(lines.size(), 6u);
+    if (lines.size() != 6) {
+        return testResult();
+    }
+    CHECK(lines[0].compare(0, 3, "KiB") == 0);
+    CHECK(lines[1].compare(0, 18, "Large             ") == 0);
+    CHECK(lines[2].compare(0, 18, "Crowd             ") == 0);
+    CHECK(lines[3].compare(0, 18, "Small             ") == 0);
+    CHECK(lines[4].compare(0, 18, "Unused one with a ") == 0);
+    CHECK(lines[5].compare(0, 18, "(all)             ") == 0);
+    // every line has the same columns as the header
+    for (auto &line : lines) {
+        CHECK_EQ(line.size(), lines[0].size());
+    }
+    std::vector<unsigned> expected { 512, 0, 100, 4, 6, 30, 1, 5, 657 };
+    CHECK(columns(lines[1]) == expected);
+    expected = { 0, 10, 20, 0, 2, 8, 200, 3, 640 };
+    CHECK(columns(lines[2]) == expected);
+    // sums, with the average instance size of 611 KiB / 203 rounded up
+    expected = { 512, 20, 140, 4, 10, 46, 203, 4, 657 + 640 + 46 };
+    auto sum = columns(lines[5]);
+    CHECK(sum == expected);
+
+    // without mascots only the header and an empty sum are left
+    lines = formatMemoryTable({});
+    CHECK_EQ(lines.size(), 2u);
+    expected = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    CHECK(columns(lines.back()) == expected);
+
+    const char *path = "memory_report_test.txt";
+    lines = { "heap: 1 KiB", "", "KiB" };
+    CHECK(writeMemoryReport(lines, path));
+    std::ifstream in { path };
+    std::string line;
+    std::vector<std::string> read;
+    while (std::getline(in, line)) {
+        read.push_back(line);
+    }
+    CHECK(read == lines);
+    std::filesystem::remove(path);
+    CHECK(!writeMemoryReport(lines, "memory_report_test.missing/report.txt"));
+    return testResult();
+}
@@ -0,0 +1,157 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Checks PrototypePool and benchmarks spawns that take a spare against
+// full spawns. The factory stands in for libshijima's: a spawn parses
+// the template's behavior list into a new manager, and a spare is a
+// product that was spawned on an earlier frame. Also checks that the
+// pool knows what the next refill will cost, so that it can wait for a
+// frame with that much idle time.
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include "prototype_pool.hpp"
+#include "test.hpp"
+
+struct Manager {
+    std::map<std::string, std::string> behaviors;
+    double x = 0, y = 0;
+};
+
+struct Product {
+    std::unique_ptr<Manager> manager;
+};
+
+static std::string makeTemplate(int behaviors) {
+    std::string text;
+    for (int i=0; i<behaviors; ++i) {
+        text += "<Behavior Name=\"Behavior" + std::to_string(i) +
+            "\" Frequency=\"" + std::to_string(i % 100) + "\"/>\n";
+    }
+    return text;
+}
+
+static Product spawn(std::string const& tmpl) {
+    Product product { std::make_unique<Manager>() };
+    size_t pos = 0;
+    while ((pos = tmpl.find("Name=\"", pos)) != std::string::npos) {
+        size_t nameEnd = tmpl.find('"', pos + 6);
+        size_t freq = tmpl.find('"', nameEnd + 1) + 1;
+        size_t freqEnd = tmpl.find('"', freq);
+        product.manager->behaviors[tmpl.substr(pos + 6, nameEnd - pos - 6)] =
+            tmpl.substr(freq, freqEnd - freq);
+        pos = freqEnd;
+    }
+    return product;
+}
+
+// advanced by the spawns of the first part, timed by the real clock later
+static uint64_t fakeMicros = 0;
+
+static uint64_t fakeClock() {
+    return fakeMicros;
+}
+
+static uint64_t testClock() {
+    return (uint64_t)testMicros();
+}
+
+static uint32_t elapsed(double start) {
+    return (uint32_t)(testMicros() - start);
+}
+
+int main() {
+    std::string shimeji = makeTemplate(400), other = makeTemplate(10);
+    // a spawn costs a microsecond per behavior on the fake clock
+    auto refill = [](std::string const *tmpl, size_t &bytes) {
+        bytes = tmpl->size();
+        auto product = spawn(*tmpl);
+        fakeMicros += product.manager->behaviors.size();
+        return product;
+    };
+
+    // the first spawn of a template has no spare and queues one
+    PrototypePool<std::string const *, Product> pool { fakeClock };
+    Product product;
+    size_t bytes = 0;
+    CHECK_EQ(pool.nextCost(1000), 0u);
+    CHECK(!pool.take(&shimeji, product, bytes));
+    pool.measured(&shimeji, 450);
+    CHECK(!pool.take(&other, product, bytes));
+    // other was queued last and is refilled first, it was never timed
+    CHECK_EQ(pool.nextCost(1000), 1000u);
+    CHECK(pool.refill(refill));
+    CHECK_EQ(pool.spareCount(), 1u);
+    CHECK_EQ(pool.nextCost(1000), 450u);
+    CHECK(pool.refill(refill));
+    CHECK_EQ(pool.nextCost(1000), 0u);
+    CHECK(!pool.refill(refill));
+    CHECK_EQ(pool.spareCount(), 2u);
+    CHECK_EQ(pool.refills(), 2u);
+    CHECK(pool.take(&shimeji, product, bytes));
+    CHECK(product.manager != nullptr);
+    CHECK_EQ(product.manager->behaviors.size(), 400u);
+    CHECK_EQ(bytes, shimeji.size());
+    // taken spares are built again, forgotten ones are not
+    CHECK(!pool.take(&shimeji, product, bytes));
+    // the refill measured the spawn instead
+    CHECK_EQ(pool.nextCost(1000), 400u);
+    pool.forget(&other);
+    CHECK(!pool.take(&other, product, bytes));
+    pool.forget(&other);
+    CHECK(pool.refill(refill));
+    CHECK(!pool.refill(refill));
+    CHECK_EQ(pool.spareCount(), 1u);
+
+    // One spawn per frame, as the picker does. The refill happens later
+    // in the frame and is not part of the spawn.
+    const int frames = 256;
+    SpawnLatency full, prototype;
+    std::vector<Product> spawned;
+    spawned.reserve(frames * 2);
+    for (int i=0; i<frames; ++i) {
+        double start = testMicros();
+        spawned.push_back(spawn(shimeji));
+        full.add(elapsed(start));
+    }
+    PrototypePool<std::string const *, Product> timed { testClock };
+    for (int i=0; i<frames; ++i) {
+        double start = testMicros();
+        Product product;
+        size_t bytes;
+        if (!timed.take(&shimeji, product, bytes)) {
+            product = spawn(shimeji);
+        }
+        spawned.push_back(std::move(product));
+        prototype.add(elapsed(start));
+        timed.refill(refill);
+    }
+    full.report("full");
+    prototype.report("prototype");
+    CHECK_EQ(prototype.count(), (size_t)frames);
+    // only the first spawn misses, which is below p99
+    CHECK(prototype.percentile(50) * 10 < full.percentile(50) + 10);
+    CHECK(prototype.percentile(99) * 10 < full.percentile(50) + 10);
+    for (auto &product : spawned) {
+        CHECK(product.manager != nullptr &&
+            product.manager->behaviors.size() == 400);
+    }
+    return testResult();
+}
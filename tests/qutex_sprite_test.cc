@@ -0,0 +1,123 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Draws a qutex sprite from a sheet whose texture is smaller than the
+// canvas the reader reports for it, the way MascotSpriteQutex does:
+// display lists built from QutexSprite::quad() with the size of the
+// texture, placed with drawX() and drawY(). Only the sprite's
+// rectangle of the texture may show up, mirrored within the canvas
+// when flipped, and texel() has to find the same texels for hit tests.
+
+#include <vector>
+#include "display_list.hpp"
+#include "qutex_sprite.hpp"
+#include "scene_draw.hpp"
+#include "soft_grrlib.hpp"
+#include "test.hpp"
+#include "texture_convert.hpp"
+
+static const u32 inside = 0x00FF00FF, outside = 0xFF0000FF;
+
+static u32 pixelAt(SoftRaster const& raster, int x, int y) {
+    const u8 *p = raster.pixels() + (y * raster.width() + x) * 4;
+    return (u32)p[0] << 24 | (u32)p[1] << 16 | (u32)p[2] << 8 | p[3];
+}
+
+int main() {
+    // as reported by the reader for the sheet and one of its sprites
+    const int canvasWidth = 200, canvasHeight = 300;
+    auto sprite = QutexSprite::fromReader(canvasWidth, canvasHeight,
+        40, 8, 33, 25, 9, 19);
+    const int texWidth = 128, texHeight = 64;
+    CHECK(texWidth != canvasWidth && texHeight != canvasHeight);
+
+    // the sprite's rectangle in one color, everything else in another
+    std::vector<u8> rgba(texWidth * texHeight * 4);
+    for (int y=0; y<texHeight; ++y) {
+        for (int x=0; x<texWidth; ++x) {
+            bool in = x >= sprite.x && x < sprite.x + sprite.width &&
+                y >= sprite.y && y < sprite.y + sprite.height;
+            u32 color = in ? inside : outside;
+            u8 *p = &rgba[(y * texWidth + x) * 4];
+            p[0] = color >> 24;
+            p[1] = color >> 16;
+            p[2] = color >> 8;
+            p[3] = color;
+        }
+    }
+    auto sheet = GRRLIB_CreateEmptyTexture(texWidth, texHeight);
+    tileRGBA8(rgba.data(), texWidth, texHeight, (u8 *)sheet->data);
+    GXTexObj texObj;
+    GX_InitTexObj(&texObj, sheet->data, sheet->w, sheet->h, GX_TF_RGBA8,
+        GX_CLAMP, GX_CLAMP, GX_FALSE);
+    alignas(32) u8 lists[2 * spriteQuadListSize];
+    auto quad = sprite.quad(texWidth, texHeight);
+    CHECK(writeSpriteQuad(lists, spriteQuadListSize, quad, false,
+        0xFFFFFFFF) != 0);
+    CHECK(writeSpriteQuad(lists + spriteQuadListSize, spriteQuadListSize,
+        quad, true, 0xFFFFFFFF) != 0);
+
+    SoftRaster raster { 256, 256 };
+    softBind(&raster);
+    raster.clear(0x000000FF);
+    const int flippedY = 40;
+    drawSpriteList(&texObj, lists, spriteQuadListSize, sprite.drawX(false),
+        sprite.drawY());
+    drawSpriteList(&texObj, lists + spriteQuadListSize, spriteQuadListSize,
+        sprite.drawX(true), flippedY + sprite.drawY());
+
+    // every texel of the rectangle once per draw, nothing else
+    int insideCount = 0, outsideCount = 0;
+    for (int y=0; y<raster.height(); ++y) {
+        for (int x=0; x<raster.width(); ++x) {
+            u32 color = pixelAt(raster, x, y);
+            insideCount += color == inside;
+            outsideCount += color == outside;
+        }
+    }
+    CHECK_EQ(insideCount, 2 * sprite.width * sprite.height);
+    CHECK_EQ(outsideCount, 0);
+
+    // placed by the offset, and mirrored within the canvas
+    CHECK_EQ(sprite.drawX(false), 10);
+    CHECK_EQ(sprite.drawY(), 20);
+    CHECK_EQ(sprite.drawX(true), canvasWidth - 32 - 10);
+    CHECK_EQ(pixelAt(raster, 10, 20), inside);
+    CHECK_EQ(pixelAt(raster, 10 + 31, 20 + 23), inside);
+    CHECK_EQ(pixelAt(raster, 158, flippedY + 20), inside);
+    CHECK_EQ(pixelAt(raster, 158 + 31, flippedY + 20 + 23), inside);
+
+    // hit tests read the same texels
+    SoftRaster::Texture texture { (const uint8_t *)sheet->data, texWidth,
+        texHeight };
+    int tx, ty, hits = 0;
+    for (int y=-5; y<canvasHeight; ++y) {
+        for (int x=-5; x<canvasWidth; ++x) {
+            if (sprite.texel(x, y, tx, ty)) {
+                CHECK_EQ(SoftRaster::texel(texture, tx, ty), inside);
+                ++hits;
+            }
+        }
+    }
+    CHECK_EQ(hits, sprite.width * sprite.height);
+    CHECK(sprite.texel(10, 20, tx, ty) && tx == 41 && ty == 9);
+    CHECK(!sprite.texel(9, 20, tx, ty));
+
+    GRRLIB_FreeTexture(sheet);
+    return testResult();
+}
@@ -0,0 +1,251 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Renders the console, the picker and a mascot scene with the runner's
+// own drawing code (scene_draw, TextBatch and the sprite display
+// lists) through the GRRLIB and GX shim, and compares the frames with
+// the golden PNGs in tests/golden. Run with --update to write new
+// golden images after an intended change.
+//
+// It also prints the draw calls, vertices, GX FIFO bytes, shaded and
+// blended pixels of every frame: for the console with and without its
+// cached texture and against one GRRLIB_Printf() per line, and for
+// mascot scenes of growing size.
+
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "console.hpp"
+#include "display_list.hpp"
+#include "font.hpp"
+#include "scene_draw.hpp"
+#include "soft_grrlib.hpp"
+#include "test.hpp"
+#include "text_batch.hpp"
+#include "texture_convert.hpp"
+
+static const int screenWidth = 640, screenHeight = 480;
+static bool update = false;
+
+static void report(const char *name, SoftRaster const& raster) {
+    auto &stats = softStats();
+    std::printf("%-22s %5u draws %6u vertices %7u FIFO bytes %8llu shaded "
+        "%7llu blended\n", name, stats.drawCalls, stats.vertices,
+        stats.fifoBytes,
+        (unsigned long long)raster.shadedPixels(),
+        (unsigned long long)raster.blendedPixels());
+}
+
+static void checkGolden(const char *name, SoftRaster const& raster) {
+    std::string golden = std::string(GOLDEN_DIR "/") + name + ".png";
+    if (update) {
+        CHECK(raster.writePNG(golden.c_str()));
+        return;
+    }
+    long diff = raster.compareWithPNG(golden.c_str(), 2);
+    if (diff != 0) {
+        std::string actual = std::string(name) + ".actual.png";
+        raster.writePNG(actual.c_str());
+        std::fprintf(stderr, "%s: %ld pixels differ, see %s\n", name, diff,
+            actual.c_str());
+    }
+    CHECK_EQ(diff, 0);
+}
+
+static void beginFrame(SoftRaster &raster) {
+    raster.clear(0x000000FF);
+    raster.resetStats();
+    softResetStats();
+}
+
+// Sprite sheet like a qutex one: a few opaque shapes with soft edges on
+// a transparent background
+static GRRLIB_texImg *makeSheet(int size) {
+    std::vector<u8> rgba(size * size * 4);
+    for (int y=0; y<size; ++y) {
+        for (int x=0; x<size; ++x) {
+            u8 *p = &rgba[(y * size + x) * 4];
+            int cell = (x / (size / 2)) + 2 * (y / (size / 2));
+            int cx = x % (size / 2) - size / 4, cy = y % (size / 2) - size / 4;
+            int d2 = cx * cx + cy * cy, r = size / 5;
+            p[0] = 60 + cell * 60;
+            p[1] = 255 - x * 255 / size;
+            p[2] = y * 255 / size;
+            p[3] = d2 < (r - 2) * (r - 2) ? 255 : d2 < r * r ? 128 : 0;
+        }
+    }
+    auto tex = GRRLIB_CreateEmptyTexture(size, size);
+    tileRGBA8(rgba.data(), size, size, (u8 *)tex->data);
+    return tex;
+}
+
+static GRRLIB_texImg *makeThumbnail(int size, int seed) {
+    std::vector<u8> rgba(size * size * 4);
+    for (int y=0; y<size; ++y) {
+        for (int x=0; x<size; ++x) {
+            u8 *p = &rgba[(y * size + x) * 4];
+            p[0] = (x * 4 + seed * 40) & 0xFF;
+            p[1] = (y * 4 + seed * 70) & 0xFF;
+            p[2] = ((x ^ y) * 4) & 0xFF;
+            p[3] = (x + y + seed) % 9 == 0 ? 0 : 255;
+        }
+    }
+    auto tex = GRRLIB_CreateEmptyTexture(size, size);
+    tileRGBA8(rgba.data(), size, size, (u8 *)tex->data);
+    return tex;
+}
+
+static void consoleScene(SoftRaster &raster, TextBatch &text,
+    GRRLIB_texImg *font)
+{
+    ConsoleBuffer console;
+    console.resize(20);
+    ConsoleWriter writer { console };
+    std::ostream out { &writer };
+    out << "Shijima-Wii. https://getshijima.app" << std::endl;
+    for (int i=0; i<30; ++i) {
+        out << "Loading mascot " << i << ": 46 sprites, 3 sheets" << std::endl;
+    }
+    out << std::string(100, '=') << std::endl;
+    auto cache = GRRLIB_CreateEmptyTexture(screenWidth, console.rows() * 16);
+
+    beginFrame(raster);
+    drawConsole(text, console, cache);
+    report("console, changed", raster);
+    checkGolden("console", raster);
+
+    beginFrame(raster);
+    drawConsole(text, console, cache);
+    report("console, cached", raster);
+    checkGolden("console", raster);
+
+    // what the console cost before text batching and the cache
+    beginFrame(raster);
+    {
+        std::lock_guard<ConsoleBuffer> lock { console };
+        for (int i=0; i<console.lineCount(); ++i) {
+            GRRLIB_Printf(0, 16 + (i+1)*16, font, 0xFFFFFFFF, 1, "%s",
+                console.line(i));
+        }
+    }
+    report("console, printf", raster);
+    GRRLIB_FreeTexture(cache);
+}
+
+static void pickerScene(SoftRaster &raster, TextBatch &text) {
+    const int thumbnailSize = 64, count = 23;
+    std::vector<GRRLIB_texImg *> thumbnails;
+    std::vector<std::string> names;
+    for (int i=0; i<count; ++i) {
+        thumbnails.push_back(i % 5 == 4 ? NULL :
+            makeThumbnail(thumbnailSize, i));
+        names.push_back(i == 7 ? "A mascot with a very long name" :
+            "Mascot " + std::to_string(i));
+    }
+    PickerLayout layout { screenWidth, screenHeight, thumbnailSize };
+    beginFrame(raster);
+    raster.clear(0x3060A0FF);
+    drawPicker(text, layout, screenWidth, screenHeight, count, 1, 7,
+        [&](int i) { return names[i].c_str(); },
+        [&](int i) { return thumbnails[i]; });
+    report("picker", raster);
+    checkGolden("picker", raster);
+    for (auto tex : thumbnails) {
+        GRRLIB_FreeTexture(tex);
+    }
+}
+
+// Mascots are drawn like WiiMascot::draw() does: qutex sprites from
+// their display lists, PNG sprites with GRRLIB_DrawImg(), mirrored when
+// looking right, with the boundary rectangles of the debug view.
+static void drawMascots(GRRLIB_texImg *sheet, GXTexObj *texObj,
+    const u8 *lists, int count, bool boundaries)
+{
+    for (int i=0; i<count; ++i) {
+        f32 x = (i * 97) % (screenWidth + 64) - 48;
+        f32 y = (i * 61) % (screenHeight + 32) - 32;
+        bool flip = (i % 3) == 1;
+        if (i % 4 == 3) {
+            GRRLIB_DrawImg(x, y, sheet, 0, flip ? -1 : 1, 1, 0xFFFFFFFF);
+        }
+        else {
+            drawSpriteList(texObj, lists + (flip ? spriteQuadListSize : 0),
+                spriteQuadListSize, x, y);
+        }
+        if (boundaries) {
+            GRRLIB_Rectangle(x, y, 64, 64, 0x0000FFFF, false);
+        }
+    }
+}
+
+static void mascotScene(SoftRaster &raster) {
+    const int sheetSize = 128;
+    auto sheet = makeSheet(sheetSize);
+    GXTexObj texObj;
+    GX_InitTexObj(&texObj, sheet->data, sheet->w, sheet->h, GX_TF_RGBA8,
+        GX_CLAMP, GX_CLAMP, GX_FALSE);
+    // the top right quarter of the sheet, with the qutex frame
+    // correction of MascotSpriteQutex::buildDisplayLists()
+    alignas(32) u8 lists[2 * spriteQuadListSize];
+    SpriteQuad quad { 64, 64, (64 + 0.001f) / sheetSize, 0.001f / sheetSize,
+        (128 - 0.001f) / sheetSize, (64 - 0.001f) / sheetSize };
+    CHECK(writeSpriteQuad(lists, spriteQuadListSize, quad, false,
+        0xFFFFFFFF) != 0);
+    CHECK(writeSpriteQuad(lists + spriteQuadListSize, spriteQuadListSize,
+        quad, true, 0xFFFFFFFF) != 0);
+
+    beginFrame(raster);
+    raster.clear(0x406040FF);
+    drawMascots(sheet, &texObj, lists, 12, true);
+    GRRLIB_Rectangle(300 - 1, 200 - 1, 3, 3, 0xFF0000FF, true);
+    report("mascots", raster);
+    checkGolden("mascots", raster);
+
+    // fill cost as mascots are added
+    for (int count : { 1, 10, 50, 200 }) {
+        beginFrame(raster);
+        drawMascots(sheet, &texObj, lists, count, false);
+        char name[32];
+        std::snprintf(name, sizeof(name), "%d mascots", count);
+        report(name, raster);
+    }
+    GRRLIB_FreeTexture(sheet);
+}
+
+int main(int argc, char **argv) {
+    update = argc > 1 && std::strcmp(argv[1], "--update") == 0;
+    SoftRaster raster { screenWidth, screenHeight };
+    softBind(&raster);
+    auto font = softLoadTexture(defaultFontTiles, sizeof(defaultFontTiles));
+    CHECK(font != NULL);
+    if (font == NULL) {
+        return testResult();
+    }
+    GRRLIB_InitTileSet(font, defaultFontCharWidth, defaultFontCharHeight,
+        defaultFontStart);
+    TextBatch text;
+    text.init(font, 4096);
+
+    consoleScene(raster, text, font);
+    pickerScene(raster, text);
+    mascotScene(raster);
+
+    GRRLIB_FreeTexture(font);
+    return testResult();
+}
@@ -0,0 +1,124 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Writes scene snapshots, reads them back and checks that nothing
+// changed, and that damaged files are rejected instead of producing a
+// partial scene.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "scene_snapshot.hpp"
+#include "test.hpp"
+
+static std::vector<char> readFile(std::string const& path) {
+    std::vector<char> data;
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == NULL) {
+        return data;
+    }
+    char buffer[4096];
+    size_t size;
+    while ((size = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + size);
+    }
+    std::fclose(file);
+    return data;
+}
+
+static void writeFile(std::string const& path, const char *data,
+    size_t size)
+{
+    FILE *file = std::fopen(path.c_str(), "wb");
+    std::fwrite(data, 1, size, file);
+    std::fclose(file);
+}
+
+static bool sameScene(SceneSnapshot const& a, SceneSnapshot const& b) {
+    if (a.screenWidth != b.screenWidth ||
+        a.screenHeight != b.screenHeight ||
+        a.mascots.size() != b.mascots.size())
+    {
+        return false;
+    }
+    for (size_t i=0; i<a.mascots.size(); ++i) {
+        auto &ma = a.mascots[i], &mb = b.mascots[i];
+        if (ma.name != mb.name || ma.x != mb.x || ma.y != mb.y ||
+            ma.lookingRight != mb.lookingRight)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    const std::string path = "scene_snapshot_test.snapshot";
+
+    SceneSnapshot empty;
+    empty.screenWidth = 640;
+    empty.screenHeight = 528;
+    CHECK(empty.write(path));
+    SceneSnapshot read;
+    read.mascots.push_back({ "stale", 1, 2, true });
+    CHECK(read.read(path));
+    CHECK(sameScene(empty, read));
+
+    SceneSnapshot scene;
+    scene.screenWidth = 640;
+    scene.screenHeight = 480;
+    scene.mascots.push_back({ "Shimeji", 12.5, -40.25, true });
+    scene.mascots.push_back({ "", 0, 0, false });
+    scene.mascots.push_back({ "\xe3\x81\x97\xe3\x82\x81\xe3\x81\x98",
+        -1e300, 1e-300, false });
+    scene.mascots.push_back({ std::string(300, 'x'), 639.999, 479.5,
+        true });
+    CHECK(scene.write(path));
+    SceneSnapshot again;
+    CHECK(again.read(path));
+    CHECK(sameScene(scene, again));
+
+    // every truncation and a bad magic or version must fail
+    auto data = readFile(path);
+    CHECK(!data.empty());
+    int accepted = 0;
+    for (size_t size=0; size<data.size(); ++size) {
+        writeFile(path, data.data(), size);
+        SceneSnapshot damaged;
+        accepted += damaged.read(path);
+    }
+    CHECK_EQ(accepted, 0);
+    auto bad = data;
+    bad[0] = 'X';
+    writeFile(path, bad.data(), bad.size());
+    CHECK(!again.read(path));
+    bad = data;
+    bad[4] = 2;
+    writeFile(path, bad.data(), bad.size());
+    CHECK(!again.read(path));
+
+    // a huge mascot count must not be trusted
+    bad = data;
+    bad[21] = bad[22] = bad[23] = bad[24] = (char)0xFF;
+    writeFile(path, bad.data(), bad.size());
+    CHECK(!again.read(path));
+
+    CHECK(!again.read("does/not/exist.snapshot"));
+    std::remove(path.c_str());
+    return testResult();
+}
@@ -0,0 +1,154 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Soak test of the instance slabs: a million cycles of breeding and
+// dismissing mascots whose objects are built under a SlabScope, while
+// templates of varying size are loaded and unloaded on the heap next
+// to them. The same run without slabs goes in a child process so that
+// both start from a fresh heap. Prints the heap size, the free bytes in
+// it and the slab pages at checkpoints.
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <malloc.h>
+#include <memory>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "alloc_counter.hpp"
+#include "slab_pool.hpp"
+#include "test.hpp"
+
+// stands in for the state of a libshijima manager
+struct Instance {
+    std::string behavior;
+    std::vector<int> frames;
+    std::map<int, double> variables;
+    std::vector<std::unique_ptr<std::string>> actions;
+};
+
+static unsigned nextRandom(unsigned &seed) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7FFF;
+}
+
+static Instance *spawn(unsigned &seed, bool slabs) {
+    SlabScope scope { slabs };
+    auto instance = new Instance;
+    instance->behavior = "Behavior" + std::to_string(nextRandom(seed)) +
+        std::string(nextRandom(seed) % 40, 'x');
+    instance->frames.resize(4 + nextRandom(seed) % 60);
+    for (int i=0, count=nextRandom(seed) % 8; i<count; ++i) {
+        instance->variables[i] = i;
+    }
+    for (int i=0, count=1 + nextRandom(seed) % 6; i<count; ++i) {
+        instance->actions.push_back(std::make_unique<std::string>(
+            20 + nextRandom(seed) % 100, 'a'));
+    }
+    return instance;
+}
+
+struct Checkpoint {
+    size_t heap;
+    size_t heapFree;
+    size_t pages;
+};
+
+static const int cycles = 1000000;
+static const int checkpoints = 5;
+
+// Runs the soak and writes one checkpoint per fifth of the cycles
+static void soak(bool slabs, Checkpoint *out) {
+    unsigned seed = 1234;
+    std::vector<Instance *> mascots;
+    std::vector<std::vector<char>> templates;
+    for (int cycle=1; cycle<=cycles; ++cycle) {
+        // the population wanders between 0 and 200 mascots
+        bool grow = mascots.empty() || (mascots.size() < 200 &&
+            nextRandom(seed) % 2 == 0);
+        if (grow) {
+            mascots.push_back(spawn(seed, slabs));
+        }
+        else {
+            size_t index = nextRandom(seed) % mascots.size();
+            delete mascots[index];
+            mascots[index] = mascots.back();
+            mascots.pop_back();
+        }
+        // now and then a template is loaded or unloaded
+        if (cycle % 5000 == 0) {
+            if (templates.size() < 8 || nextRandom(seed) % 2 == 0) {
+                templates.emplace_back(8 * 1024 +
+                    (nextRandom(seed) % 64) * 1024);
+            }
+            else {
+                templates.erase(templates.begin() + nextRandom(seed) %
+                    templates.size());
+            }
+        }
+        if (cycle % (cycles / checkpoints) == 0) {
+            struct mallinfo2 heap = mallinfo2();
+            *out++ = { heap.arena, heap.fordblks,
+                instanceSlabs().pagesUsed() };
+        }
+    }
+    for (auto mascot : mascots) {
+        delete mascot;
+    }
+}
+
+static void print(const char *name, Checkpoint const *points) {
+    for (int i=0; i<checkpoints; ++i) {
+        std::printf("%s, %7d cycles: heap %6zu KiB, %6zu KiB free in it, "
+            "%3zu slab pages\n", name, (i + 1) * (cycles / checkpoints),
+            points[i].heap / 1024, points[i].heapFree / 1024,
+            points[i].pages);
+    }
+}
+
+int main() {
+    CHECK(initInstanceSlabs(SlabPool::pageSize * SlabPool::maxPages));
+    Checkpoint heapOnly[checkpoints] {}, withSlabs[checkpoints] {};
+    int pipes[2];
+    CHECK(pipe(pipes) == 0);
+    pid_t child = fork();
+    if (child == 0) {
+        soak(false, heapOnly);
+        ssize_t written = write(pipes[1], heapOnly, sizeof(heapOnly));
+        _exit(written == (ssize_t)sizeof(heapOnly) ? 0 : 1);
+    }
+    CHECK(child > 0);
+    soak(true, withSlabs);
+    int status = 0;
+    CHECK(read(pipes[0], heapOnly, sizeof(heapOnly)) ==
+        (ssize_t)sizeof(heapOnly));
+    CHECK(waitpid(child, &status, 0) == child && status == 0);
+    print("heap only ", heapOnly);
+    print("with slabs", withSlabs);
+
+    // after the first checkpoint the slabs stop growing, and everything
+    // went back to them
+    CHECK_EQ(withSlabs[checkpoints - 1].pages, withSlabs[0].pages);
+    CHECK_EQ(instanceSlabs().bytesInUse(), (size_t)0);
+    CHECK_EQ(heapOnly[0].pages, (size_t)0);
+    // and the heap is no larger than without them
+    CHECK(withSlabs[checkpoints - 1].heap <= heapOnly[checkpoints - 1].heap);
+    return testResult();
+}
@@ -0,0 +1,99 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Compares SpatialGrid against the linear scan it replaced for cursor
+// hit tests: for random scenes that include rectangles partly or fully
+// off screen, the topmost rectangle under a point has to be the same,
+// and forEachNear() has to visit every rectangle in range.
+
+#include <random>
+#include <set>
+#include <vector>
+#include "spatial_grid.hpp"
+#include "test.hpp"
+
+struct Rect {
+    double x, y, width, height;
+    bool contains(double px, double py) const {
+        return px >= x && px < x + width && py >= y && py < y + height;
+    }
+};
+
+int main() {
+    std::mt19937 random { 1234 };
+    std::uniform_real_distribution<double> pos { -200, 840 };
+    std::uniform_real_distribution<double> size { 1, 200 };
+    SpatialGrid<int> grid;
+    grid.reset(640, 480, 64);
+    long queries = 0, hits = 0;
+    for (int scene=0; scene<200; ++scene) {
+        std::vector<Rect> rects;
+        int count = 1 + scene % 100;
+        grid.clear();
+        for (int i=0; i<count; ++i) {
+            Rect rect { pos(random), pos(random) * 0.75, size(random),
+                size(random) };
+            rects.push_back(rect);
+            grid.insert(i, rect.x, rect.y, rect.width, rect.height);
+        }
+        // dismissing a mascot removes it from the grid and the list
+        if (count > 2) {
+            int removed = scene % count;
+            grid.remove(removed);
+            rects[removed] = { 1e9, 1e9, 0, 0 };
+        }
+        for (int q=0; q<500; ++q) {
+            double x = pos(random), y = pos(random) * 0.75;
+            int expected = -1;
+            for (int i=count-1; i>=0; --i) {
+                if (rects[i].contains(x, y)) {
+                    expected = i;
+                    break;
+                }
+            }
+            int found = -1;
+            grid.findAt(x, y, [&](int i) {
+                if (rects[i].contains(x, y)) {
+                    found = i;
+                    return true;
+                }
+                return false;
+            });
+            CHECK_EQ(found, expected);
+            ++queries;
+            hits += (found != -1);
+
+            double radius = 50;
+            std::set<int> near;
+            grid.forEachNear(x, y, radius, [&](int i) {
+                near.insert(i);
+            });
+            for (int i=0; i<count; ++i) {
+                auto &r = rects[i];
+                bool inRange = x + radius >= r.x &&
+                    x - radius < r.x + r.width &&
+                    y + radius >= r.y && y - radius < r.y + r.height;
+                if (inRange) {
+                    CHECK(near.count(i) == 1);
+                }
+            }
+        }
+    }
+    std::printf("%ld queries, %ld hits\n", queries, hits);
+    return testResult();
+}
@@ -0,0 +1,63 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+#pragma once
+#include <chrono>
+#include <cstdio>
+
+// Checks for the host tests. A failed CHECK() prints where it failed
+// and the test keeps going, so one run reports every failure;
+// testResult() turns the count into the exit status.
+
+static int testFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, \
+                __LINE__, #cond); \
+            ++testFailures; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        auto checkA = (a); \
+        auto checkB = (b); \
+        if (!(checkA == checkB)) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s == %s " \
+                "(%lld != %lld)\n", __FILE__, __LINE__, #a, #b, \
+                (long long)checkA, (long long)checkB); \
+            ++testFailures; \
+        } \
+    } while (0)
+
+static inline int testResult() {
+    if (testFailures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", testFailures);
+        return 1;
+    }
+    return 0;
+}
+
+// Wall clock for the measurements the tests print
+static inline double testMicros() {
+    using namespace std::chrono;
+    return duration<double, std::micro>(
+        steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,83 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// Prints a few lines through TextBatch with the GRRLIB and GX shim in
+// tests/host and checks that they come out as one draw call with a
+// quad per glyph, pixel for pixel like one GRRLIB_Printf() per line,
+// and that a full batch is flushed before it takes more glyphs.
+
+#include <cstring>
+#include "font.hpp"
+#include "soft_grrlib.hpp"
+#include "test.hpp"
+#include "text_batch.hpp"
+
+static const char *lines[] = {
+    "Shijima-Wii", "Loaded 12 mascots in 1.25 s", "[+] Spawn  [-] Debug"
+};
+
+int main() {
+    SoftRaster batched { 320, 64 }, printed { 320, 64 };
+    auto font = softLoadTexture(defaultFontTiles, sizeof(defaultFontTiles));
+    CHECK(font != NULL);
+    if (font == NULL) {
+        return testResult();
+    }
+    GRRLIB_InitTileSet(font, defaultFontCharWidth, defaultFontCharHeight,
+        defaultFontStart);
+
+    TextBatch text;
+    text.init(font, 4096);
+    unsigned glyphs = 0;
+    batched.clear(0x000000FF);
+    softBind(&batched);
+    softResetStats();
+    for (int i=0; i<3; ++i) {
+        text.print(4, 4 + i * 18, 0xFFFFFFFF, "%s", lines[i]);
+        glyphs += std::strlen(lines[i]);
+    }
+    text.flush();
+    CHECK_EQ(softStats().drawCalls, 1u);
+    CHECK_EQ(softStats().vertices, 4 * glyphs);
+    CHECK_EQ(text.glyphCount(), glyphs);
+    CHECK_EQ(text.drawCount(), 1u);
+
+    printed.clear(0x000000FF);
+    softBind(&printed);
+    softResetStats();
+    for (int i=0; i<3; ++i) {
+        GRRLIB_Printf(4, 4 + i * 18, font, 0xFFFFFFFF, 1, "%s", lines[i]);
+    }
+    CHECK_EQ(softStats().drawCalls, glyphs);
+    CHECK(std::memcmp(batched.pixels(), printed.pixels(),
+        320 * 64 * 4) == 0);
+
+    // a batch that is full is flushed before it takes more glyphs
+    softBind(NULL);
+    softResetStats();
+    TextBatch small;
+    small.init(font, 3);
+    small.print(0, 0, 0xFFFFFFFF, "ABCDEFG");
+    CHECK_EQ(softStats().drawCalls, 2u);
+    small.flush();
+    CHECK_EQ(softStats().drawCalls, 3u);
+    CHECK_EQ(softStats().vertices, 28u);
+    CHECK_EQ(small.drawCount(), 3u);
+
+    GRRLIB_FreeTexture(font);
+    return testResult();
+}
@@ -0,0 +1,208 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Headless run of TextureCache: mascots play random actions made of a
+// few sheets each, and every frame draws them and then gives the cache
+// a few idle slices. Prints the hit rate, the peak and where the misses
+// were decoded for a few budgets, with and without the prediction, and
+// checks that draws only decode after maxWaitFrames.
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "test.hpp"
+#include "texture_cache.hpp"
+
+static bool drawing = false;
+static unsigned drawDecodes = 0;
+
+struct FakeSlot {
+    size_t bytes = 0;
+    bool loaded = false;
+    TextureCacheLinks<FakeSlot> m_links;
+    bool resident() const {
+        return loaded;
+    }
+    bool failed() const {
+        return false;
+    }
+    size_t decodedBytes() const {
+        return loaded ? bytes : 0;
+    }
+    size_t expectedBytes() const {
+        return bytes;
+    }
+    bool load() {
+        if (!loaded) {
+            loaded = true;
+            drawDecodes += drawing;
+        }
+        return true;
+    }
+    void unload() {
+        loaded = false;
+    }
+};
+
+static unsigned nextRandom(unsigned &seed) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7FFF;
+}
+
+// One kind of mascot: actions of 2 to 4 sheets, and after each action
+// one of two likely actions follows
+struct Kind {
+    std::vector<std::unique_ptr<FakeSlot>> sheets;
+    std::vector<std::vector<FakeSlot *>> actions;
+    std::vector<int> likely[2];
+};
+
+struct Mascot {
+    Kind *kind;
+    int action;
+    int frame;
+    FakeSlot *last;
+    // drawn this frame, or the previous frame again
+    bool fresh;
+};
+
+struct Result {
+    unsigned hitRate;
+    size_t peak;
+    uint64_t misses, idleDecodes, lateDecodes, evictions;
+    unsigned staleFrames;
+    size_t maxFrameBytes;
+};
+
+static const int kindCount = 4;
+static const int actionCount = 8;
+static const int mascotCount = 12;
+static const int frames = 20000;
+static const int ticksPerFrame = 6;
+static const int idleSlices = 2;
+
+static std::vector<Kind> makeKinds(unsigned seed, size_t &total) {
+    std::vector<Kind> kinds(kindCount);
+    total = 0;
+    for (auto &kind : kinds) {
+        for (int a=0; a<actionCount; ++a) {
+            std::vector<FakeSlot *> action;
+            for (int i=0, count=2 + nextRandom(seed) % 3; i<count; ++i) {
+                kind.sheets.push_back(std::make_unique<FakeSlot>());
+                kind.sheets.back()->bytes = (128 + nextRandom(seed) % 256) *
+                    1024;
+                total += kind.sheets.back()->bytes;
+                action.push_back(kind.sheets.back().get());
+            }
+            kind.actions.push_back(action);
+            kind.likely[0].push_back(nextRandom(seed) % actionCount);
+            kind.likely[1].push_back(nextRandom(seed) % actionCount);
+        }
+    }
+    return kinds;
+}
+
+static Result run(size_t budget, bool predict) {
+    size_t total;
+    auto kinds = makeKinds(7, total);
+    TextureCache<FakeSlot> cache { budget };
+    unsigned seed = 99;
+    std::vector<Mascot> mascots;
+    for (int i=0; i<mascotCount; ++i) {
+        mascots.push_back({ &kinds[i % kindCount], (int)(nextRandom(seed) %
+            actionCount), 0, nullptr, false });
+    }
+    Result result {};
+    drawDecodes = 0;
+    for (int f=0; f<frames; ++f) {
+        cache.beginFrame();
+        drawing = true;
+        size_t frameBytes = 0;
+        for (auto &mascot : mascots) {
+            // a sheet lasts ticksPerFrame frames, an action 80% of the
+            // time goes to its most likely successor
+            if (f % ticksPerFrame == 0) {
+                auto &action = mascot.kind->actions[mascot.action];
+                if (++mascot.frame >= (int)action.size()) {
+                    unsigned roll = nextRandom(seed) % 10;
+                    mascot.action = roll < 8 ?
+                        mascot.kind->likely[0][mascot.action] : roll < 9 ?
+                        mascot.kind->likely[1][mascot.action] :
+                        nextRandom(seed) % actionCount;
+                    mascot.frame = 0;
+                }
+            }
+            auto slot = mascot.kind->actions[mascot.action][mascot.frame];
+            if (predict && mascot.last != nullptr && mascot.last != slot) {
+                cache.follow(mascot.last, slot);
+            }
+            mascot.last = slot;
+            mascot.fresh = cache.draw(slot);
+            result.staleFrames += !mascot.fresh;
+            frameBytes += slot->bytes;
+        }
+        result.maxFrameBytes = std::max(result.maxFrameBytes, frameBytes);
+        drawing = false;
+        for (int i=0; i<idleSlices && cache.prefetch(); ++i) {
+        }
+    }
+    // misses of the last frames still wait
+    while (cache.prefetch()) {
+    }
+    result.hitRate = cache.hitRate();
+    result.peak = cache.peakBytes();
+    result.misses = cache.misses();
+    result.idleDecodes = cache.idleDecodes();
+    result.lateDecodes = cache.lateDecodes();
+    result.evictions = cache.evictions();
+    CHECK_EQ(drawDecodes, cache.lateDecodes());
+    CHECK_EQ(cache.misses(), cache.idleDecodes() + cache.lateDecodes());
+    return result;
+}
+
+int main() {
+    size_t total;
+    makeKinds(7, total);
+    std::printf("%d mascots, %zu KiB of sheets\n", mascotCount, total / 1024);
+    size_t budgets[] = { 0, total / 2, total / 4 };
+    for (size_t budget : budgets) {
+        Result results[2];
+        for (int predict=0; predict<2; ++predict) {
+            auto &r = results[predict] = run(budget, predict);
+            std::printf("budget %5zu KiB, %-13s hit rate %u.%u%%, peak %5zu "
+                "KiB, %5llu misses (%llu in idle time, %llu by a draw), "
+                "%llu evicted, %u stale draws\n", budget / 1024,
+                predict ? "prediction:" : "no prediction:", r.hitRate / 10,
+                r.hitRate % 10, r.peak / 1024, (unsigned long long)r.misses,
+                (unsigned long long)r.idleDecodes,
+                (unsigned long long)r.lateDecodes,
+                (unsigned long long)r.evictions, r.staleFrames);
+            if (budget != 0) {
+                CHECK(r.peak <= budget + r.maxFrameBytes);
+            }
+        }
+        if (budget == 0) {
+            // only the first draw of each sheet misses
+            CHECK(results[1].hitRate >= 995);
+            continue;
+        }
+        CHECK(results[1].hitRate > results[0].hitRate);
+        CHECK(results[1].staleFrames < results[0].staleFrames);
+    }
+    return testResult();
+}
@@ -0,0 +1,112 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Fuzzes the texture conversion kernel against the scalar reference
+// with random images, sizes and alpha patterns, and prints the
+// throughput of both.
+
+#include <random>
+#include <vector>
+#include "test.hpp"
+#include "texture_convert.hpp"
+
+static void randomImage(std::mt19937 &random, std::vector<uint8_t> &rgba) {
+    // a third of the bytes zero, so alpha is often fully transparent
+    for (auto &byte : rgba) {
+        byte = random() % 3 == 0 ? 0 : (uint8_t)random();
+    }
+}
+
+static void benchmark(const char *name, void (*convert)(const uint8_t *,
+    int, int, uint8_t *), std::vector<uint8_t> const& rgba, int size,
+    std::vector<uint8_t> &out)
+{
+    const int runs = 20;
+    double start = testMicros();
+    for (int i=0; i<runs; ++i) {
+        convert(rgba.data(), size, size, out.data());
+    }
+    double micros = testMicros() - start;
+    std::printf("%-12s %8.0f MB/s\n", name,
+        runs * rgba.size() / micros);
+}
+
+int main() {
+    std::printf("kernel: %s\n", textureConvertKernel());
+    std::mt19937 random { 42 };
+    for (int iter=0; iter<500; ++iter) {
+        int width = (random() % 64 + 1) * 4;
+        int height = (random() % 64 + 1) * 4;
+        std::vector<uint8_t> rgba(width * height * 4);
+        randomImage(random, rgba);
+        std::vector<uint8_t> expected(rgba.size(), 0xAA);
+        std::vector<uint8_t> tiles(rgba.size(), 0x55);
+        tileRGBA8Scalar(rgba.data(), width, height, expected.data());
+        tileRGBA8(rgba.data(), width, height, tiles.data());
+        CHECK(tiles == expected);
+
+        // masks take any size
+        width = random() % 200 + 1;
+        height = random() % 50 + 1;
+        rgba.resize(width * height * 4);
+        randomImage(random, rgba);
+        std::vector<uint8_t> expectedMask(alphaMaskSize(width, height), 0xAA);
+        std::vector<uint8_t> mask(expectedMask.size(), 0x55);
+        buildAlphaMaskScalar(rgba.data(), width, height, expectedMask.data());
+        buildAlphaMask(rgba.data(), width, height, mask.data());
+        CHECK(mask == expectedMask);
+        int wrong = 0;
+        for (int y=0; y<height; ++y) {
+            for (int x=0; x<width; ++x) {
+                bool opaque = rgba[(y * width + x) * 4 + 3] != 0;
+                wrong += alphaMaskAt(mask.data(), width, x, y) != opaque;
+            }
+        }
+        CHECK_EQ(wrong, 0);
+        if (testFailures != 0) {
+            std::fprintf(stderr, "failed at %dx%d\n", width, height);
+            return testResult();
+        }
+    }
+
+    // a 4x4 tile by hand: AR pairs, then GB pairs
+    uint8_t pixel[4 * 4 * 4];
+    for (int i=0; i<16; ++i) {
+        pixel[i * 4] = 0x10 + i;
+        pixel[i * 4 + 1] = 0x20 + i;
+        pixel[i * 4 + 2] = 0x30 + i;
+        pixel[i * 4 + 3] = 0x40 + i;
+    }
+    uint8_t tile[64];
+    tileRGBA8(pixel, 4, 4, tile);
+    CHECK_EQ(tile[0], 0x40);
+    CHECK_EQ(tile[1], 0x10);
+    CHECK_EQ(tile[30], 0x4F);
+    CHECK_EQ(tile[32], 0x20);
+    CHECK_EQ(tile[33], 0x30);
+    CHECK_EQ(tile[63], 0x3F);
+
+    const int size = 512;
+    std::vector<uint8_t> rgba(size * size * 4), out(rgba.size());
+    randomImage(random, rgba);
+    benchmark("tile scalar", tileRGBA8Scalar, rgba, size, out);
+    benchmark("tile kernel", tileRGBA8, rgba, size, out);
+    benchmark("mask scalar", buildAlphaMaskScalar, rgba, size, out);
+    benchmark("mask kernel", buildAlphaMask, rgba, size, out);
+    return testResult();
+}
@@ -0,0 +1,296 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Renders thumbnails of sprite regions, then runs ThumbnailCache
+// through picker frames against the GRRLIB shim: a missing thumbnail
+// is rendered on the thread and written back, a new cache reads that
+// file instead of rendering it again, a source without an image isn't
+// asked for again, and forgetting a source drops its job.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "stb_image.h"
+#include "stb_image_write.h"
+#include "test.hpp"
+#include "texture_convert.hpp"
+#include "thumbnail_cache.hpp"
+
+namespace fs = std::filesystem;
+
+static uint64_t now = 1000;
+
+static uint64_t fakeClock() {
+    return now;
+}
+
+static std::ostream &log() {
+    return std::cerr;
+}
+
+static uint32_t pixelAt(const uint8_t *rgba, int width, int x, int y) {
+    const uint8_t *p = &rgba[(y * width + x) * 4];
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+        (uint32_t)p[2] << 8 | p[3];
+}
+
+static std::vector<uint8_t> image(int width, int height, uint32_t color) {
+    std::vector<uint8_t> rgba(width * height * 4);
+    for (size_t i=0; i<rgba.size(); i+=4) {
+        rgba[i] = color >> 24;
+        rgba[i + 1] = color >> 16;
+        rgba[i + 2] = color >> 8;
+        rgba[i + 3] = color;
+    }
+    return rgba;
+}
+
+static void appendBytes(void *context, void *data, int size) {
+    auto bytes = (std::vector<uint8_t> *)context;
+    bytes->insert(bytes->end(), (uint8_t *)data, (uint8_t *)data + size);
+}
+
+static std::vector<uint8_t> encode(std::vector<uint8_t> const& rgba,
+    int width, int height)
+{
+    std::vector<uint8_t> file;
+    stbi_write_png_to_func(appendBytes, &file, width, height, 4, &rgba[0],
+        width * 4);
+    return file;
+}
+
+struct Source : ThumbnailSource {
+    std::string path;
+    std::vector<uint8_t> file;
+    SpriteRegion region;
+    mutable int imageCalls = 0;
+    virtual std::string thumbnailPath() const {
+        return path;
+    }
+    virtual bool thumbnailImage(const uint8_t *&data, size_t &size,
+        SpriteRegion &spriteRegion) const
+    {
+        ++imageCalls;
+        if (file.empty()) {
+            return false;
+        }
+        data = &file[0];
+        size = file.size();
+        spriteRegion = region;
+        return true;
+    }
+};
+
+static void checkRendering() {
+    std::vector<uint8_t> thumb(thumbnailSize * thumbnailSize * 4);
+
+    // twice the size, left half red and right half blue
+    auto rgba = image(128, 128, 0xFF0000FF);
+    for (int y=0; y<128; ++y) {
+        for (int x=64; x<128; ++x) {
+            rgba[(y * 128 + x) * 4] = 0;
+            rgba[(y * 128 + x) * 4 + 2] = 0xFF;
+        }
+    }
+    CHECK(renderThumbnail(&rgba[0], 128, 128,
+        { 128, 128, 0, 0, 128, 128, 0, 0 }, &thumb[0]));
+    CHECK_EQ(pixelAt(&thumb[0], thumbnailSize, 0, 0), 0xFF0000FFu);
+    CHECK_EQ(pixelAt(&thumb[0], thumbnailSize, 63, 63), 0x0000FFFFu);
+
+    // one opaque white pixel in every 2x2 block: transparent black
+    // doesn't darken it
+    rgba = image(128, 128, 0x00000000);
+    for (int y=0; y<128; y+=2) {
+        for (int x=0; x<128; x+=2) {
+            std::memset(&rgba[(y * 128 + x) * 4], 0xFF, 4);
+        }
+    }
+    std::fill(thumb.begin(), thumb.end(), 0);
+    CHECK(renderThumbnail(&rgba[0], 128, 128,
+        { 128, 128, 0, 0, 128, 128, 0, 0 }, &thumb[0]));
+    CHECK_EQ(pixelAt(&thumb[0], thumbnailSize, 10, 10), 0xFFFFFF3Fu);
+
+    // A 40x20 sprite that shows the 16x8 rectangle at 8,8 of a green
+    // image at 4,6. It is centered at 12,22 without scaling.
+    rgba = image(32, 32, 0x00FF00FF);
+    SpriteRegion region { 40, 20, 8, 8, 16, 8, 4, 6 };
+    std::fill(thumb.begin(), thumb.end(), 0);
+    CHECK(renderThumbnail(&rgba[0], 32, 32, region, &thumb[0]));
+    int opaque = 0;
+    for (int y=0; y<thumbnailSize; ++y) {
+        for (int x=0; x<thumbnailSize; ++x) {
+            uint32_t color = pixelAt(&thumb[0], thumbnailSize, x, y);
+            bool inside = x >= 16 && x < 32 && y >= 28 && y < 36;
+            CHECK_EQ(color, inside ? 0x00FF00FFu : 0u);
+            opaque += color != 0;
+        }
+    }
+    CHECK_EQ(opaque, 16 * 8);
+
+    // a rectangle that reaches past the image only shows what is on it
+    region = { 40, 20, 24, 8, 16, 8, 4, 6 };
+    std::fill(thumb.begin(), thumb.end(), 0);
+    CHECK(renderThumbnail(&rgba[0], 32, 32, region, &thumb[0]));
+    CHECK_EQ(pixelAt(&thumb[0], thumbnailSize, 16 + 7, 28), 0x00FF00FFu);
+    CHECK_EQ(pixelAt(&thumb[0], thumbnailSize, 16 + 8, 28), 0u);
+
+    CHECK(!renderThumbnail(&rgba[0], 32, 32, { 0, 20, 0, 0, 0, 0, 0, 0 },
+        &thumb[0]));
+}
+
+// One picker frame that shows sources. Returns how many of them have a
+// texture.
+static int frame(ThumbnailCache &cache, std::vector<Source *> const& sources,
+    size_t *renderBytes = NULL)
+{
+    now += 16683;
+    cache.beginFrame();
+    int textures = 0;
+    for (auto source : sources) {
+        textures += cache.get(source) != NULL;
+    }
+    do {
+        if (renderBytes != NULL && cache.nextRenderBytes() != 0) {
+            *renderBytes = cache.nextRenderBytes();
+        }
+    } while (cache.loadPending());
+    cache.endFrame();
+    return textures;
+}
+
+// Frames until count of sources have a texture, at most 5 s
+static bool waitFor(ThumbnailCache &cache, std::vector<Source *> const& sources,
+    int count, size_t *renderBytes = NULL)
+{
+    for (int i=0; i<5000; ++i) {
+        if (frame(cache, sources, renderBytes) == count) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+static std::vector<uint8_t> readThumbnail(std::string const& path) {
+    int width = 0, height = 0, comp;
+    uint8_t *rgba = stbi_load(path.c_str(), &width, &height, &comp, 4);
+    CHECK(rgba != NULL);
+    CHECK_EQ(width, thumbnailSize);
+    CHECK_EQ(height, thumbnailSize);
+    std::vector<uint8_t> pixels;
+    if (rgba != NULL) {
+        pixels.assign(rgba, rgba + width * height * 4);
+    }
+    stbi_image_free(rgba);
+    return pixels;
+}
+
+int main() {
+    checkRendering();
+
+    fs::path dir = fs::absolute("thumbnail_cache_test.thumbs");
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    // a red sprite of 128x64 with no thumbnail file yet, and one
+    // without an image
+    Source red, empty;
+    red.path = (dir / "red.png").string();
+    red.file = encode(image(128, 64, 0xFF0000FF), 128, 64);
+    red.region = { 128, 64, 0, 0, 128, 64, 0, 0 };
+    empty.path = (dir / "empty.png").string();
+    std::vector<uint8_t> redTiles(thumbnailSize * thumbnailSize * 4);
+    {
+        ThumbnailCache cache { fakeClock, log };
+        std::vector<Source *> visible { &red, &empty };
+        size_t renderBytes = 0;
+        CHECK(waitFor(cache, visible, 1, &renderBytes));
+        CHECK_EQ(renderBytes, red.file.size());
+        // rendered and written back, a band of 64x32 in the middle
+        auto pixels = readThumbnail(red.path);
+        if (!pixels.empty()) {
+            CHECK_EQ(pixelAt(&pixels[0], thumbnailSize, 0, 16), 0xFF0000FFu);
+            CHECK_EQ(pixelAt(&pixels[0], thumbnailSize, 63, 47),
+                0xFF0000FFu);
+            CHECK_EQ(pixelAt(&pixels[0], thumbnailSize, 0, 15), 0u);
+            CHECK_EQ(pixelAt(&pixels[0], thumbnailSize, 0, 48), 0u);
+            tileRGBA8(&pixels[0], thumbnailSize, thumbnailSize,
+                &redTiles[0]);
+            auto texture = cache.get(&red);
+            CHECK(texture != NULL && std::memcmp(texture->data,
+                &redTiles[0], redTiles.size()) == 0);
+        }
+        // the failed one is kept without a texture and not retried
+        CHECK(!fs::exists(empty.path));
+        int calls = empty.imageCalls;
+        for (int i=0; i<20; ++i) {
+            CHECK_EQ(frame(cache, visible), 1);
+        }
+        CHECK_EQ(empty.imageCalls, calls);
+        CHECK_EQ(cache.residentCount(), 2u);
+        // hiding them frees them
+        frame(cache, {});
+        CHECK_EQ(cache.residentCount(), 0u);
+    }
+
+    // A new cache reads the file: the sprite is blue now, which a render
+    // would show. The time to the first complete frame is measured from
+    // opened().
+    red.file = encode(image(128, 64, 0x0000FFFF), 128, 64);
+    red.imageCalls = 0;
+    {
+        ThumbnailCache cache { fakeClock, log };
+        cache.opened();
+        uint64_t openedAt = now;
+        CHECK(waitFor(cache, { &red }, 1));
+        CHECK_EQ(red.imageCalls, 0);
+        CHECK(std::memcmp(cache.get(&red)->data, &redTiles[0],
+            redTiles.size()) == 0);
+        CHECK(cache.readyMicros() >= 16683);
+        CHECK(cache.readyMicros() <= now - openedAt);
+    }
+
+    // a source forgotten while its thumbnail is rendered
+    {
+        ThumbnailCache cache { fakeClock, log };
+        auto gone = new Source;
+        gone->path = (dir / "gone.png").string();
+        gone->file = red.file;
+        gone->region = red.region;
+        for (int i=0; i<5000 && gone->imageCalls == 0; ++i) {
+            frame(cache, { gone });
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(gone->imageCalls > 0);
+        cache.forget(gone);
+        delete gone;
+        for (int i=0; i<100; ++i) {
+            frame(cache, {});
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK_EQ(cache.residentCount(), 0u);
+    }
+
+    fs::remove_all(dir);
+    return testResult();
+}
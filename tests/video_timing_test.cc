@@ -0,0 +1,74 @@
+// 
+// Shijima-Wii - Shimeji desktop pet runner for Nintendo Wii
+// Copyright (C) 2025 pixelomer
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+// 
+
+// Runs each video mode for ten seconds of frames and checks that the
+// mascots tick 50 times per second in all of them, and that the frame
+// period matches the refresh rate of the mode. PAL used to skip ticks
+// like NTSC, see video_timing.hpp.
+
+#include <cstdio>
+#include "video_timing.hpp"
+#include "test.hpp"
+
+// video formats of gccore.h
+enum { NTSC = 0, PAL = 1, MPAL = 2, EURGB60 = 5 };
+// scan modes
+enum { INTERLACE = 0, NON_INTERLACE = 1, PROGRESSIVE = 2 };
+
+static uint32_t tvMode(int format, int scan) {
+    return (format << 2) | scan;
+}
+
+struct Mode {
+    const char *name;
+    uint32_t viTVMode;
+    int hertz;
+};
+
+int main() {
+    const Mode modes[] = {
+        { "NTSC interlaced", tvMode(NTSC, INTERLACE), 60 },
+        { "NTSC progressive", tvMode(NTSC, PROGRESSIVE), 60 },
+        { "PAL interlaced", tvMode(PAL, INTERLACE), 50 },
+        { "PAL non-interlaced", tvMode(PAL, NON_INTERLACE), 50 },
+        { "MPAL interlaced", tvMode(MPAL, INTERLACE), 60 },
+        { "EURGB60 interlaced", tvMode(EURGB60, INTERLACE), 60 },
+        { "EURGB60 progressive", tvMode(EURGB60, PROGRESSIVE), 60 },
+    };
+    for (auto const& mode : modes) {
+        CHECK_EQ(fiftyHertz(mode.viTVMode), mode.hertz == 50);
+        CHECK_EQ(framePeriodMicros(mode.viTVMode),
+            mode.hertz == 50 ? 20000u : 16683u);
+        int ticks = 0;
+        uint8_t phase = 0;
+        for (int frame=0; frame<mode.hertz * 10; ++frame) {
+            if (ticksAtPhase(phase)) {
+                ++ticks;
+            }
+            phase = nextTickPhase(mode.viTVMode, phase);
+        }
+        printf("%-20s %d Hz: %d ticks in 10 s\n", mode.name, mode.hertz,
+            ticks);
+        CHECK_EQ(ticks, 500);
+    }
+    // a replay of a 60 Hz recording can start at any phase
+    for (uint8_t phase=0; phase<6; ++phase) {
+        CHECK_EQ(nextTickPhase(tvMode(PAL, INTERLACE), phase), 0);
+    }
+    return testResult();
+}